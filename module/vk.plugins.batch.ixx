@@ -0,0 +1,147 @@
+module;
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.batch;
+import vk.context;
+import vk.plugins.buffer;
+import vk.plugins.descriptor;
+import vk.plugins.device;
+import vk.plugins.pipeline_builder;
+
+namespace vk::plugins {
+    // Bytes per frame slot in the batch indirect buffer: one VkDrawIndexedIndirectCommand, then the draw count.
+    export constexpr VkDeviceSize kBatchIndirectStride = 32;
+
+    // std430 layout of one instance as read by viewport_batch.vert.
+    export struct InstanceData {
+        float position[3];
+        float scale;
+        float color[4];
+    };
+
+    export struct BatchStats {
+        std::uint32_t instances{0};
+        std::uint32_t draw_calls{0};
+        std::uint64_t bytes_uploaded{0};
+        std::chrono::nanoseconds cpu_record_time{0};
+    };
+
+    // GPU-driven instanced quads. Instance data lives in a persistently mapped storage buffer with one region per
+    // frame in flight; a region is only rewritten when the scene changed, and each frame issues one
+    // vkCmdDrawIndexedIndirectCount, so recording cost does not depend on the instance count.
+    export class BatchRenderer {
+    public:
+        // Without DeviceFeatures::draw_indirect_count the batch falls back to vkCmdDrawIndexedIndirect.
+        // The set layout and per-slot sets come from `descriptors`, which must outlive the batch.
+        void initialize(const context::EngineContext& eng, VkFormat color_format, PipelineBuildScheduler& builds, const DeviceFeatures& features, DescriptorAllocator& descriptors);
+        void destroy(const context::EngineContext& eng);
+        // Before initialize: the queue families that access the instance, visible and indirect buffers. A culling pass
+        // on a separate compute queue needs its family here so the buffers are shared without ownership transfers.
+        void set_queue_families(std::vector<std::uint32_t> families) {
+            m_queue_families = std::move(families);
+        }
+
+        void set_instances(std::span<const InstanceData> instances);
+        void set_view_projection(const std::array<float, 16>& view_proj);
+        void populate_benchmark_scene(std::uint32_t count);
+        // Steps through the given instance counts, printing draw calls and CPU record time for each.
+        void start_benchmark(std::vector<std::uint32_t> steps = {1'000, 100'000, 1'000'000}, std::uint32_t frames_per_step = 240);
+        [[nodiscard]] bool benchmark_running() const {
+            return m_benchmark.step < m_benchmark.steps.size();
+        }
+
+        // Outside rendering: uploads the scene into this frame's region if it is stale.
+        void prepare(const context::EngineContext& eng, std::uint32_t frame_slot);
+        // Inside rendering.
+        void record(VkCommandBuffer cmd, VkExtent2D extent, std::uint32_t frame_slot);
+        // Swaps in a pipeline that finished building; record() does this itself, record_view() callers do it first.
+        void poll_pipeline();
+        // Inside rendering, safe to call from several threads at once. The `primary` view draws through this frame's
+        // indirect record (and visible list), which a culling pass only fills for set_view_projection's camera; other
+        // views draw every instance directly and leave the rest to clipping.
+        void record_view(VkCommandBuffer cmd, VkRect2D area, const std::array<float, 16>& view_proj, std::uint32_t frame_slot, bool primary) const;
+        // After the frame's record_view calls, on the recording thread: updates stats() and the benchmark with the
+        // number of views drawn and the time spent recording them.
+        void finish_views(std::uint32_t views, std::chrono::nanoseconds record_time);
+
+        // When set, the vertex shader reads instances through the compacted visible-index list a culling pass wrote.
+        void set_use_visible_list(bool enabled) {
+            m_use_visible_list = enabled;
+        }
+
+        [[nodiscard]] const BatchStats& stats() const {
+            return m_stats;
+        }
+        [[nodiscard]] std::span<const InstanceData> scene() const {
+            return m_scene;
+        }
+        [[nodiscard]] const std::array<float, 16>& view_projection() const {
+            return m_view_proj;
+        }
+        [[nodiscard]] std::uint64_t buffer_generation() const {
+            return m_buffer_generation;
+        }
+        [[nodiscard]] VkDescriptorBufferInfo instance_region(std::uint32_t frame_slot) const {
+            return {m_instances.buffer, frame_slot * m_region_size, m_region_size};
+        }
+        [[nodiscard]] VkDescriptorBufferInfo visible_region(std::uint32_t frame_slot) const {
+            return {m_visible.buffer, frame_slot * m_visible_region_size, m_visible_region_size};
+        }
+        [[nodiscard]] VkBuffer indirect_buffer() const {
+            return m_indirect.buffer;
+        }
+        [[nodiscard]] VkDeviceSize indirect_offset(std::uint32_t frame_slot) const;
+
+    private:
+        void ensure_capacity(const context::EngineContext& eng, std::uint32_t count);
+        void advance_benchmark();
+
+        struct Retired {
+            GpuBuffer buffer;
+            std::uint64_t release_frame;
+        };
+
+        VkDescriptorSetLayout m_set_layout{VK_NULL_HANDLE};
+        std::array<VkDescriptorSet, context::FRAME_OVERLAP> m_sets{};
+        VkPipelineLayout m_layout{VK_NULL_HANDLE};
+        VkPipeline m_pipeline{VK_NULL_HANDLE};
+        PipelineBuildTicket m_pending_pipeline{};
+        std::uint64_t m_vert_shader{0};
+        std::uint64_t m_frag_shader{0};
+        bool m_indirect_count{false};
+        std::vector<std::uint32_t> m_queue_families{};
+
+        GpuBuffer m_instances{};
+        GpuBuffer m_visible{};
+        GpuBuffer m_indirect{};
+        GpuBuffer m_indices{};
+        VkDeviceSize m_region_size{0};
+        VkDeviceSize m_visible_region_size{0};
+        bool m_use_visible_list{false};
+        std::uint32_t m_capacity{0};
+        std::uint64_t m_generation{0};
+        std::array<std::uint64_t, context::FRAME_OVERLAP> m_slot_generation{};
+        std::array<std::uint64_t, context::FRAME_OVERLAP> m_slot_buffer_generation{};
+        std::uint64_t m_buffer_generation{0};
+        std::vector<Retired> m_retired{};
+        std::uint64_t m_frame{0};
+
+        std::vector<InstanceData> m_scene{};
+        std::array<float, 16> m_view_proj{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        BatchStats m_stats{};
+
+        struct {
+            std::vector<std::uint32_t> steps{};
+            std::size_t step{0};
+            std::uint32_t frames_per_step{0};
+            std::uint32_t frames{0};
+            std::chrono::nanoseconds record_time{0};
+        } m_benchmark{};
+    };
+} // namespace vk::plugins
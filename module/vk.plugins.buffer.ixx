@@ -0,0 +1,26 @@
+module;
+#include <cstdint>
+#include <span>
+#include <vulkan/vulkan.h>
+export module vk.plugins.buffer;
+import vk.context;
+
+namespace vk::plugins {
+    // Buffer plus its dedicated allocation. Host-visible buffers stay persistently mapped for their whole lifetime.
+    export struct GpuBuffer {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize size{0};
+        void* mapped{nullptr};
+    };
+
+    export [[nodiscard]] std::uint32_t find_memory_type(const context::EngineContext& eng, std::uint32_t type_bits, VkMemoryPropertyFlags required);
+    // With more than one queue family the buffer is shared concurrently between them, so no ownership transfers are
+    // needed when several queues touch it.
+    export [[nodiscard]] GpuBuffer create_buffer(const context::EngineContext& eng, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, std::span<const std::uint32_t> queue_families = {});
+    export void destroy_buffer(const context::EngineContext& eng, GpuBuffer& buffer);
+
+    export [[nodiscard]] constexpr VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace vk::plugins
@@ -0,0 +1,119 @@
+module;
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.capture;
+import vk.context;
+import vk.plugins.buffer;
+import vk.plugins.thread_pool;
+
+namespace vk::plugins {
+    export enum class CaptureFormat : std::uint8_t {
+        Raw,     // one frame_NNNNNN_WxH.raw per frame, pixels exactly as the attachment stores them
+        Png,     // one frame_NNNNNN.png per frame, 8-bit RGBA
+        Chunked, // a single capture.vvcap: file header, then a chunk header and raw pixels per frame
+    };
+
+    export struct CaptureConfig {
+        std::filesystem::path output{"capture"};
+        CaptureFormat format{CaptureFormat::Png};
+        std::uint32_t ring_size{4};
+        std::uint32_t every_nth_frame{1};
+    };
+
+    export struct CaptureStats {
+        std::uint64_t captured{0};
+        std::uint64_t written{0};
+        std::uint64_t dropped{0}; // no free readback buffer (the writer is behind), or the write failed
+        std::uint64_t bytes_written{0};
+    };
+
+    // Chunked file layout; all fields little-endian as written by the host.
+    export struct CaptureFileHeader {
+        char magic[8]{'V', 'V', 'C', 'A', 'P', 'T', 'U', 'R'};
+        std::uint32_t version{1};
+        std::uint32_t reserved{0};
+    };
+    export struct CaptureChunkHeader {
+        std::uint64_t frame{0};
+        std::uint32_t width{0};
+        std::uint32_t height{0};
+        std::uint32_t format{0}; // VkFormat
+        std::uint32_t row_pitch{0};
+        std::uint64_t size{0};
+    };
+
+    // 8-bit RGBA PNG with stored (uncompressed) deflate blocks: cheap to produce on the writer thread and readable
+    // everywhere. `bgra` swizzles B8G8R8A8 input.
+    export [[nodiscard]] std::vector<std::byte> encode_png(std::span<const std::byte> pixels, std::uint32_t width, std::uint32_t height, bool bgra);
+
+    // Copies finished frames into a ring of host-visible readback buffers and streams them to disk on a worker.
+    // A buffer is handed to the writer once its frame slot comes round again, i.e. after the engine waited on the fence
+    // of the frame that copied into it, so the writer never waits on the GPU. Neither the copy nor the write ever
+    // blocks recording; when every buffer is busy the frame is dropped.
+    export class FrameCapture {
+    public:
+        FrameCapture()                               = default;
+        FrameCapture(const FrameCapture&)            = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+        ~FrameCapture();
+
+        void initialize(const CaptureConfig& config);
+        // Waits for the writer to drain; the device must be idle.
+        void destroy(const context::EngineContext& eng);
+
+        // Outside rendering, once per frame: hands the slot's previous copy to the writer and reserves a readback
+        // buffer for this frame (growing it if the extent changed). Drops the frame if no buffer is free.
+        void prepare(const context::EngineContext& eng, VkFormat format, VkExtent2D extent, std::uint32_t frame_slot);
+        // After the frame's last write to `image`, which must be in GENERAL with that write made available to all
+        // commands (the state the render graph hands attachments back in). Follows the copy with a barrier into host
+        // reads.
+        void record(VkCommandBuffer cmd, VkImage image);
+        // Hands every completed copy to the writer and waits for it. Only call once the device is idle.
+        void flush();
+
+        [[nodiscard]] bool active() const {
+            return m_writer != nullptr;
+        }
+        [[nodiscard]] CaptureStats stats() const;
+
+    private:
+        enum class BufferState : std::uint8_t { Free, Gpu, Writing };
+        struct Readback {
+            GpuBuffer buffer{};
+            std::atomic<BufferState> state{BufferState::Free};
+        };
+        // One frame for the writer, copied into its task so the writer reads nothing prepare() assigns.
+        struct Pending {
+            std::uint32_t slot{0};
+            std::uint32_t buffer{0};
+            std::uint64_t frame{0};
+            VkFormat format{VK_FORMAT_UNDEFINED};
+            VkExtent2D extent{};
+        };
+
+        void submit_write(const Pending& pending);
+        void write_frame(const Pending& pending);
+
+        CaptureConfig m_config{};
+        std::vector<std::unique_ptr<Readback>> m_ring{};
+        std::array<std::optional<Pending>, context::FRAME_OVERLAP> m_slot_pending{};
+        std::optional<Pending> m_next{};
+        std::unique_ptr<ThreadPool> m_writer{};
+        std::ofstream m_chunked{};
+        std::uint64_t m_frame{0};
+        std::uint64_t m_captured{0};
+        std::atomic<std::uint64_t> m_dropped{0};
+        std::atomic<std::uint64_t> m_written{0};
+        std::atomic<std::uint64_t> m_bytes_written{0};
+        bool m_write_failed{false}; // writer thread only; the first failure is reported, the rest only counted
+    };
+} // namespace vk::plugins
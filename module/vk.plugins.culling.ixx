@@ -0,0 +1,121 @@
+module;
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.culling;
+import vk.context;
+import vk.plugins.batch;
+import vk.plugins.descriptor;
+import vk.plugins.render_graph;
+
+namespace vk::plugins {
+    export struct Plane {
+        float normal[3];
+        float distance;
+    };
+    export using Frustum = std::array<Plane, 6>;
+
+    // Max-depth pyramid over a [0, 1] depth buffer (1 = far). Level 0 is the depth buffer itself.
+    export struct HiZPyramid {
+        struct Level {
+            std::uint32_t width;
+            std::uint32_t height;
+            std::vector<float> depth;
+        };
+        std::vector<Level> levels;
+    };
+
+    // CPU reference for viewport_cull.comp. Matrices are column-major with Vulkan clip space (z in [0, w]).
+    export [[nodiscard]] Frustum extract_frustum(const std::array<float, 16>& view_proj);
+    export [[nodiscard]] bool sphere_in_frustum(const Frustum& frustum, const float center[3], float radius);
+    export [[nodiscard]] HiZPyramid build_hiz_pyramid(std::span<const float> depth, std::uint32_t width, std::uint32_t height);
+    export [[nodiscard]] bool hiz_occluded(const HiZPyramid& hiz, const std::array<float, 16>& view_proj, const float center[3], float radius);
+    export [[nodiscard]] float instance_radius(const InstanceData& instance);
+    // Appends surviving instance indices in order; the GPU pass produces the same set in arbitrary order.
+    export std::uint32_t cull_instances_cpu(std::span<const InstanceData> instances, const std::array<float, 16>& view_proj, const HiZPyramid* hiz, std::vector<std::uint32_t>& visible);
+
+    export struct CullingStats {
+        std::uint32_t dispatches{0};
+        std::uint32_t instances_tested{0};
+        bool async{false}; // ran on the dedicated compute queue
+    };
+
+    // Compute pass that tests every batch instance against the camera frustum (and optionally a Hi-Z pyramid of the
+    // previous frame's depth), compacts survivors into the batch's visible list and writes the indirect instance count.
+    export class CullingPass {
+    public:
+        // The set layout and per-slot sets come from `descriptors`, which must outlive the pass.
+        void initialize(const context::EngineContext& eng, VkPipelineCache cache, DescriptorAllocator& descriptors);
+        void destroy(const context::EngineContext& eng);
+
+        void set_enabled(bool enabled) {
+            m_enabled = enabled;
+        }
+        [[nodiscard]] bool enabled() const {
+            return m_enabled;
+        }
+        // Before initialize: runs the pass on `queue`, a queue of a family other than the graphics one, and hands the
+        // results to the graphics queue through a semaphore. The batch's buffers must be shared with `family` (see
+        // BatchRenderer::set_queue_families). Frames with a Hi-Z source still cull on the graphics queue, which owns
+        // the depth pyramid.
+        // record() then submits to both `queue` and eng.graphics_queue itself, so it must run on the thread that owns
+        // the graphics queue (Vulkan requires external synchronization of queue access), and the command buffer it was
+        // given must be submitted to the graphics queue after record() returns, as the engine does with its frame.
+        void set_compute_queue(VkQueue queue, std::uint32_t family) {
+            m_compute_queue  = queue;
+            m_compute_family = family;
+        }
+        [[nodiscard]] bool async() const {
+            return m_compute_queue != VK_NULL_HANDLE;
+        }
+        // Whether record() dispatches on the compute queue rather than into the frame's command buffer.
+        [[nodiscard]] bool submits_async() const {
+            return m_compute_queue != VK_NULL_HANDLE && m_hiz_view == VK_NULL_HANDLE;
+        }
+        // Optional occlusion source: a max-depth mip chain sampled with texelFetch. Pass VK_NULL_HANDLE to disable.
+        void set_hiz_source(VkImageView view, VkSampler sampler, std::uint32_t mip_count);
+
+        // Outside rendering, after batch.prepare() for the same slot. The barriers into the draw are left queued in the
+        // graph so they go out together with the scene pass's own transitions. On the compute queue the pass is
+        // submitted right away, followed by a graphics-queue batch that waits for it; `cmd` must then be submitted to
+        // the graphics queue after this call returns, as the engine does with the frame's command buffer.
+        void record(VkCommandBuffer cmd, const context::EngineContext& eng, BatchRenderer& batch, std::uint32_t frame_slot, RenderGraph& graph);
+
+        [[nodiscard]] const CullingStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        void create_async_resources(const context::EngineContext& eng);
+        void update_set(const context::EngineContext& eng, const BatchRenderer& batch, std::uint32_t frame_slot);
+        // Clears the instance count and dispatches, leaving the draw record and visible list in compute-written state.
+        std::array<ResourceId, 2> record_dispatch(VkCommandBuffer cmd, const BatchRenderer& batch, std::uint32_t frame_slot, RenderGraph& graph);
+        void submit_async(const context::EngineContext& eng, const BatchRenderer& batch, std::uint32_t frame_slot);
+
+        bool m_enabled{false};
+        VkDescriptorSetLayout m_set_layout{VK_NULL_HANDLE};
+        std::array<VkDescriptorSet, context::FRAME_OVERLAP> m_sets{};
+        std::array<std::uint64_t, context::FRAME_OVERLAP> m_slot_buffer_generation{};
+        std::array<std::uint64_t, context::FRAME_OVERLAP> m_slot_hiz_generation{};
+        VkPipelineLayout m_layout{VK_NULL_HANDLE};
+        std::array<VkPipeline, 2> m_pipelines{}; // [0] frustum only, [1] frustum + Hi-Z
+        std::uint64_t m_shader{0};
+
+        VkImageView m_hiz_view{VK_NULL_HANDLE};
+        VkSampler m_hiz_sampler{VK_NULL_HANDLE};
+        std::uint32_t m_hiz_mips{0};
+        std::uint64_t m_hiz_generation{1};
+        CullingStats m_stats{};
+
+        VkQueue m_compute_queue{VK_NULL_HANDLE};
+        std::uint32_t m_compute_family{0};
+        std::array<VkCommandPool, context::FRAME_OVERLAP> m_compute_pools{};
+        std::array<VkCommandBuffer, context::FRAME_OVERLAP> m_compute_cmds{};
+        std::array<VkSemaphore, context::FRAME_OVERLAP> m_culled{};
+        VkCommandPool m_handoff_pool{VK_NULL_HANDLE};
+        VkCommandBuffer m_handoff_cmd{VK_NULL_HANDLE}; // graphics queue: makes the culled results visible to the draw
+        RenderGraph m_compute_graph{};
+    };
+} // namespace vk::plugins
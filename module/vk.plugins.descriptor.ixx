@@ -0,0 +1,117 @@
+module;
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.descriptor;
+import vk.context;
+
+namespace vk::plugins {
+    // Descriptors per set of one type; pools are sized as ceil(per_set * sets) for each ratio.
+    export struct DescriptorRatio {
+        VkDescriptorType type{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER};
+        float per_set{1.0f};
+    };
+
+    // Sets and descriptors per core type (VK_DESCRIPTOR_TYPE_SAMPLER .. VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, indexed by
+    // the enum value). Used both for what a layout consumes and for running totals / high-water marks.
+    export struct DescriptorUsage {
+        static constexpr std::uint32_t kTrackedTypes = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1;
+
+        std::uint32_t sets{0};
+        std::array<std::uint32_t, kTrackedTypes> descriptors{};
+
+        void add(const DescriptorUsage& other);
+        void raise_to(const DescriptorUsage& other); // element-wise max
+        [[nodiscard]] std::uint32_t total_descriptors() const;
+    };
+
+    export [[nodiscard]] DescriptorUsage layout_usage(std::span<const VkDescriptorSetLayoutBinding> bindings);
+    export [[nodiscard]] std::vector<VkDescriptorPoolSize> descriptor_pool_sizes(std::span<const DescriptorRatio> ratios, std::uint32_t sets);
+    // Size of the next pool in a chain: 1.5x the last one, capped at max_sets.
+    export [[nodiscard]] std::uint32_t next_pool_sets(std::uint32_t current, std::uint32_t max_sets);
+
+    export struct DescriptorPoolConfig {
+        std::vector<DescriptorRatio> ratios{};
+        std::uint32_t initial_sets{16};
+        std::uint32_t max_sets_per_pool{1024};
+    };
+
+    // Pools of one configuration. Allocation moves on to the next pool (creating a larger one if needed) when the
+    // current one runs out; reset() recycles every pool at once. Sets are never freed individually.
+    export class DescriptorPoolChain {
+    public:
+        void initialize(const DescriptorPoolConfig& config);
+        void destroy(VkDevice device);
+        [[nodiscard]] VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, const DescriptorUsage& usage);
+        void reset(VkDevice device);
+
+        [[nodiscard]] const DescriptorUsage& usage() const {
+            return m_usage;
+        }
+        [[nodiscard]] std::uint32_t pool_count() const {
+            return static_cast<std::uint32_t>(m_ready.size() + m_full.size());
+        }
+        [[nodiscard]] std::uint32_t growths() const {
+            return m_growths;
+        }
+
+    private:
+        VkDescriptorPool acquire_pool(VkDevice device);
+
+        DescriptorPoolConfig m_config{};
+        std::vector<VkDescriptorPool> m_ready{};
+        std::vector<VkDescriptorPool> m_full{};
+        std::uint32_t m_next_sets{0};
+        std::uint32_t m_growths{0};
+        DescriptorUsage m_usage{};
+    };
+
+    export struct DescriptorAllocatorStats {
+        std::uint32_t persistent_pools{0};
+        std::uint32_t frame_pools{0};
+        std::uint32_t pool_growths{0};
+        DescriptorUsage persistent{}; // live long-lived sets
+        DescriptorUsage frame_peak{}; // most any single frame allocated
+    };
+
+    // Descriptor sets for the plugins. Long-lived sets come from a growable pool chain; per-frame sets come from one
+    // linear chain per frame slot that is reset wholesale when the slot comes round again. Layouts are created through
+    // the allocator so every allocation is accounted per descriptor type; the high-water marks printed on destroy are
+    // what the pool ratios should be tuned from.
+    export class DescriptorAllocator {
+    public:
+        DescriptorAllocator()                                      = default;
+        DescriptorAllocator(const DescriptorAllocator&)            = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        void initialize(const context::EngineContext& eng, const DescriptorPoolConfig& persistent, const DescriptorPoolConfig& per_frame);
+        // Destroys every pool, fixed pool and layout it created.
+        void destroy(const context::EngineContext& eng);
+
+        [[nodiscard]] VkDescriptorSetLayout create_layout(std::span<const VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+        [[nodiscard]] VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+        // Valid until begin_frame() is called for the same slot again, i.e. once this frame has retired.
+        [[nodiscard]] VkDescriptorSet allocate_frame(VkDescriptorSetLayout layout);
+        void begin_frame(std::uint32_t frame_slot);
+
+        // A standalone pool for code that manages its own sets (e.g. the ImGui backend); destroyed with the allocator.
+        [[nodiscard]] VkDescriptorPool create_fixed_pool(std::span<const VkDescriptorPoolSize> sizes, std::uint32_t max_sets, VkDescriptorPoolCreateFlags flags = 0);
+
+        [[nodiscard]] DescriptorAllocatorStats stats() const;
+        void report() const;
+
+    private:
+        [[nodiscard]] const DescriptorUsage& usage_of(VkDescriptorSetLayout layout) const;
+
+        VkDevice m_device{VK_NULL_HANDLE};
+        std::unordered_map<VkDescriptorSetLayout, DescriptorUsage> m_layouts{};
+        std::vector<VkDescriptorPool> m_fixed_pools{};
+        DescriptorPoolChain m_persistent{};
+        std::array<DescriptorPoolChain, context::FRAME_OVERLAP> m_frames{};
+        std::uint32_t m_frame_slot{0};
+        DescriptorUsage m_frame_peak{};
+    };
+} // namespace vk::plugins
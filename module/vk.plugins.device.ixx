@@ -0,0 +1,19 @@
+module;
+export module vk.plugins.device;
+
+namespace vk::plugins {
+    // Optional device features the plugins use when, and only when, the device was created with them. Vulkan cannot
+    // report what a VkDevice enabled, so whoever creates the device fills this in: HeadlessRunner from what it enabled,
+    // an engine-driven renderer through ViewportRenderer::set_device_features. The defaults are core Vulkan 1.3 only.
+    export struct DeviceFeatures {
+        bool shader_module_identifier{false};        // VK_EXT_shader_module_identifier with shaderModuleIdentifier
+        bool pipeline_creation_cache_control{false}; // Vulkan 1.3 pipelineCreationCacheControl
+        bool draw_indirect_count{false};             // Vulkan 1.2 drawIndirectCount
+        bool pipeline_statistics_query{false};       // core pipelineStatisticsQuery
+        bool buffer_device_address{false};           // Vulkan 1.2 bufferDeviceAddress
+        bool fill_mode_non_solid{false};             // core fillModeNonSolid: line and point polygon modes
+        // VK_EXT_extended_dynamic_state3 with the matching extendedDynamicState3* features.
+        bool dynamic_polygon_mode{false}; // PolygonMode
+        bool dynamic_color_blend{false};  // ColorBlendEnable and ColorBlendEquation
+    };
+} // namespace vk::plugins
@@ -0,0 +1,42 @@
+module;
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vulkan/vulkan.h>
+export module vk.plugins.headless;
+import vk.context;
+import vk.plugins.viewport;
+
+namespace vk::plugins {
+    export struct HeadlessConfig {
+        VkExtent2D extent{1280, 720};
+        std::uint32_t frames{120};
+        bool prefer_software{false};   // pick a CPU implementation (lavapipe) when one is present
+        bool wait_for_pipelines{true}; // block until the first pipelines are built, so every frame is complete
+    };
+
+    export struct HeadlessStats {
+        std::string device_name{};
+        std::uint32_t frames{0};
+        std::chrono::nanoseconds elapsed{0};
+    };
+
+    // Thrown by HeadlessRunner::run when the machine has no Vulkan instance, or no device with the queue and features
+    // the runner needs. Every other failure (device loss, pipeline builds, capture) surfaces as its own error.
+    export class NoSuitableDevice : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Drives a ViewportRenderer without SDL or a swapchain. It owns its own instance, device, colour attachment,
+    // command buffers and fences, and calls record_graphics the way the engine does in EngineBlit mode, so frame
+    // capture (ViewportRenderer::set_capture) works on display-less machines and software drivers. The optional
+    // features it enables are handed to the renderer through set_device_features, and the compute-only queue it
+    // creates when the renderer asks for async compute through set_compute_queue.
+    export class HeadlessRunner {
+    public:
+        // Throws NoSuitableDevice if no Vulkan 1.3 device with a graphics queue and dynamic rendering exists.
+        HeadlessStats run(ViewportRenderer& renderer, const HeadlessConfig& config);
+    };
+} // namespace vk::plugins
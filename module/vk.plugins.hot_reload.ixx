@@ -0,0 +1,76 @@
+module;
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+export module vk.plugins.hot_reload;
+
+namespace vk::plugins {
+    export struct ShaderHotReloadConfig {
+        std::chrono::milliseconds poll_interval{250};
+        // Directory holding the GLSL sources of the loaded SPIR-V (viewport.vert for viewport.vert.spv). When set, edited
+        // sources are recompiled with `compiler` on the watcher thread; otherwise only the .spv files are watched.
+        std::filesystem::path source_dir{};
+        std::filesystem::path compiler{"glslc"};
+    };
+
+    export struct HotReloadStats {
+        std::uint32_t reloads{0};
+        std::uint32_t failures{0}; // unreadable SPIR-V or a failed pipeline build; the previous pipeline stays bound
+        std::chrono::nanoseconds last_build_time{0};
+    };
+
+    // Compiles one GLSL stage with a glslc-compatible compiler, using the same flags as the CMake shader target.
+    // Blocks; returns the compiler's exit status.
+    export int compile_glsl(const std::filesystem::path& compiler, const std::filesystem::path& source, const std::filesystem::path& output);
+
+    // Polls the modification time and size of a set of files. A change is published only once both stayed the same
+    // for two consecutive scans, so files still being written are never picked up half-done. Missing files are
+    // tracked too and reported when they reappear.
+    export class FileWatcher {
+    public:
+        using Callback = std::function<void(const std::filesystem::path&)>;
+
+        FileWatcher()                              = default;
+        FileWatcher(const FileWatcher&)            = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+        ~FileWatcher();
+
+        // Scans every `interval` on a thread of its own; without it, call scan() directly.
+        void start(std::chrono::milliseconds interval);
+        void stop();
+
+        // Thread-safe. `on_change` runs on the scanning thread once a change has settled, before it is published.
+        void watch(const std::filesystem::path& path, Callback on_change = {});
+        void clear();
+        void scan();
+        // Settled changes since the last call, oldest first, each path at most once.
+        [[nodiscard]] std::vector<std::filesystem::path> take_changes();
+
+    private:
+        struct Stamp {
+            std::filesystem::file_time_type time{};
+            std::uintmax_t size{0};
+            bool exists{false};
+            bool operator==(const Stamp&) const = default;
+        };
+        struct Entry {
+            std::filesystem::path path{};
+            Stamp reported{};
+            Stamp pending{};
+            bool settling{false};
+            Callback on_change{};
+        };
+        static Stamp stamp(const std::filesystem::path& path);
+
+        std::mutex m_mutex;
+        std::condition_variable_any m_wake;
+        std::vector<Entry> m_entries{};
+        std::vector<std::filesystem::path> m_changes{};
+        std::jthread m_thread{};
+    };
+} // namespace vk::plugins
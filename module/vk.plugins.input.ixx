@@ -0,0 +1,117 @@
+module;
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+export module vk.plugins.input;
+
+namespace vk::plugins {
+    // Fixed rather than std::hardware_destructive_interference_size, which may differ between translation units.
+    constexpr std::size_t kCacheLine = 64;
+
+    export enum class InputEventType : std::uint8_t { KeyDown, KeyUp, MouseMotion, MouseButtonDown, MouseButtonUp, MouseWheel };
+
+    // Plain copy of the SDL events the simulation cares about, stamped when the render thread received it.
+    export struct InputEvent {
+        InputEventType type{InputEventType::KeyDown};
+        std::uint16_t mods{0};
+        std::int32_t code{0}; // SDL keycode or mouse button
+        float x{0.0f};
+        float y{0.0f};
+        std::chrono::steady_clock::time_point received{};
+    };
+
+    // Bounded lock-free ring for one producer and any number of consumers (Vyukov's sequence-per-cell queue with the
+    // producer side reduced to plain stores). Neither side ever blocks: try_push fails when full, try_pop when empty.
+    export template <typename T, std::size_t Capacity>
+        requires(std::has_single_bit(Capacity) && std::is_trivially_copyable_v<T>)
+    class SpmcRing {
+    public:
+        SpmcRing() {
+            for (std::size_t i = 0; i < Capacity; ++i) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        SpmcRing(const SpmcRing&)            = delete;
+        SpmcRing& operator=(const SpmcRing&) = delete;
+
+        // Producer thread only.
+        bool try_push(const T& value) {
+            const std::size_t pos = m_tail.load(std::memory_order_relaxed);
+            Cell& cell            = m_cells[pos & kMask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos) return false; // a consumer has not released it yet
+            cell.value = value;
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            m_tail.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+        bool try_pop(T& out) {
+            std::size_t pos = m_head.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell                = m_cells[pos & kMask];
+                const std::size_t seq     = cell.sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        out = cell.value;
+                        cell.sequence.store(pos + Capacity, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        // Approximate while both sides are active.
+        [[nodiscard]] std::size_t size() const {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+        [[nodiscard]] static constexpr std::size_t capacity() {
+            return Capacity;
+        }
+
+    private:
+        static constexpr std::size_t kMask = Capacity - 1;
+        struct Cell {
+            std::atomic<std::size_t> sequence{0};
+            T value{};
+        };
+
+        std::array<Cell, Capacity> m_cells{};
+        alignas(kCacheLine) std::atomic<std::size_t> m_tail{0};
+        alignas(kCacheLine) std::atomic<std::size_t> m_head{0};
+    };
+
+    // Latest-value hand-off from one writer thread to one reader thread. The reader's snapshot stays immutable until it
+    // asks for the next one, and neither side waits: besides the front (reader) and back (writer) buffers there is a
+    // third hand-off slot that publish() and latest() swap through.
+    export template <typename T>
+        requires std::is_copy_assignable_v<T>
+    class SnapshotBuffer {
+    public:
+        // Writer thread only.
+        void publish(const T& value) {
+            m_slots[m_back] = value;
+            m_back          = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndex;
+        }
+        // Reader thread only.
+        const T& latest() {
+            if (m_middle.load(std::memory_order_relaxed) & kFresh) m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndex;
+            return m_slots[m_front];
+        }
+
+    private:
+        static constexpr std::uint32_t kFresh = 4;
+        static constexpr std::uint32_t kIndex = 3;
+
+        std::array<T, 3> m_slots{};
+        alignas(kCacheLine) std::uint32_t m_back{0};
+        alignas(kCacheLine) std::uint32_t m_front{1};
+        alignas(kCacheLine) std::atomic<std::uint32_t> m_middle{2};
+    };
+} // namespace vk::plugins
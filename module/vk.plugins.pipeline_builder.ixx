@@ -0,0 +1,94 @@
+module;
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.pipeline_builder;
+import vk.context;
+import vk.plugins.pipeline_cache;
+import vk.plugins.thread_pool;
+
+namespace vk::plugins {
+    // Value-type description of a dynamic-rendering graphics pipeline. Holds no pointers, so it can be copied into
+    // a build job and turned into a VkGraphicsPipelineCreateInfo on whichever thread compiles it.
+    export struct GraphicsPipelineDesc {
+        std::uint64_t vert_shader{0}; // ShaderLibrary keys
+        std::uint64_t frag_shader{0};
+        VkPipelineLayout layout{VK_NULL_HANDLE};
+        VkFormat color_format{VK_FORMAT_B8G8R8A8_UNORM};
+        VkPrimitiveTopology topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+        VkPolygonMode polygon_mode{VK_POLYGON_MODE_FILL};
+        VkCullModeFlags cull_mode{VK_CULL_MODE_NONE};
+        VkFrontFace front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+        VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+        VkPipelineColorBlendAttachmentState color_blend{
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        };
+        std::vector<VkDynamicState> dynamic_states{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        // 32-bit specialization constants for both stages: constant_id i takes specialization[i], i < specialization_count.
+        std::array<std::uint32_t, 4> specialization{};
+        std::uint32_t specialization_count{0};
+        std::string name{};
+
+        // Compiles synchronously. Uses shader module identifiers when the modules are no longer resident and falls
+        // back to re-creating the modules if the driver reports VK_PIPELINE_COMPILE_REQUIRED.
+        VkResult create(const context::EngineContext& eng, VkPipelineCache cache, VkPipeline& out) const;
+    };
+
+    export struct PipelineBuild {
+        std::atomic<bool> ready{false};
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        VkResult result{VK_NOT_READY};
+        std::string error{};
+        std::chrono::steady_clock::time_point submitted{};
+        std::chrono::nanoseconds compile_time{0};
+        std::chrono::nanoseconds time_to_ready{0};
+        bool may_fail{false};
+    };
+    export using PipelineBuildTicket = std::shared_ptr<PipelineBuild>;
+
+    export struct PipelineBuildStats {
+        std::uint32_t queue_depth{0}; // submitted, not yet compiled
+        std::uint32_t completed{0};
+        std::chrono::nanoseconds last_time_to_ready{0};
+        std::chrono::nanoseconds max_time_to_ready{0};
+    };
+
+    // Compiles pipelines on a worker pool. Every worker owns a VkPipelineCache seeded from the parent cache, so
+    // compilation never contends on one cache; the worker caches are merged back into the parent once idle.
+    export class PipelineBuildScheduler {
+    public:
+        void initialize(const context::EngineContext& eng, PipelineCache& parent, std::uint32_t worker_count = 0);
+        void destroy(const context::EngineContext& eng);
+
+        // A failed build throws from poll(), unless `may_fail` is set (e.g. for edited shaders): the caller then finds the
+        // failure in the ticket's result and error.
+        [[nodiscard]] PipelineBuildTicket submit(GraphicsPipelineDesc desc, bool may_fail = false);
+        // Engine thread: finalizes finished builds (stats, cache telemetry) and merges worker caches when idle.
+        void poll(const context::EngineContext& eng);
+        // Blocks until every submitted build finished. Meant for shutdown and tests, not the frame loop.
+        void wait_idle();
+
+        [[nodiscard]] PipelineBuildStats stats() const;
+
+    private:
+        void merge_worker_caches(const context::EngineContext& eng);
+
+        const context::EngineContext* m_eng{nullptr};
+        PipelineCache* m_parent{nullptr};
+        std::unique_ptr<ThreadPool> m_pool{};
+        std::vector<VkPipelineCache> m_worker_caches{};
+        std::atomic<std::uint32_t> m_queue_depth{0};
+        bool m_worker_caches_dirty{false};
+
+        mutable std::mutex m_mutex;
+        std::vector<PipelineBuildTicket> m_in_flight{};
+        PipelineBuildStats m_stats{};
+    };
+} // namespace vk::plugins
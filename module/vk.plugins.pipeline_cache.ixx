@@ -0,0 +1,45 @@
+module;
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vulkan/vulkan.h>
+export module vk.plugins.pipeline_cache;
+import vk.context;
+
+namespace vk::plugins {
+    export [[nodiscard]] std::uint64_t hash_bytes(std::span<const std::byte> bytes, std::uint64_t seed = 0xcbf29ce484222325ull);
+
+    export struct PipelineCacheStats {
+        bool cache_hit{false};
+        std::size_t loaded_bytes{0};
+        std::size_t saved_bytes{0};
+        std::uint32_t pipelines_created{0};
+        std::chrono::nanoseconds create_time{0};
+        std::chrono::nanoseconds cold_create_time{0}; // create time of the run that produced the cache blob, 0 if unknown
+    };
+
+    export class PipelineCache {
+    public:
+        void load(const context::EngineContext& eng, const std::filesystem::path& path, std::uint64_t content_hash);
+        void save(const context::EngineContext& eng);
+        void destroy(const context::EngineContext& eng);
+        void record_creation(std::chrono::nanoseconds elapsed);
+        void report() const;
+
+        [[nodiscard]] VkPipelineCache handle() const {
+            return cache;
+        }
+        [[nodiscard]] const PipelineCacheStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        VkPipelineCache cache{VK_NULL_HANDLE};
+        std::filesystem::path m_path{};
+        std::uint64_t m_content_hash{0};
+        VkPhysicalDeviceProperties m_props{};
+        PipelineCacheStats m_stats{};
+    };
+} // namespace vk::plugins
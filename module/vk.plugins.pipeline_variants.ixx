@@ -0,0 +1,151 @@
+module;
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.pipeline_variants;
+import vk.context;
+import vk.plugins.device;
+import vk.plugins.pipeline_builder;
+
+namespace vk::plugins {
+    export enum class BlendMode : std::uint8_t { Opaque, Alpha, Additive };
+
+    // The state a variant may change, packed into eight bytes so it hashes and compares as one word. The enum fields
+    // only hold core Vulkan values; extension values do not fit and are rejected by variant_supported. Every variant
+    // draws single-sampled into the renderer's attachments, so the sample count is not part of the key.
+    export struct PipelineVariantKey {
+        std::uint8_t topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+        std::uint8_t polygon_mode{VK_POLYGON_MODE_FILL};
+        std::uint8_t cull_mode{VK_CULL_MODE_NONE};
+        std::uint8_t front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+        BlendMode blend{BlendMode::Opaque};
+        std::uint8_t reserved{0}; // fills what would be padding, so bit_cast sees every byte
+        std::uint16_t shading{0}; // specialization constant 0 of both stages
+
+        bool operator==(const PipelineVariantKey&) const = default;
+    };
+    static_assert(sizeof(PipelineVariantKey) == sizeof(std::uint64_t));
+
+    export struct PipelineVariantKeyHash {
+        std::size_t operator()(const PipelineVariantKey& key) const noexcept {
+            return std::hash<std::uint64_t>{}(std::bit_cast<std::uint64_t>(key));
+        }
+    };
+
+    // Which key fields are set while recording instead of being compiled in. Cull mode, front face and topology (within
+    // its point/line/triangle/patch class) are core in Vulkan 1.3; the rest needs VK_EXT_extended_dynamic_state3.
+    export struct VariantDynamicState {
+        bool cull_mode{true};
+        bool front_face{true};
+        bool topology{true};
+        bool topology_unrestricted{false};
+        bool polygon_mode{false};
+        bool blend{false};
+    };
+
+    // The key of the pipeline that serves `key`: dynamic fields are reset to one canonical value, so variants that only
+    // differ in them share a pipeline.
+    export [[nodiscard]] PipelineVariantKey pipeline_key(const PipelineVariantKey& key, const VariantDynamicState& dynamic);
+    export [[nodiscard]] VkPipelineColorBlendAttachmentState blend_attachment(BlendMode blend);
+    // Whether `key` can be drawn on a device created with `features`: every field holds a core value, line and point
+    // polygon modes have fillModeNonSolid, and the topology is not a patch list (the pipelines have no tessellation
+    // stages).
+    export [[nodiscard]] bool variant_supported(const PipelineVariantKey& key, const DeviceFeatures& features);
+
+    export struct PipelineVariantStats {
+        std::uint32_t pipelines{0}; // compiled or compiling
+        std::uint32_t variants{0};  // distinct keys requested
+        std::uint32_t frames{0};
+        std::uint64_t binds{0};
+        std::uint64_t pipeline_switches{0}; // binds that bound another pipeline
+        std::uint64_t state_switches{0};    // binds that only changed dynamic state
+        std::uint32_t last_frame_pipeline_switches{0};
+        std::uint32_t last_frame_state_switches{0};
+    };
+
+    // What a command buffer currently has bound through the cache; start each command buffer with a fresh one.
+    export struct VariantBinding {
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        PipelineVariantKey key{};
+    };
+
+    // Pipelines for variants of one base description, compiled on demand on the build workers and looked up by key.
+    // Fields the device can set dynamically are not part of the lookup, so with extended dynamic state 3 most
+    // variants collapse into one pipeline per shading mode and a switch costs a few vkCmdSet* calls.
+    export class PipelineVariantCache {
+    public:
+        enum class RebuildResult : std::uint8_t { None, Swapped, Failed };
+
+        // Only the extended dynamic state 3 fields `features` reports as enabled are set while recording.
+        void initialize(const context::EngineContext& eng, PipelineBuildScheduler& builds, const DeviceFeatures& features, GraphicsPipelineDesc base);
+        void destroy(const context::EngineContext& eng);
+
+        // Render thread, before recording: starts compiling the variant's pipeline the first time it is asked for. An
+        // unsupported variant is reported once and never drawn.
+        void request(const PipelineVariantKey& key);
+        // Render thread, at the start of a frame: frees pipelines retired when this slot last ran, adopts finished
+        // builds and folds the previous frame's bind counters into the stats. Reports a rebuild that completed.
+        RebuildResult begin_frame(std::uint32_t frame_slot);
+        // Recompiles every pipeline from a new base (e.g. reloaded shaders) while the current ones stay in use. The new
+        // set replaces the old at one begin_frame once all of it compiled, or is dropped if any build failed.
+        void rebuild(GraphicsPipelineDesc base);
+        [[nodiscard]] bool rebuilding() const {
+            return m_rebuilding;
+        }
+
+        // Safe from several threads while no render-thread call runs. Binds the variant's pipeline unless `binding`
+        // already holds it, then sets the key's dynamic state. Returns false while the pipeline is still compiling, and
+        // always for an unsupported variant.
+        bool bind(VkCommandBuffer cmd, const PipelineVariantKey& key, VariantBinding& binding) const;
+        [[nodiscard]] bool ready(const PipelineVariantKey& key) const;
+        // The variant will not draw until something changes: it is unsupported, or its build failed and nothing has
+        // replaced it since.
+        [[nodiscard]] bool failed(const PipelineVariantKey& key) const;
+
+        [[nodiscard]] const VariantDynamicState& dynamic_state() const {
+            return m_dynamic;
+        }
+        [[nodiscard]] const PipelineVariantStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        struct Slot {
+            VkPipeline pipeline{VK_NULL_HANDLE};
+            PipelineBuildTicket build{};
+            PipelineBuildTicket rebuild{};
+        };
+
+        [[nodiscard]] PipelineBuildTicket submit(const GraphicsPipelineDesc& base, const PipelineVariantKey& key) const;
+        void set_dynamic_state(VkCommandBuffer cmd, const PipelineVariantKey& key) const;
+        void finish_rebuild(bool swap, std::uint32_t frame_slot);
+
+        const context::EngineContext* m_eng{nullptr};
+        PipelineBuildScheduler* m_builds{nullptr};
+        GraphicsPipelineDesc m_base{};
+        GraphicsPipelineDesc m_next_base{};
+        bool m_rebuilding{false};
+        DeviceFeatures m_features{};
+        VariantDynamicState m_dynamic{};
+        PFN_vkCmdSetPolygonModeEXT m_set_polygon_mode{nullptr};
+        PFN_vkCmdSetColorBlendEnableEXT m_set_color_blend_enable{nullptr};
+        PFN_vkCmdSetColorBlendEquationEXT m_set_color_blend_equation{nullptr};
+
+        std::unordered_map<PipelineVariantKey, Slot, PipelineVariantKeyHash> m_pipelines{};
+        std::unordered_set<PipelineVariantKey, PipelineVariantKeyHash> m_variants{};
+        std::array<std::vector<VkPipeline>, context::FRAME_OVERLAP> m_retired{};
+        std::vector<PipelineBuildTicket> m_discarded{}; // superseded rebuilds still compiling
+
+        mutable std::atomic<std::uint32_t> m_frame_binds{0};
+        mutable std::atomic<std::uint32_t> m_frame_pipeline_switches{0};
+        mutable std::atomic<std::uint32_t> m_frame_state_switches{0};
+        PipelineVariantStats m_stats{};
+    };
+} // namespace vk::plugins
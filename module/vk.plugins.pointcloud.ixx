@@ -0,0 +1,255 @@
+module;
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.pointcloud;
+import vk.context;
+import vk.plugins.buffer;
+import vk.plugins.descriptor;
+import vk.plugins.pipeline_builder;
+import vk.plugins.render_graph;
+import vk.plugins.shader;
+import vk.plugins.thread_pool;
+
+namespace vk::plugins {
+    // On-disk layout (little-endian): PointCloudHeader, ChunkRecord[chunk_count], then every chunk's PackedPoints
+    // back to back. Chunks form an additive level-of-detail hierarchy: level 0 is a sparse sample of the whole set and
+    // each finer level adds points to smaller cells, so drawing all selected levels together gives the full density.
+    export constexpr std::array<char, 8> kPointCloudMagic{'V', 'K', 'P', 'C', 'L', 'O', 'U', 'D'};
+    export constexpr std::uint32_t kPointCloudVersion = 1;
+
+    export struct PointCloudHeader {
+        std::array<char, 8> magic{kPointCloudMagic};
+        std::uint32_t version{kPointCloudVersion};
+        std::uint32_t chunk_count{0};
+        std::uint64_t point_count{0};
+        std::uint32_t chunk_capacity{0}; // most points in any chunk; also the size of one GPU residency slot
+        std::uint32_t levels{0};
+        float bounds_min[3]{};
+        float bounds_max[3]{};
+    };
+
+    export struct ChunkRecord {
+        float bounds_min[3]{}; // tight bounds of the chunk's points, also the quantisation box
+        float bounds_max[3]{};
+        std::uint64_t first_point{0};
+        std::uint32_t point_count{0};
+        std::uint32_t level{0};
+    };
+
+    export struct PackedPoint {
+        std::uint16_t position[3]; // quantised over the chunk bounds
+        std::uint16_t reserved;
+        std::uint32_t color; // RGBA8
+    };
+
+    // Decoded point, std430 layout as read by pointcloud.vert.
+    export struct PointVertex {
+        float position[3];
+        std::uint32_t color;
+    };
+
+    export struct PointCloudBuildOptions {
+        std::uint32_t chunk_capacity{32 * 1024};
+        std::uint32_t max_level{10};
+    };
+
+    // Builds the chunk hierarchy in memory and writes it out. Points are taken in a fixed pseudo-random order and each
+    // lands in the coarsest level whose cell still has room, so every level is an even sample of what lies below it.
+    export void write_point_cloud(const std::filesystem::path& path, std::span<const PointVertex> points, const PointCloudBuildOptions& options = {});
+
+    // Memory-mapped reader. Only the header and chunk table are validated up front; point data is paged in by the OS
+    // as chunks are decoded, so files larger than RAM can be streamed. Throws std::runtime_error on malformed files.
+    export class PointCloudFile {
+    public:
+        explicit PointCloudFile(const std::filesystem::path& path);
+
+        [[nodiscard]] const PointCloudHeader& header() const {
+            return *m_header;
+        }
+        [[nodiscard]] std::span<const ChunkRecord> chunks() const {
+            return m_chunks;
+        }
+        [[nodiscard]] std::span<const PackedPoint> packed(std::uint32_t chunk) const;
+        // Dequantises a chunk into `out`, which must hold at least its point_count entries; returns the count. Thread-safe.
+        std::uint32_t decode(std::uint32_t chunk, std::span<PointVertex> out) const;
+
+    private:
+        MappedFile m_file;
+        const PointCloudHeader* m_header{nullptr};
+        std::span<const ChunkRecord> m_chunks{};
+        std::span<const PackedPoint> m_points{};
+    };
+
+    export struct LodSettings {
+        // Finer levels are wanted while a chunk's bounding sphere projects to at least this radius (in NDC, 1 = half
+        // the viewport). Level 0 is always wanted when visible.
+        float detail{0.05f};
+        // Points drawn per frame at most; coarse levels and large chunks are kept first, the rest is dropped.
+        std::uint64_t point_budget{8'000'000};
+    };
+
+    // Appends the chunks to draw this frame, in priority order, and returns their total point count.
+    export std::uint64_t select_chunks(std::span<const ChunkRecord> chunks, const std::array<float, 16>& view_proj, const LodSettings& lod, std::vector<std::uint32_t>& selected);
+    // Radius of the chunk's bounding sphere after projection, in NDC; infinite when it reaches behind the camera.
+    export [[nodiscard]] float projected_radius(const ChunkRecord& chunk, const std::array<float, 16>& view_proj);
+
+    // Least-recently-used assignment of chunks to a fixed number of GPU slots. Chunks touched in the current frame are
+    // pinned: they are never evicted to make room for another chunk in the same frame.
+    export class ChunkResidencyCache {
+    public:
+        static constexpr std::uint32_t kNone = ~0u;
+        struct Grant {
+            std::uint32_t slot{kNone};
+            std::uint32_t evicted{kNone}; // chunk that held the slot before
+        };
+
+        explicit ChunkResidencyCache(std::uint32_t slots = 0);
+        void reset(std::uint32_t slots);
+        void begin_frame() {
+            ++m_frame;
+        }
+
+        // Slot of a resident chunk, kNone if it is absent or still loading. Either way a tracked chunk is marked used.
+        std::uint32_t touch(std::uint32_t chunk);
+        // Claims a slot for a chunk about to be loaded: a free one, else the least recently used unpinned one.
+        // Returns slot kNone when every slot is pinned by this frame.
+        Grant reserve(std::uint32_t chunk);
+        // Finishes a load started by reserve(); false if the chunk lost its slot in the meantime.
+        bool mark_resident(std::uint32_t chunk, std::uint32_t slot);
+
+        [[nodiscard]] bool loading(std::uint32_t chunk) const;
+        [[nodiscard]] std::uint32_t slot_count() const {
+            return static_cast<std::uint32_t>(m_slots.size());
+        }
+        [[nodiscard]] std::uint32_t resident_count() const {
+            return m_resident;
+        }
+        [[nodiscard]] std::uint64_t evictions() const {
+            return m_evictions;
+        }
+
+    private:
+        struct Slot {
+            std::uint32_t chunk{kNone};
+            std::uint32_t prev{kNone}; // towards the most recently used end
+            std::uint32_t next{kNone};
+            std::uint64_t last_used{0};
+            bool loading{false};
+        };
+        void unlink(std::uint32_t slot);
+        void push_front(std::uint32_t slot);
+
+        std::vector<Slot> m_slots{};
+        std::unordered_map<std::uint32_t, std::uint32_t> m_chunk_slots{};
+        std::uint32_t m_head{kNone}; // most recently used
+        std::uint32_t m_tail{kNone}; // least recently used, or free
+        std::uint64_t m_frame{1};
+        std::uint32_t m_resident{0};
+        std::uint64_t m_evictions{0};
+    };
+
+    export struct PointCloudStreamConfig {
+        std::uint32_t gpu_slots{256};
+        std::uint32_t uploads_per_frame{8}; // chunk copies recorded per frame, bounding the per-frame transfer cost
+        std::uint32_t decodes_in_flight{16};
+        std::uint32_t decode_workers{2};
+        float point_size{1.0f}; // above 1 needs the largePoints feature
+        LodSettings lod{};
+    };
+
+    export struct PointCloudStats {
+        std::uint32_t selected_chunks{0};
+        std::uint32_t drawn_chunks{0};
+        std::uint64_t drawn_points{0};
+        std::uint32_t resident_chunks{0};
+        std::uint32_t uploads{0};
+        std::uint64_t bytes_uploaded{0};
+        std::uint64_t evictions{0};
+        std::chrono::nanoseconds decode_time{0}; // summed over the workers for the chunks uploaded this frame
+    };
+
+    // Streams a PointCloudFile into a device-local pool of fixed-size chunk slots. Each frame the visible chunks are
+    // picked by frustum and level of detail; missing ones are decoded on worker threads into host-visible staging and
+    // copied into their slot on the frame's command buffer, a bounded number per frame. Resident chunks are drawn as
+    // points, one draw per chunk, so the frame cost follows the point budget rather than the dataset size.
+    export class PointCloudStreamer {
+    public:
+        PointCloudStreamer()                                     = default;
+        PointCloudStreamer(const PointCloudStreamer&)            = delete;
+        PointCloudStreamer& operator=(const PointCloudStreamer&) = delete;
+
+        // The set layout and set come from `descriptors`, which must outlive the streamer.
+        void initialize(const context::EngineContext& eng, VkFormat color_format, PipelineBuildScheduler& builds, DescriptorAllocator& descriptors, const PointCloudStreamConfig& config = {});
+        void destroy(const context::EngineContext& eng);
+
+        // Replaces the streamed dataset; waits for outstanding decodes and the device first.
+        void open(const context::EngineContext& eng, const std::filesystem::path& path);
+        void close(const context::EngineContext& eng);
+        [[nodiscard]] bool is_open() const {
+            return m_file.has_value();
+        }
+        void set_lod(const LodSettings& lod) {
+            m_config.lod = lod;
+        }
+
+        // Outside rendering: records this frame's chunk copies and leaves the barrier into the draw queued in the graph.
+        void update(VkCommandBuffer cmd, const context::EngineContext& eng, RenderGraph& graph, const std::array<float, 16>& view_proj);
+        // Inside rendering; safe to call from several threads at once. Draws the chunks update() selected.
+        void record(VkCommandBuffer cmd, VkRect2D area, const std::array<float, 16>& view_proj) const;
+
+        [[nodiscard]] const PointCloudStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        struct Staging {
+            std::uint32_t chunk{ChunkResidencyCache::kNone};
+            std::uint32_t slot{ChunkResidencyCache::kNone};
+            std::uint32_t count{0};
+            std::chrono::nanoseconds decode_time{0};
+            std::uint64_t release_frame{0}; // the copy out of it has retired once this frame starts
+            std::atomic<bool> ready{false};
+            bool busy{false};
+        };
+        struct Draw {
+            std::uint32_t first_vertex{0};
+            std::uint32_t count{0};
+        };
+
+        void record_uploads(VkCommandBuffer cmd, RenderGraph& graph);
+        void request_loads();
+
+        PointCloudStreamConfig m_config{};
+        std::optional<PointCloudFile> m_file{};
+        ChunkResidencyCache m_cache{};
+        std::unique_ptr<ThreadPool> m_workers{};
+        GpuBuffer m_pool{};
+        GpuBuffer m_staging{};
+        std::unique_ptr<Staging[]> m_staging_slots{};
+        VkDeviceSize m_slot_bytes{0};
+        std::uint64_t m_frame{0};
+
+        VkDescriptorSetLayout m_set_layout{VK_NULL_HANDLE};
+        VkDescriptorSet m_set{VK_NULL_HANDLE};
+        VkPipelineLayout m_layout{VK_NULL_HANDLE};
+        VkPipeline m_pipeline{VK_NULL_HANDLE};
+        PipelineBuildTicket m_pending_pipeline{};
+        std::uint64_t m_vert_shader{0};
+        std::uint64_t m_frag_shader{0};
+
+        std::vector<std::uint32_t> m_selected{};
+        std::vector<std::uint32_t> m_missing{};
+        std::vector<Draw> m_draws{};
+        std::vector<VkBufferCopy> m_copies{};
+        PointCloudStats m_stats{};
+    };
+} // namespace vk::plugins
@@ -0,0 +1,123 @@
+module;
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.profiler;
+import vk.context;
+import vk.plugins.device;
+
+namespace vk::plugins {
+    // Times are milliseconds from the start of the frame: begin_frame() on the CPU, the first timestamp on the GPU.
+    export struct ProfileScope {
+        std::string name;
+        std::uint32_t depth{0};
+        double begin_ms{0.0};
+        double end_ms{0.0};
+    };
+
+    export struct PipelineStatistics {
+        std::uint64_t input_vertices{0};
+        std::uint64_t input_primitives{0};
+        std::uint64_t vertex_invocations{0};
+        std::uint64_t clipping_primitives{0};
+        std::uint64_t fragment_invocations{0};
+    };
+
+    export struct ProfileFrame {
+        std::uint64_t frame{0};
+        double cpu_start_ms{0.0}; // since Profiler::initialize
+        std::vector<ProfileScope> cpu{};
+        std::vector<ProfileScope> gpu{};
+        bool gpu_valid{false};
+        std::optional<PipelineStatistics> pipeline{};
+    };
+
+    // Per-frame-in-flight timestamp (and optional pipeline-statistics) query pools plus CPU scopes. A slot's queries are
+    // read back when the slot comes round again, after the engine has waited for it, and without
+    // VK_QUERY_RESULT_WAIT_BIT, so the profiler never stalls; results lag FRAME_OVERLAP frames behind.
+    export class Profiler {
+    public:
+        static constexpr std::uint32_t kInvalidScope = ~0u;
+
+        // Only takes effect when DeviceFeatures::pipeline_statistics_query is set; call before initialize().
+        void set_pipeline_statistics(bool enabled) {
+            m_want_pipeline_statistics = enabled;
+        }
+        void initialize(const context::EngineContext& eng, const DeviceFeatures& features, std::uint32_t max_gpu_scopes = 32, std::size_t history = 240);
+        void destroy(const context::EngineContext& eng);
+
+        // Outside rendering, first thing in the frame: harvests the slot's previous results and resets its pools.
+        void begin_frame(VkCommandBuffer cmd, const context::EngineContext& eng, std::uint32_t frame_slot);
+
+        std::uint32_t begin_gpu_scope(VkCommandBuffer cmd, std::string_view name);
+        void end_gpu_scope(VkCommandBuffer cmd, std::uint32_t scope);
+        // At most one statistics query per frame; begin and end inside the same rendering instance.
+        void begin_pipeline_statistics(VkCommandBuffer cmd);
+        void end_pipeline_statistics(VkCommandBuffer cmd);
+
+        std::uint32_t begin_cpu_scope(std::string_view name);
+        void end_cpu_scope(std::uint32_t scope);
+
+        [[nodiscard]] bool gpu_available() const {
+            return m_timestamp_period > 0.0;
+        }
+        [[nodiscard]] bool pipeline_statistics() const {
+            return m_statistics_pools[0] != VK_NULL_HANDLE;
+        }
+        [[nodiscard]] const std::deque<ProfileFrame>& history() const {
+            return m_history;
+        }
+
+        // Chrome trace event format (chrome://tracing, Perfetto). GPU scopes are placed on their own track, aligned to
+        // the CPU start of the frame that recorded them.
+        bool export_chrome_trace(const std::filesystem::path& path) const;
+
+    private:
+        void harvest(const context::EngineContext& eng, std::uint32_t frame_slot);
+
+        struct Slot {
+            std::optional<ProfileFrame> frame{};
+            bool statistics_written{false};
+        };
+
+        bool m_want_pipeline_statistics{false};
+        std::array<VkQueryPool, context::FRAME_OVERLAP> m_timestamp_pools{};
+        std::array<VkQueryPool, context::FRAME_OVERLAP> m_statistics_pools{};
+        std::array<Slot, context::FRAME_OVERLAP> m_slots{};
+        std::uint32_t m_max_gpu_scopes{0};
+        double m_timestamp_period{0.0}; // nanoseconds per tick, 0 if the queue has no timestamps
+        std::uint64_t m_timestamp_mask{0};
+
+        std::chrono::steady_clock::time_point m_epoch{};
+        std::chrono::steady_clock::time_point m_frame_start{};
+        std::uint64_t m_frame_number{0};
+        std::optional<std::uint32_t> m_current_slot{};
+        ProfileFrame m_current{};
+        std::vector<std::uint32_t> m_gpu_stack{};
+        std::vector<std::uint32_t> m_cpu_stack{};
+        std::size_t m_history_length{0};
+        std::deque<ProfileFrame> m_history{};
+    };
+
+    // Times the enclosing block as a CPU scope.
+    export class CpuZone {
+    public:
+        CpuZone(Profiler& profiler, std::string_view name) : m_profiler(profiler), m_scope(profiler.begin_cpu_scope(name)) {}
+        ~CpuZone() {
+            m_profiler.end_cpu_scope(m_scope);
+        }
+        CpuZone(const CpuZone&)            = delete;
+        CpuZone& operator=(const CpuZone&) = delete;
+
+    private:
+        Profiler& m_profiler;
+        std::uint32_t m_scope;
+    };
+} // namespace vk::plugins
@@ -0,0 +1,98 @@
+module;
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.render_graph;
+
+namespace vk::plugins {
+    // Where and how a resource was last touched. Images also carry their layout; buffers leave it UNDEFINED.
+    export struct ResourceState {
+        VkPipelineStageFlags2 stage{VK_PIPELINE_STAGE_2_NONE};
+        VkAccessFlags2 access{VK_ACCESS_2_NONE};
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+    };
+
+    export namespace states {
+        // Nothing on the GPU has touched the resource this frame; host writes are made visible by the submit.
+        constexpr ResourceState kUntouched{};
+        // The state the engine hands attachments over in and expects them back in.
+        constexpr ResourceState kEngineGeneral{VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+        // A freshly acquired swapchain image; ALL_COMMANDS chains with whatever stage the acquire semaphore waits on.
+        constexpr ResourceState kAcquired{VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED};
+        constexpr ResourceState kPresent{VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+        constexpr ResourceState kColorAttachment{VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        constexpr ResourceState kTransferWrite{VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT};
+        constexpr ResourceState kComputeReadWrite{VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT};
+        constexpr ResourceState kIndirectRead{VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT};
+        constexpr ResourceState kVertexStorageRead{VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT};
+    } // namespace states
+
+    export using ResourceId = std::uint32_t;
+
+    export struct RenderGraphStats {
+        std::uint32_t barrier_calls{0};
+        std::uint32_t image_barriers{0};
+        std::uint32_t buffer_barriers{0};
+        std::uint32_t elided{0}; // uses that needed no barrier (first touch or a read the last write is visible to)
+    };
+
+    // Tracks the layout and last access of every resource a frame touches and turns declared uses into the minimal set
+    // of barriers. Uses queue up until flush(), so everything requested between two passes lands in one
+    // vkCmdPipelineBarrier2. Resources are imported per frame; end_frame() returns them to their final state and
+    // forgets them, so the next frame's import starts from that state again.
+    export class RenderGraph {
+    public:
+        using BarrierSink = std::function<void(VkCommandBuffer, const VkDependencyInfo&)>;
+
+        RenderGraph();
+        // Recording-only use: barriers go to the sink instead of vkCmdPipelineBarrier2.
+        explicit RenderGraph(BarrierSink sink);
+
+        // Importing a resource that is already tracked this frame returns its id and keeps the tracked state.
+        ResourceId import_image(VkImage image, VkImageAspectFlags aspect, const ResourceState& current, std::optional<ResourceState> final_state = std::nullopt);
+        ResourceId import_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const ResourceState& current, std::optional<ResourceState> final_state = std::nullopt);
+
+        void use(ResourceId id, const ResourceState& next);
+        void flush(VkCommandBuffer cmd);
+        void end_frame(VkCommandBuffer cmd);
+
+        [[nodiscard]] bool frame_open() const {
+            return !m_resources.empty();
+        }
+        [[nodiscard]] const ResourceState& state(ResourceId id) const {
+            return m_resources.at(id).state;
+        }
+        [[nodiscard]] const RenderGraphStats& frame_stats() const {
+            return m_frame;
+        }
+        [[nodiscard]] const RenderGraphStats& last_frame_stats() const {
+            return m_last_frame;
+        }
+
+    private:
+        struct Resource {
+            VkImage image{VK_NULL_HANDLE};
+            VkBuffer buffer{VK_NULL_HANDLE};
+            VkImageAspectFlags aspect{0};
+            VkDeviceSize offset{0};
+            VkDeviceSize size{0};
+            ResourceState state{};
+            // The last write (or layout transition) and the reads it has been made visible to since. A read outside
+            // `visible` still needs a barrier from `last_write`, even though the current state is a read.
+            ResourceState last_write{};
+            ResourceState visible{};
+            std::optional<ResourceState> final_state{};
+            std::int32_t pending{-1}; // index into the queued image or buffer barriers
+            bool used{false};
+        };
+
+        BarrierSink m_sink;
+        std::vector<Resource> m_resources{};
+        std::vector<VkImageMemoryBarrier2> m_image_barriers{};
+        std::vector<VkBufferMemoryBarrier2> m_buffer_barriers{};
+        RenderGraphStats m_frame{};
+        RenderGraphStats m_last_frame{};
+    };
+} // namespace vk::plugins
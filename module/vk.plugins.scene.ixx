@@ -0,0 +1,111 @@
+module;
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+export module vk.plugins.scene;
+import vk.plugins.culling;
+import vk.plugins.thread_pool;
+
+namespace vk::plugins {
+    export enum class SimdLevel : std::uint8_t { Scalar, Avx2, Neon };
+
+    // Widest kernel set this build and CPU can run: AVX2 is detected at run time on x86-64, NEON is always present on
+    // AArch64. Kernels asked for a level that is not available run the scalar code instead.
+    export [[nodiscard]] SimdLevel best_simd_level();
+    export [[nodiscard]] const char* simd_level_name(SimdLevel level);
+
+    // Row-major 3x4 affine transform: rows are world x, y, z and the last column is the translation.
+    export using Affine = std::array<float, 12>;
+    export constexpr Affine kIdentityAffine{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+
+    // Maps a float to an unsigned key with the same order, so sorting keys ascending sorts depths ascending.
+    export [[nodiscard]] constexpr std::uint32_t depth_sort_key(float depth) {
+        const auto bits = std::bit_cast<std::uint32_t>(depth);
+        return bits ^ (static_cast<std::uint32_t>(static_cast<std::int32_t>(bits) >> 31) | 0x80000000u);
+    }
+
+    export struct SceneInstance {
+        Affine local{kIdentityAffine};
+        float center[3]{}; // object-space bounding box
+        float extent[3]{0.5f, 0.5f, 0.5f};
+        std::uint32_t color{0xffffffff}; // RGBA8, red in the low byte
+    };
+
+    export struct ScenePrepareStats {
+        std::uint32_t instances{0};
+        std::uint32_t visible{0};
+        SimdLevel level{SimdLevel::Scalar};
+        std::chrono::nanoseconds prepare_time{0};
+        std::chrono::nanoseconds sort_time{0};
+    };
+
+    // Structure-of-arrays instance store for CPU-side scene preparation. Every matrix element and bounds component is
+    // its own stream, so the kernels below load eight (AVX2) or four (NEON) instances per instruction with no shuffles.
+    // Each kernel works on an index range and reads what the previous one wrote: transform, then bounds, then cull,
+    // then depth keys. Ranges do not overlap in memory, so disjoint ranges may run on different threads.
+    export class SceneInstances {
+    public:
+        // Instances per parallel_for range; prepare() further walks each range in cache-sized blocks.
+        static constexpr std::size_t kPrepareGrain = 16 * 1024;
+
+        std::uint32_t add(const SceneInstance& instance);
+        void set(std::uint32_t index, const SceneInstance& instance);
+        void resize(std::size_t count);
+        void clear();
+        [[nodiscard]] std::size_t size() const {
+            return m_color.size();
+        }
+        [[nodiscard]] bool empty() const {
+            return m_color.empty();
+        }
+
+        // world = parent * local.
+        void transform(SimdLevel level, const Affine& parent, std::size_t begin, std::size_t end);
+        // World-space box of the transformed local box (centre transformed, extent through the absolute matrix).
+        void compute_bounds(SimdLevel level, std::size_t begin, std::size_t end);
+        // Box against the six planes; an instance is visible unless it lies wholly outside one of them.
+        void cull(SimdLevel level, const Frustum& frustum, std::size_t begin, std::size_t end);
+        // Sort key of the world-box centre's clip-space z, which grows with view depth for perspective and orthographic
+        // projections alike.
+        void depth_keys(SimdLevel level, const std::array<float, 16>& view_proj, std::size_t begin, std::size_t end);
+
+        // Runs all four kernels over every instance, spread over `pool` (and the calling thread) when one is given.
+        void prepare(const Affine& parent, const std::array<float, 16>& view_proj, SimdLevel level, ThreadPool* pool = nullptr);
+        // Replaces `out` with the visible instances' indices, nearest first; ties keep index order.
+        std::size_t sorted_visible(std::vector<std::uint32_t>& out);
+
+        [[nodiscard]] Affine world(std::size_t index) const;
+        [[nodiscard]] std::array<float, 3> world_center(std::size_t index) const;
+        [[nodiscard]] std::array<float, 3> world_extent(std::size_t index) const;
+        [[nodiscard]] bool visible(std::size_t index) const {
+            return m_visible[index] != 0;
+        }
+        [[nodiscard]] std::uint32_t depth_key(std::size_t index) const {
+            return m_depth_key[index];
+        }
+        [[nodiscard]] std::uint32_t color(std::size_t index) const {
+            return m_color[index];
+        }
+        [[nodiscard]] const ScenePrepareStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        std::array<std::vector<float>, 12> m_local{};
+        std::array<std::vector<float>, 3> m_center{};
+        std::array<std::vector<float>, 3> m_extent{};
+        std::vector<std::uint32_t> m_color{};
+
+        std::array<std::vector<float>, 12> m_world{};
+        std::array<std::vector<float>, 3> m_world_center{};
+        std::array<std::vector<float>, 3> m_world_extent{};
+        std::vector<std::uint8_t> m_visible{};
+        std::vector<std::uint32_t> m_depth_key{};
+
+        std::vector<std::uint64_t> m_sort_keys{};
+        ScenePrepareStats m_stats{};
+    };
+} // namespace vk::plugins
@@ -0,0 +1,112 @@
+module;
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.shader;
+import vk.context;
+
+namespace vk::plugins {
+    // Read-only memory mapping of a whole file. Move-only; unmaps on destruction.
+    export class MappedFile {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path);
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        [[nodiscard]] std::span<const std::byte> bytes() const {
+            return {static_cast<const std::byte*>(m_data), m_size};
+        }
+        [[nodiscard]] bool is_open() const {
+            return m_data != nullptr;
+        }
+
+    private:
+        void close();
+
+        const void* m_data{nullptr};
+        std::size_t m_size{0};
+#ifdef _WIN32
+        void* m_file{nullptr};
+        void* m_mapping{nullptr};
+#endif
+    };
+
+    // Validates a mapped SPIR-V blob (magic, size, 4-byte alignment) and returns it as words. Throws on malformed input.
+    export [[nodiscard]] std::span<const std::uint32_t> as_spirv(std::span<const std::byte> bytes, const std::filesystem::path& origin);
+
+    // One reference to a ShaderLibrary module, released on destruction so no exit path can leak it. Move-only.
+    export class ShaderRef {
+    public:
+        ShaderRef() = default;
+        ShaderRef(const context::EngineContext& eng, std::uint64_t key) : m_eng(&eng), m_key(key) {}
+        ShaderRef(const ShaderRef&)            = delete;
+        ShaderRef& operator=(const ShaderRef&) = delete;
+        ShaderRef(ShaderRef&& other) noexcept;
+        ShaderRef& operator=(ShaderRef&& other) noexcept;
+        ~ShaderRef();
+
+        void reset();
+        explicit operator bool() const {
+            return m_eng != nullptr;
+        }
+
+    private:
+        const context::EngineContext* m_eng{nullptr};
+        std::uint64_t m_key{0};
+    };
+
+    // Content-addressed VkShaderModule cache. Keys are hashes of the SPIR-V, so every plugin that loads the same
+    // binary on the same device shares one module; each VkDevice has its own entries and identifier setting, and
+    // every call resolves the key against eng.device. Modules are ref-counted; identifiers from
+    // VK_EXT_shader_module_identifier outlive the module so later pipeline rebuilds can skip module creation when the
+    // driver still has the shader cached.
+    export class ShaderLibrary {
+    public:
+        static ShaderLibrary& shared();
+
+        [[nodiscard]] std::uint64_t acquire(const context::EngineContext& eng, const std::filesystem::path& path);
+        void release(const context::EngineContext& eng, std::uint64_t key);
+        // Re-creates the module for a key whose module was released, re-reading the recorded path. Returns an empty
+        // reference if the file changed.
+        [[nodiscard]] ShaderRef reacquire(const context::EngineContext& eng, std::uint64_t key);
+        // Records identifiers for modules eng.device creates from now on; only enable it when that device's
+        // DeviceFeatures has both shader_module_identifier and pipeline_creation_cache_control, which the
+        // FAIL_ON_PIPELINE_COMPILE_REQUIRED flag of an identifier-only build needs.
+        void set_module_identifiers(const context::EngineContext& eng, bool enabled);
+
+        // Fills a stage from the live module, or from the stored identifier when the module is gone. Returns true when the
+        // identifier path was taken; the pipeline must then be created with VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT.
+        // A live module is referenced by `hold`, so it cannot be destroyed before the pipeline using it is created.
+        bool describe_stage(const context::EngineContext& eng, std::uint64_t key, VkShaderStageFlagBits stage, VkPipelineShaderStageCreateInfo& info, VkPipelineShaderStageModuleIdentifierCreateInfoEXT& identifier, ShaderRef& hold);
+
+        [[nodiscard]] bool has_identifier(const context::EngineContext& eng, std::uint64_t key) const;
+        [[nodiscard]] std::size_t module_count(const context::EngineContext& eng) const;
+
+    private:
+        struct Entry {
+            VkShaderModule module{VK_NULL_HANDLE};
+            std::uint32_t refs{0};
+            std::filesystem::path path{};
+            std::vector<std::uint8_t> identifier{};
+        };
+
+        struct Device {
+            std::unordered_map<std::uint64_t, Entry> entries{};
+            bool identifiers{false};
+        };
+
+        static VkShaderModule create_module(const context::EngineContext& eng, std::span<const std::uint32_t> words, bool identifiers, Entry& entry);
+
+        mutable std::mutex m_mutex;
+        std::unordered_map<VkDevice, Device> m_devices;
+    };
+} // namespace vk::plugins
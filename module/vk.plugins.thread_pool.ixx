@@ -0,0 +1,48 @@
+module;
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+export module vk.plugins.thread_pool;
+
+namespace vk::plugins {
+    // Fixed set of worker threads. Tasks receive the index of the worker running them so callers can keep
+    // per-worker resources (pipeline caches, command pools) without locking.
+    export class ThreadPool {
+    public:
+        explicit ThreadPool(std::uint32_t worker_count = 0);
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        void submit(std::function<void(std::uint32_t worker)> task);
+        // Returns once every submitted task finished, rethrowing the first exception one of them threw since the last
+        // wait; a throwing task never takes its worker down.
+        void wait_idle();
+        // Splits [0, count) into ranges of at least `grain` items, runs them on the workers and the calling thread, and
+        // returns once all are done, rethrowing the first exception. Only waits for its own ranges, but must not be
+        // called from one of this pool's workers.
+        void parallel_for(std::size_t count, std::size_t grain, const std::function<void(std::size_t begin, std::size_t end)>& body);
+
+        [[nodiscard]] std::uint32_t worker_count() const {
+            return static_cast<std::uint32_t>(m_workers.size());
+        }
+        [[nodiscard]] std::size_t pending() const;
+
+    private:
+        void run(std::uint32_t worker, const std::stop_token& stop);
+
+        mutable std::mutex m_mutex;
+        std::condition_variable_any m_wake;
+        std::condition_variable m_idle;
+        std::deque<std::function<void(std::uint32_t)>> m_tasks;
+        std::size_t m_active{0};
+        std::exception_ptr m_error{}; // first exception from a submitted task, handed to the next wait_idle
+        std::vector<std::jthread> m_workers;
+    };
+} // namespace vk::plugins
@@ -0,0 +1,182 @@
+module;
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+export module vk.plugins.upload;
+import vk.context;
+import vk.plugins.buffer;
+import vk.plugins.device;
+
+namespace vk::plugins {
+    // Bump pointer over [0, capacity). Only offsets are handed out, so the same logic serves any mapped range.
+    export class LinearAllocator {
+    public:
+        explicit LinearAllocator(VkDeviceSize capacity = 0) : m_capacity(capacity) {}
+
+        // Offset of `size` bytes aligned to `alignment` (a power of two, or 0/1 for none); nullopt once full.
+        [[nodiscard]] std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment) {
+            const VkDeviceSize offset = align_up(m_head, alignment);
+            if (offset > m_capacity || size > m_capacity - offset) return std::nullopt;
+            m_head = offset + size;
+            return offset;
+        }
+        void reset(VkDeviceSize capacity) {
+            m_capacity = capacity;
+            m_head     = 0;
+        }
+        [[nodiscard]] VkDeviceSize used() const {
+            return m_head;
+        }
+        [[nodiscard]] VkDeviceSize capacity() const {
+            return m_capacity;
+        }
+
+    private:
+        VkDeviceSize m_capacity{0};
+        VkDeviceSize m_head{0};
+    };
+
+    // Device-free bookkeeping behind UploadArena: a ring of FRAME_OVERLAP regions of region_size() bytes, one per frame
+    // slot, each bump-allocated and rewound when its slot comes round again. Allocations that do not fit are left to
+    // the caller; a frame that had any grows the regions to cover everything it asked for, rounded up to a power of two.
+    export class UploadRegions {
+    public:
+        // Adopts a ring of FRAME_OVERLAP regions of `region_size` bytes.
+        void reset(VkDeviceSize region_size);
+        // Closes the previous frame and rewinds `frame_slot`'s region. Returns true when the previous frame overflowed
+        // and region_size() grew; the caller must then replace the ring before allocating.
+        [[nodiscard]] bool begin_frame(std::uint32_t frame_slot);
+        // Offset into the ring, or nullopt once the slot's region is full; the bytes then count towards the growth.
+        [[nodiscard]] std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+        [[nodiscard]] VkDeviceSize region_size() const {
+            return m_region_size;
+        }
+        [[nodiscard]] std::uint32_t frame_slot() const {
+            return m_frame_slot;
+        }
+        [[nodiscard]] VkDeviceSize used() const {
+            return m_region.used();
+        }
+
+    private:
+        LinearAllocator m_region{};
+        VkDeviceSize m_region_size{0};
+        VkDeviceSize m_wanted_region{0};
+        VkDeviceSize m_frame_overflow{0}; // bytes the caller had to place elsewhere this frame
+        std::uint32_t m_frame_slot{0};
+    };
+
+    // Objects the GPU may still be reading, parked until their frame slot comes round again.
+    export template <typename T>
+    class SlotRetirement {
+    public:
+        void retire(std::uint32_t frame_slot, T value) {
+            m_slots[frame_slot].push_back(std::move(value));
+        }
+        // Everything parked in `frame_slot`, whose frames have now retired; the slot is left empty.
+        [[nodiscard]] std::vector<T> release(std::uint32_t frame_slot) {
+            return std::exchange(m_slots[frame_slot], {});
+        }
+        [[nodiscard]] std::size_t pending(std::uint32_t frame_slot) const {
+            return m_slots[frame_slot].size();
+        }
+
+    private:
+        std::array<std::vector<T>, context::FRAME_OVERLAP> m_slots{};
+    };
+
+    // Where an upload landed. `data` is written by the CPU; the GPU sees it at buffer + offset, or at `address` when
+    // the device supports buffer device addresses (0 otherwise). Valid until the frame slot it was made in retires.
+    export struct UploadAllocation {
+        void* data{nullptr};
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+        VkDeviceAddress address{0};
+
+        [[nodiscard]] explicit operator bool() const {
+            return data != nullptr;
+        }
+    };
+
+    export struct UploadArenaStats {
+        std::uint32_t frames{0}; // in the current reporting window
+        std::uint64_t bytes{0};
+        VkDeviceSize last_frame_bytes{0};
+        VkDeviceSize peak_frame_bytes{0};
+        VkDeviceSize region_size{0};
+        std::uint32_t overflows{0}; // allocations served by a dedicated fallback buffer
+        VkDeviceSize overflow_bytes{0};
+        std::uint32_t growths{0};
+    };
+
+    // One persistently mapped, host-coherent buffer split into FRAME_OVERLAP regions, one per frame slot. Per-frame
+    // data (camera blocks, streamed vertices) is bump-allocated from the current slot's region and never freed: the
+    // region is rewound when its slot comes round again. An allocation that does not fit gets a dedicated buffer that
+    // lives until the slot retires, and the next frame's regions are sized to cover the overflowing frame.
+    export class UploadArena {
+    public:
+        UploadArena()                              = default;
+        UploadArena(const UploadArena&)            = delete;
+        UploadArena& operator=(const UploadArena&) = delete;
+
+        // Regions get device addresses (SHADER_DEVICE_ADDRESS usage) only with DeviceFeatures::buffer_device_address.
+        void initialize(const context::EngineContext& eng, const DeviceFeatures& features, VkDeviceSize frame_bytes, VkBufferUsageFlags usage);
+        void destroy(const context::EngineContext& eng);
+        // Rewinds the slot's region; its previous frame has retired.
+        void begin_frame(const context::EngineContext& eng, std::uint32_t frame_slot);
+
+        [[nodiscard]] UploadAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        [[nodiscard]] UploadAllocation push(std::span<const T> values, VkDeviceSize alignment = alignof(T)) {
+            const UploadAllocation out = allocate(values.size_bytes(), alignment);
+            if (out) std::memcpy(out.data, values.data(), values.size_bytes());
+            return out;
+        }
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        [[nodiscard]] UploadAllocation push(const T& value, VkDeviceSize alignment = alignof(T)) {
+            return push(std::span<const T>(&value, 1), alignment);
+        }
+
+        // Offset alignments for binding an allocation through a descriptor.
+        [[nodiscard]] VkDeviceSize uniform_alignment() const {
+            return m_uniform_alignment;
+        }
+        [[nodiscard]] VkDeviceSize storage_alignment() const {
+            return m_storage_alignment;
+        }
+        [[nodiscard]] bool device_addresses() const {
+            return m_base_address != 0;
+        }
+        [[nodiscard]] const UploadArenaStats& stats() const {
+            return m_stats;
+        }
+
+    private:
+        void create_ring(const context::EngineContext& eng);
+        void end_frame();
+
+        const context::EngineContext* m_eng{nullptr};
+        VkBufferUsageFlags m_usage{0};
+        GpuBuffer m_ring{};
+        VkDeviceAddress m_base_address{0};
+        VkDeviceSize m_uniform_alignment{1};
+        VkDeviceSize m_storage_alignment{1};
+        bool m_in_frame{false};
+        UploadRegions m_regions{};
+        // Buffers the GPU may still read: overflow fallbacks and rings replaced by a larger one.
+        SlotRetirement<GpuBuffer> m_retired{};
+        VkDeviceSize m_frame_bytes{0};
+        UploadArenaStats m_stats{};
+    };
+} // namespace vk::plugins
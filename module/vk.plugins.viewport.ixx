@@ -1,56 +1,412 @@
 module;
 #include <SDL3/SDL.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <vulkan/vulkan.h>
+struct ImDrawData;
 export module vk.plugins.viewport;
 import vk.engine;
 import vk.context;
+import vk.plugins.batch;
+import vk.plugins.capture;
+import vk.plugins.culling;
+import vk.plugins.descriptor;
+import vk.plugins.device;
+import vk.plugins.hot_reload;
+import vk.plugins.input;
+import vk.plugins.pipeline_builder;
+import vk.plugins.pipeline_cache;
+import vk.plugins.pipeline_variants;
+import vk.plugins.pointcloud;
+import vk.plugins.profiler;
+import vk.plugins.render_graph;
+import vk.plugins.scene;
+import vk.plugins.shader;
+import vk.plugins.thread_pool;
+import vk.plugins.upload;
 
 namespace vk::plugins {
+    // Rolling CPU frame timing, reset whenever the pass layout changes so merged and split frames are measured apart.
+    export struct FrameTimingStats {
+        std::uint32_t frames{0};
+        std::chrono::nanoseconds frame_time{0};
+        std::chrono::nanoseconds record_time{0};
+        bool merged_passes{false};
+        std::uint32_t views{1};
+    };
+
+    // Values of the viewport fragment shader's specialization constant, PipelineVariantKey::shading.
+    export enum class ViewportShading : std::uint16_t { VertexColor, Luminance, Flat };
+
+    // One camera into the scene. Views sharing an attachment are drawn into their own sub-rects of it in one pass.
+    export struct RenderView {
+        std::string name{};
+        std::array<float, 16> view_proj{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        VkRect2D area{};              // zero extent covers the whole attachment
+        std::uint32_t attachment{0}; // index into FrameContext::color_attachments; 0 is the presented one
+        PipelineVariantKey variant{};
+        std::array<float, 4> tint{1, 1, 1, 1}; // pushed per draw, so it never costs a pipeline
+    };
+
+    // Simulation state published by ViewpoertPlugin's tick thread; the render thread only ever sees whole snapshots.
+    export struct ViewportState {
+        std::uint64_t tick{0};
+        double sim_time{0.0};
+        std::uint64_t events{0};
+        std::uint64_t dropped_events{0};
+        std::int32_t last_key{0};
+        std::uint16_t mods{0};
+        float mouse_x{0.0f};
+        float mouse_y{0.0f};
+        std::chrono::steady_clock::time_point last_input{}; // when the newest consumed event reached the render thread
+    };
+
+    // Time from an event reaching process_event to the first UI frame recorded from a snapshot that includes it.
+    export struct InputLatencyStats {
+        std::uint64_t samples{0};
+        std::chrono::nanoseconds last{0};
+        std::chrono::nanoseconds max{0};
+        std::chrono::nanoseconds total{0};
+    };
+
+    export using InputQueue = SpmcRing<InputEvent, 1024>;
+
+    // UI cost over the last report interval; reset whenever incremental mode is toggled.
+    export struct UiFrameStats {
+        std::uint32_t frames{0};
+        std::uint32_t built{0};    // frames that ran NewFrame/Render
+        std::uint32_t recorded{0}; // frames that re-recorded the draw commands and re-uploaded vertices
+        std::chrono::nanoseconds cpu_time{0};
+        std::uint64_t bytes_uploaded{0};
+        bool incremental{false};
+    };
+
+    // Frame-slot contract shared by ViewportRenderer and ViewportUI: the engine calls record_graphics and record_imgui
+    // exactly once for every frame it submits, and waits for the fence of a frame slot before recording into that slot
+    // again. Each therefore counts its own calls and uses `calls % FRAME_OVERLAP` as the slot; the slot's previous
+    // frame has retired when it comes round, which is what every per-frame resource (descriptor chains, upload
+    // regions, query pools, capture buffers, retired pipelines) relies on. A caller that records without submitting,
+    // or submits a frame without recording, breaks that pairing.
     export class ViewportRenderer {
     public:
         void query_required_device_caps(context::RendererCaps& caps);
         void get_capabilities(context::RendererCaps& caps);
         void initialize(const context::EngineContext& eng, const context::RendererCaps& caps);
+        // Also releases whatever an initialize that threw part way through created.
         void destroy(const context::EngineContext& eng);
         void record_graphics(VkCommandBuffer& cmd, const context::EngineContext& eng, const context::FrameContext& frm);
 
+        // Optional features the device was created with (see DeviceFeatures); only honoured if set before initialize.
+        void set_device_features(const DeviceFeatures& features) {
+            m_device_features = features;
+        }
+        [[nodiscard]] const DeviceFeatures& device_features() const {
+            return m_device_features;
+        }
+        void set_pipeline_cache_path(std::filesystem::path path) {
+            m_pipeline_cache_path = std::move(path);
+        }
+        [[nodiscard]] const PipelineCacheStats& pipeline_cache_stats() const {
+            return m_pipeline_cache.stats();
+        }
+        [[nodiscard]] PipelineBuildStats pipeline_build_stats() const {
+            return m_pipeline_builds.stats();
+        }
+        [[nodiscard]] BatchRenderer& batches() {
+            return m_batches;
+        }
+        [[nodiscard]] CullingPass& culling() {
+            return m_culling;
+        }
+        // CPU-side instance store: when non-empty, it is transformed, culled and depth-sorted on the view workers each
+        // frame and its visible instances, nearest first, replace the batch's instances before upload.
+        [[nodiscard]] SceneInstances& scene() {
+            return m_scene;
+        }
+        // Streams a chunked point-cloud file (see write_point_cloud); open() it once the renderer is initialized.
+        [[nodiscard]] PointCloudStreamer& point_cloud() {
+            return m_point_cloud;
+        }
+        [[nodiscard]] Profiler& profiler() {
+            return m_profiler;
+        }
+        // Counts vertices, primitives and fragment invocations of the scene pass into the profiler's history. Needs
+        // DeviceFeatures::pipeline_statistics_query; only honoured if set before initialize.
+        void set_pipeline_statistics(bool enabled) {
+            m_profiler.set_pipeline_statistics(enabled);
+        }
+        [[nodiscard]] RenderGraph& render_graph() {
+            return m_render_graph;
+        }
+        // Descriptor sets of the scene passes; allocate_frame sets are valid until the frame retires.
+        [[nodiscard]] DescriptorAllocator& descriptors() {
+            return m_descriptors;
+        }
+        // Variant of the scene pipeline drawn without views; views carry their own. A new variant compiles on the build
+        // workers and is skipped until ready.
+        void set_variant(const PipelineVariantKey& key, std::array<float, 4> tint = {1, 1, 1, 1}) {
+            m_variant = key;
+            m_tint    = tint;
+        }
+        [[nodiscard]] const PipelineVariantCache& pipeline_variants() const {
+            return m_variants;
+        }
+        // Per-frame upload region for camera blocks and streamed geometry; allocations live until the frame retires.
+        [[nodiscard]] UploadArena& uploads() {
+            return m_uploads;
+        }
+        // With a UI attached, the UI pass closes the frame's render graph, so the attachment goes back to GENERAL once.
+        void set_ui_attached(bool attached) {
+            m_ui_attached = attached;
+        }
+        // Records the scene and UI into one dynamic-rendering instance (suspended after the scene, resumed by the UI, or
+        // by finish_frame when the UI draws nothing) instead of storing and reloading the attachment between them. Only
+        // takes effect with a UI attached and in modes where both draw to the same attachment; DirectToSwapchain draws
+        // the UI to the swapchain image.
+        void set_pass_merging(context::PresentationMode mode, bool enabled);
+        [[nodiscard]] bool pass_merging(context::PresentationMode mode) const;
+        // Resumes the scene pass suspended this frame; returns false if the scene pass was ended normally. `flags` may add
+        // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT when the UI is recorded into secondary command buffers.
+        bool resume_scene_pass(VkCommandBuffer cmd, VkRenderingFlags flags = 0);
+        // Whether this frame's scene pass is suspended, i.e. the UI's instance will be begun with RESUMING.
+        [[nodiscard]] bool scene_suspended() const {
+            return m_scene_suspended;
+        }
+        [[nodiscard]] const FrameTimingStats& frame_timing() const {
+            return m_frame_timing;
+        }
+        // With views set, each view is recorded into its own secondary command buffer on the view workers and executed
+        // from the primary; without, the scene is recorded inline as one full-extent view. View 0 is the primary
+        // camera: it drives culling and is the only view drawn from the culled instance list. Attachments beyond 0 are
+        // requested from the engine in get_capabilities, so views must be set before the engine queries the renderer.
+        void set_views(std::vector<RenderView> views);
+        [[nodiscard]] const std::vector<RenderView>& views() const {
+            return m_views;
+        }
+        // Threads recording views and preparing the scene; 0 leaves one hardware thread to the caller. Only honoured
+        // before the first frame that needs them.
+        void set_view_workers(std::uint32_t workers) {
+            m_view_worker_count = workers;
+        }
+        // Requests a dedicated compute queue from the engine; only honoured if set before the device is created.
+        void set_async_compute(bool enabled) {
+            m_async_compute = enabled;
+        }
+        // Before initialize: the compute queue the engine granted. Frustum culling is submitted there when its family
+        // differs from the graphics family; otherwise, or without a queue, it stays on the graphics queue. record_graphics
+        // then submits to the graphics queue itself (see CullingPass::set_compute_queue), so it must be called on the
+        // thread that submits the engine's frame, and that frame submitted after it returns.
+        void set_compute_queue(VkQueue queue, std::uint32_t family) {
+            m_compute_queue  = queue;
+            m_compute_family = family;
+        }
+        // Streams every finished colour attachment to disk (see FrameCapture); only honoured if set before initialize.
+        void set_capture(CaptureConfig config) {
+            m_capture_config = std::move(config);
+        }
+        [[nodiscard]] CaptureStats capture_stats() const {
+            return m_capture.stats();
+        }
+        // Watches the viewport's SPIR-V (and, with a source_dir, its GLSL) and rebuilds the pipeline on the build workers
+        // when it changes. Every variant is rebuilt; the new set is swapped in at the start of a frame once all of it
+        // compiled and the old one destroyed once every frame that used it has retired. A failed reload keeps the
+        // previous pipelines. A failed initial build, which is otherwise fatal, waits for the next edit to replace it.
+        // Only honoured if set before initialize.
+        void set_shader_hot_reload(ShaderHotReloadConfig config) {
+            m_hot_reload_config = std::move(config);
+        }
+        [[nodiscard]] const HotReloadStats& hot_reload_stats() const {
+            return m_hot_reload_stats;
+        }
+        // Blocks until every queued pipeline build has finished; headless runs use it so no frame is drawn half-empty.
+        void wait_for_pipeline_builds();
+        // Closes the frame: hands attachments back to the engine and records the capture copy of the final image.
+        // Called by record_graphics without a UI, and by the attached UI after its pass otherwise. A scene pass the UI
+        // did not resume (no draw data this frame) is resumed and ended here, so no instance stays suspended past the
+        // command buffer.
+        void finish_frame(VkCommandBuffer cmd);
+
     protected:
         void create_pipeline_layout(const context::EngineContext& eng);
         void create_graphics_pipeline(const context::EngineContext& eng);
-        void draw_triangle(VkCommandBuffer cmd, VkExtent2D extent) const;
+        void poll_pipeline_builds(const context::EngineContext& eng);
+        void poll_shader_reload(const context::EngineContext& eng, PipelineVariantCache::RebuildResult rebuild);
+        void start_shader_reload(const context::EngineContext& eng);
+        void finish_shader_reload(const context::EngineContext& eng, bool swapped);
+        void draw_triangle(VkCommandBuffer cmd, VkRect2D area, VkDeviceAddress camera, const PipelineVariantKey& variant, const std::array<float, 4>& tint) const;
+        void record_views(VkCommandBuffer cmd, const context::EngineContext& eng, const context::FrameContext& frm, std::uint32_t frame_slot, bool merge);
+        void prepare_scene();
 
-        static void begin_rendering(VkCommandBuffer& cmd, const context::AttachmentView& target, VkExtent2D extent);
+        void update_frame_timing(bool merged, std::uint32_t views, std::chrono::nanoseconds record_time);
+
+        static void begin_rendering(VkCommandBuffer& cmd, const context::AttachmentView& target, VkExtent2D extent, VkRenderingFlags flags = 0);
         static void end_rendering(VkCommandBuffer& cmd);
 
     private:
         VkPipelineLayout layout{VK_NULL_HANDLE};
-        VkPipeline pipe{VK_NULL_HANDLE};
         VkFormat fmt{VK_FORMAT_B8G8R8A8_UNORM};
-        VkDynamicState m_dynamic_states[2]{};
-        VkPipelineColorBlendAttachmentState m_color_blend_attachment{};
-
-        struct {
-            VkPipelineRenderingCreateInfo rendering_info;
-            VkPipelineVertexInputStateCreateInfo vertex_input_state;
-            VkPipelineInputAssemblyStateCreateInfo input_assembly_state;
-            VkPipelineViewportStateCreateInfo viewport_state;
-            VkPipelineRasterizationStateCreateInfo rasterization_state;
-            VkPipelineMultisampleStateCreateInfo multisample_state;
-            VkPipelineColorBlendStateCreateInfo color_blend_state;
-            VkPipelineDynamicStateCreateInfo dynamic_state;
-        } m_graphics_pipeline{};
+        DeviceFeatures m_device_features{};
+        PipelineCache m_pipeline_cache{};
+        PipelineBuildScheduler m_pipeline_builds{};
+        PipelineVariantCache m_variants{};
+        PipelineVariantKey m_variant{};
+        std::array<float, 4> m_tint{1, 1, 1, 1};
+        bool m_pipeline_ready{false}; // the first variant landed and the build was reported
+        BatchRenderer m_batches{};
+        CullingPass m_culling{};
+        SceneInstances m_scene{};
+        std::vector<std::uint32_t> m_scene_order{};
+        std::vector<InstanceData> m_scene_upload{};
+        PointCloudStreamer m_point_cloud{};
+        DescriptorAllocator m_descriptors{};
+        RenderGraph m_render_graph{};
+        Profiler m_profiler{};
+        UploadArena m_uploads{};
+        VkDeviceAddress m_triangle_vertices{0};
+        bool m_ui_attached{false};
+        bool m_async_compute{false};
+        VkQueue m_compute_queue{VK_NULL_HANDLE};
+        std::uint32_t m_compute_family{0};
+        std::vector<context::PresentationMode> m_merged_modes{};
+        bool m_scene_suspended{false};
+        context::AttachmentView m_frame_target{};
+        VkExtent2D m_frame_extent{};
+        std::optional<CaptureConfig> m_capture_config{};
+        FrameCapture m_capture{};
+
+        // Per worker and frame slot: a command pool and the secondaries allocated from it, reused once the slot retires.
+        struct ViewRecorder {
+            VkCommandPool pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> buffers{};
+            std::uint32_t used{0};
+        };
+        std::vector<RenderView> m_views{};
+        std::uint32_t m_view_worker_count{0};
+        std::unique_ptr<ThreadPool> m_view_workers{};
+        std::array<std::vector<ViewRecorder>, context::FRAME_OVERLAP> m_view_recorders{};
+        std::vector<VkCommandBuffer> m_view_cmds{};
+        std::vector<VkDeviceAddress> m_view_cameras{};
+        FrameTimingStats m_frame_timing{};
+        std::chrono::steady_clock::time_point m_last_frame_start{};
+        std::uint64_t m_frame_number{0};
+        std::uint64_t m_vert_shader{0};
+        std::uint64_t m_frag_shader{0};
+        bool m_shader_refs_held{false};
+        std::filesystem::path m_vert_path{};
+        std::filesystem::path m_frag_path{};
+
+        std::optional<ShaderHotReloadConfig> m_hot_reload_config{};
+        FileWatcher m_shader_watcher{};
+        bool m_reload_requested{false};
+        std::uint64_t m_reload_vert{0}; // held while the variants rebuild
+        std::uint64_t m_reload_frag{0};
+        std::chrono::steady_clock::time_point m_reload_started{};
+        HotReloadStats m_hot_reload_stats{};
+        std::filesystem::path m_pipeline_cache_path{"viewport.pipeline_cache"};
+
+        GraphicsPipelineDesc m_graphics_pipeline{};
     };
+    export class ViewpoertPlugin;
     export class ViewportUI {
     public:
+        // Records into the renderer's render graph so the scene and UI passes share one set of transitions.
+        void attach(ViewportRenderer& renderer);
+        // Forwards input to the plugin's queue and draws from its snapshots instead of handling events inline.
+        void attach(ViewpoertPlugin& plugin);
         void create_imgui(context::EngineContext& eng, const context::FrameContext& frm);
         void destroy_imgui(const context::EngineContext& eng);
         void process_event(const SDL_Event& event);
         void record_imgui(VkCommandBuffer& cmd, const context::FrameContext& frm);
+
+        // Descriptor sets for UI content (e.g. ImGui::Image textures); valid between create_imgui and destroy_imgui.
+        // allocate_frame sets live until record_imgui comes round to the same frame slot (see the frame-slot contract
+        // above ViewportRenderer).
+        [[nodiscard]] DescriptorAllocator& descriptors() {
+            return m_descriptors;
+        }
+        [[nodiscard]] const InputLatencyStats& input_latency() const {
+            return m_input_latency;
+        }
+        // Rebuilds the UI only after input, while ImGui is animating or an item is active, and every `idle_refresh` for
+        // live panels; unchanged draw data replays the previously recorded secondary command buffer without uploading
+        // anything. The scene is unaffected and still records every frame.
+        void set_incremental(bool enabled);
+        void set_idle_refresh(std::chrono::milliseconds interval) {
+            m_idle_refresh = interval;
+        }
+        [[nodiscard]] const UiFrameStats& ui_stats() const {
+            return m_ui_stats;
+        }
+
+    private:
+        void draw_simulation_panel();
+        [[nodiscard]] bool needs_ui_build(std::chrono::steady_clock::time_point now) const;
+        void record_ui_commands(ImDrawData* draw_data, VkFormat format, VkRenderingFlags rendering_flags);
+        void update_ui_stats(bool built, bool recorded, std::uint64_t bytes, std::chrono::nanoseconds cpu_time);
+
+        ViewportRenderer* m_renderer{nullptr};
+        ViewpoertPlugin* m_plugin{nullptr};
+        RenderGraph m_render_graph{};
+        DescriptorAllocator m_descriptors{};
+        VkDescriptorPool m_imgui_pool{VK_NULL_HANDLE};
+        std::uint64_t m_frame_number{0};
+        InputLatencyStats m_input_latency{};
+        std::chrono::steady_clock::time_point m_last_seen_input{};
+
+        bool m_incremental{false};
+        std::chrono::milliseconds m_idle_refresh{100};
+        std::uint32_t m_pending_builds{1};
+        std::chrono::steady_clock::time_point m_last_build{};
+        std::uint64_t m_draw_hash{0};
+        VkCommandPool m_ui_pool{VK_NULL_HANDLE};
+        std::array<VkCommandBuffer, context::FRAME_OVERLAP> m_ui_cmds{};
+        std::uint32_t m_ui_cmd_index{0};
+        bool m_ui_cmd_valid{false};
+        VkFormat m_ui_cmd_format{VK_FORMAT_UNDEFINED};
+        VkRenderingFlags m_ui_cmd_rendering_flags{0}; // flags of the instance the recorded secondary executes in
+        UiFrameStats m_ui_stats{};
     };
+    // Runs the simulation on its own thread at a fixed tick: input arrives through a lock-free queue filled by the
+    // render thread, and results go back as immutable snapshots, so neither thread ever waits on the other.
     export class ViewpoertPlugin {
     public:
+        // Starts the tick thread.
         void initialize();
+        // Per-frame engine hook on the render thread. The simulation advances on the tick thread, so this only ticks
+        // inline when that thread is not running (tick rate 0).
         void update();
         void shutdown();
+
+        // Ticks per second, 0 to tick inline from update(); only honoured if set before initialize.
+        void set_tick_rate(double hz) {
+            m_tick_rate = hz;
+        }
+        // Render thread (the queue's only producer). Returns false and counts a drop when the queue is full.
+        bool push_input(const InputEvent& event);
+        // Render thread only: the newest published state, unchanged until the next call.
+        [[nodiscard]] const ViewportState& snapshot() {
+            return m_snapshots.latest();
+        }
+
+    private:
+        void run(const std::stop_token& stop);
+        void tick(double dt);
+
+        InputQueue m_input{};
+        SnapshotBuffer<ViewportState> m_snapshots{};
+        ViewportState m_state{}; // tick thread only
+        std::atomic<std::uint64_t> m_dropped{0};
+        std::chrono::steady_clock::time_point m_last_update{};
+        double m_tick_rate{120.0};
+        std::jthread m_thread{}; // last, so it is joined before the state it uses is destroyed
     };
 } // namespace vk::plugins
@@ -0,0 +1,266 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.batch;
+import vk.plugins.shader;
+
+namespace vk::plugins {
+    namespace {
+        constexpr VkDeviceSize kIndirectStride      = kBatchIndirectStride;
+        constexpr VkDeviceSize kIndirectCountOffset = sizeof(VkDrawIndexedIndirectCommand);
+        constexpr std::uint32_t kInitialCapacity    = 1024;
+        constexpr std::array<std::uint16_t, 6> kQuadIndices{0, 1, 2, 2, 3, 0};
+
+        struct BatchPush {
+            float view_proj[16];
+            std::uint32_t use_visible_list;
+        };
+
+        double to_us(std::chrono::nanoseconds ns) {
+            return std::chrono::duration<double, std::micro>(ns).count();
+        }
+    } // namespace
+} // namespace vk::plugins
+
+void vk::plugins::BatchRenderer::initialize(const context::EngineContext& eng, VkFormat color_format, PipelineBuildScheduler& builds, const DeviceFeatures& features, DescriptorAllocator& descriptors) {
+    // Physical support is not enough: vkCmdDrawIndexedIndirectCount needs the feature enabled on the device.
+    this->m_indirect_count = features.draw_indirect_count;
+
+    const std::array<VkDescriptorSetLayoutBinding, 2> bindings{{
+        {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT}, // instances
+        {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT}, // visible indices
+    }};
+    // One long-lived set per frame slot, rewritten in prepare() only when the buffers were reallocated.
+    m_set_layout = descriptors.create_layout(bindings);
+    for (auto& set : m_sets) set = descriptors.allocate(m_set_layout);
+
+    const VkPushConstantRange push{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset     = 0,
+        .size       = sizeof(BatchPush),
+    };
+    const VkPipelineLayoutCreateInfo plci{
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &m_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+    VK_CHECK(vkCreatePipelineLayout(eng.device, &plci, nullptr, &m_layout));
+
+    this->m_indirect = create_buffer(eng, kIndirectStride * context::FRAME_OVERLAP, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_queue_families);
+    std::memset(m_indirect.mapped, 0, m_indirect.size);
+    this->m_indices = create_buffer(eng, sizeof(kQuadIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::memcpy(m_indices.mapped, kQuadIndices.data(), sizeof(kQuadIndices));
+    this->ensure_capacity(eng, kInitialCapacity);
+
+    auto& shaders       = ShaderLibrary::shared();
+    this->m_vert_shader = shaders.acquire(eng, "shader/viewport_batch.vert.spv");
+    this->m_frag_shader = shaders.acquire(eng, "shader/viewport.frag.spv");
+
+    GraphicsPipelineDesc desc{
+        .vert_shader  = m_vert_shader,
+        .frag_shader  = m_frag_shader,
+        .layout       = m_layout,
+        .color_format = color_format,
+        .name         = "viewport_batch",
+    };
+    this->m_pending_pipeline = builds.submit(std::move(desc));
+}
+void vk::plugins::BatchRenderer::destroy(const context::EngineContext& eng) {
+    // The owner drains the build scheduler first, so a pending ticket is always finished here.
+    if (m_pending_pipeline) {
+        vkDestroyPipeline(eng.device, m_pending_pipeline->pipeline, nullptr);
+        m_pending_pipeline.reset();
+    }
+    vkDestroyPipeline(eng.device, m_pipeline, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+    ShaderLibrary::shared().release(eng, m_vert_shader);
+    ShaderLibrary::shared().release(eng, m_frag_shader);
+
+    for (auto& r : m_retired) destroy_buffer(eng, r.buffer);
+    m_retired.clear();
+    destroy_buffer(eng, m_instances);
+    destroy_buffer(eng, m_visible);
+    destroy_buffer(eng, m_indirect);
+    destroy_buffer(eng, m_indices);
+    m_capacity = 0;
+
+    vkDestroyPipelineLayout(eng.device, m_layout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+    // The layout and sets belong to the descriptor allocator.
+    m_set_layout = VK_NULL_HANDLE;
+    m_sets       = {};
+}
+void vk::plugins::BatchRenderer::set_instances(std::span<const InstanceData> instances) {
+    m_scene.assign(instances.begin(), instances.end());
+    ++m_generation;
+}
+void vk::plugins::BatchRenderer::set_view_projection(const std::array<float, 16>& view_proj) {
+    m_view_proj = view_proj;
+}
+void vk::plugins::BatchRenderer::populate_benchmark_scene(std::uint32_t count) {
+    const auto side   = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(count, 1u)))));
+    const float cell  = 1.9f / static_cast<float>(side);
+    const float scale = 0.4f * cell;
+
+    std::vector<InstanceData> instances(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint32_t x = i % side;
+        const std::uint32_t y = i / side;
+        std::uint32_t h       = i * 0x9e3779b1u;
+        h ^= h >> 15;
+        instances[i] = {
+            .position = {-0.95f + (static_cast<float>(x) + 0.5f) * cell, -0.95f + (static_cast<float>(y) + 0.5f) * cell, 0.0f},
+            .scale    = scale,
+            .color    = {static_cast<float>(h & 0xffu) / 255.0f, static_cast<float>((h >> 8) & 0xffu) / 255.0f, static_cast<float>((h >> 16) & 0xffu) / 255.0f, 1.0f},
+        };
+    }
+    set_instances(instances);
+}
+void vk::plugins::BatchRenderer::start_benchmark(std::vector<std::uint32_t> steps, std::uint32_t frames_per_step) {
+    m_benchmark = {.steps = std::move(steps), .step = 0, .frames_per_step = std::max(frames_per_step, 1u)};
+    if (!m_benchmark.steps.empty()) populate_benchmark_scene(m_benchmark.steps.front());
+}
+void vk::plugins::BatchRenderer::prepare(const context::EngineContext& eng, std::uint32_t frame_slot) {
+    ++m_frame;
+    std::erase_if(m_retired, [&](Retired& r) {
+        if (r.release_frame > m_frame) return false;
+        destroy_buffer(eng, r.buffer);
+        return true;
+    });
+
+    const auto count = static_cast<std::uint32_t>(m_scene.size());
+    ensure_capacity(eng, count);
+
+    // This slot's previous frame has retired, so its descriptor set and region are free to rewrite.
+    if (m_slot_buffer_generation[frame_slot] != m_buffer_generation) {
+        const VkDescriptorBufferInfo infos[2]{instance_region(frame_slot), visible_region(frame_slot)};
+        const VkWriteDescriptorSet write{
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_sets[frame_slot],
+            .dstBinding      = 0,
+            .descriptorCount = 2,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = infos,
+        };
+        vkUpdateDescriptorSets(eng.device, 1, &write, 0, nullptr);
+        m_slot_buffer_generation[frame_slot] = m_buffer_generation;
+    }
+
+    m_stats.bytes_uploaded = 0;
+    if (m_slot_generation[frame_slot] != m_generation) {
+        auto* region = static_cast<std::byte*>(m_instances.mapped) + frame_slot * m_region_size;
+        std::memcpy(region, m_scene.data(), m_scene.size() * sizeof(InstanceData));
+        m_stats.bytes_uploaded        = m_scene.size() * sizeof(InstanceData);
+        m_slot_generation[frame_slot] = m_generation;
+    }
+
+    // Rewritten every frame (a few bytes): a culling pass may have left a compacted instance count here.
+    const VkDrawIndexedIndirectCommand draw{
+        .indexCount    = static_cast<std::uint32_t>(kQuadIndices.size()),
+        .instanceCount = count,
+    };
+    const std::uint32_t draw_count = count > 0 ? 1u : 0u;
+    auto* indirect                 = static_cast<std::byte*>(m_indirect.mapped) + indirect_offset(frame_slot);
+    std::memcpy(indirect, &draw, sizeof(draw));
+    std::memcpy(indirect + kIndirectCountOffset, &draw_count, sizeof(draw_count));
+    m_stats.bytes_uploaded += kIndirectStride;
+    m_stats.instances = count;
+}
+void vk::plugins::BatchRenderer::record(VkCommandBuffer cmd, VkExtent2D extent, std::uint32_t frame_slot) {
+    poll_pipeline();
+    const auto t0 = std::chrono::steady_clock::now();
+    record_view(cmd, {{0, 0}, extent}, m_view_proj, frame_slot, true);
+    finish_views(1, std::chrono::steady_clock::now() - t0);
+}
+void vk::plugins::BatchRenderer::finish_views(std::uint32_t views, std::chrono::nanoseconds record_time) {
+    // record_view draws nothing until the pipeline is ready, so neither do the stats.
+    m_stats.draw_calls = m_pipeline == VK_NULL_HANDLE || m_scene.empty() ? 0 : views;
+    if (m_stats.draw_calls == 0) return;
+    m_stats.cpu_record_time = record_time;
+    advance_benchmark();
+}
+void vk::plugins::BatchRenderer::poll_pipeline() {
+    if (m_pending_pipeline && m_pending_pipeline->ready.load(std::memory_order_acquire)) {
+        m_pipeline = std::exchange(m_pending_pipeline->pipeline, VK_NULL_HANDLE);
+        m_pending_pipeline.reset();
+    }
+}
+void vk::plugins::BatchRenderer::record_view(VkCommandBuffer cmd, VkRect2D area, const std::array<float, 16>& view_proj, std::uint32_t frame_slot, bool primary) const {
+    if (m_pipeline == VK_NULL_HANDLE || m_scene.empty()) return;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    const VkViewport viewport{
+        .x        = static_cast<float>(area.offset.x),
+        .y        = static_cast<float>(area.offset.y),
+        .width    = static_cast<float>(area.extent.width),
+        .height   = static_cast<float>(area.extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &area);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout, 0, 1, &m_sets[frame_slot], 0, nullptr);
+    BatchPush push{.use_visible_list = primary && m_use_visible_list ? 1u : 0u};
+    std::memcpy(push.view_proj, view_proj.data(), sizeof(push.view_proj));
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+    vkCmdBindIndexBuffer(cmd, m_indices.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+    if (!primary) {
+        vkCmdDrawIndexed(cmd, static_cast<std::uint32_t>(kQuadIndices.size()), static_cast<std::uint32_t>(m_scene.size()), 0, 0, 0);
+        return;
+    }
+    const VkDeviceSize offset = indirect_offset(frame_slot);
+    if (m_indirect_count) {
+        vkCmdDrawIndexedIndirectCount(cmd, m_indirect.buffer, offset, m_indirect.buffer, offset + kIndirectCountOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+    } else {
+        vkCmdDrawIndexedIndirect(cmd, m_indirect.buffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+VkDeviceSize vk::plugins::BatchRenderer::indirect_offset(std::uint32_t frame_slot) const {
+    return frame_slot * kIndirectStride;
+}
+void vk::plugins::BatchRenderer::ensure_capacity(const context::EngineContext& eng, std::uint32_t count) {
+    if (count <= m_capacity) return;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(eng.physical, &props);
+    const std::uint32_t capacity = std::max({count, m_capacity * 2, kInitialCapacity});
+    const VkDeviceSize region    = align_up(VkDeviceSize{capacity} * sizeof(InstanceData), props.limits.minStorageBufferOffsetAlignment);
+
+    // In-flight frames may still read the old buffer through their descriptor sets; free it once they retired.
+    const VkDeviceSize visible_region = align_up(VkDeviceSize{capacity} * sizeof(std::uint32_t), props.limits.minStorageBufferOffsetAlignment);
+    if (m_instances.buffer != VK_NULL_HANDLE) m_retired.push_back({std::exchange(m_instances, GpuBuffer{}), m_frame + context::FRAME_OVERLAP});
+    if (m_visible.buffer != VK_NULL_HANDLE) m_retired.push_back({std::exchange(m_visible, GpuBuffer{}), m_frame + context::FRAME_OVERLAP});
+    m_instances           = create_buffer(eng, region * context::FRAME_OVERLAP, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_queue_families);
+    m_visible             = create_buffer(eng, visible_region * context::FRAME_OVERLAP, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_queue_families);
+    m_region_size         = region;
+    m_visible_region_size = visible_region;
+    m_capacity            = capacity;
+    ++m_buffer_generation;
+    m_slot_generation.fill(~0ull);
+}
+void vk::plugins::BatchRenderer::advance_benchmark() {
+    if (m_benchmark.step >= m_benchmark.steps.size()) return;
+
+    m_benchmark.record_time += m_stats.cpu_record_time;
+    if (++m_benchmark.frames < m_benchmark.frames_per_step) return;
+
+    std::println("[batch-bench] {:>8} instances: {} draw call(s), cpu record {:.2f} us/frame", m_stats.instances, m_stats.draw_calls, to_us(m_benchmark.record_time) / m_benchmark.frames);
+    m_benchmark.frames      = 0;
+    m_benchmark.record_time = {};
+    if (++m_benchmark.step < m_benchmark.steps.size()) populate_benchmark_scene(m_benchmark.steps[m_benchmark.step]);
+}
@@ -0,0 +1,51 @@
+module;
+#include <stdexcept>
+#include <string>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.buffer;
+
+std::uint32_t vk::plugins::find_memory_type(const context::EngineContext& eng, std::uint32_t type_bits, VkMemoryPropertyFlags required) {
+    VkPhysicalDeviceMemoryProperties props{};
+    vkGetPhysicalDeviceMemoryProperties(eng.physical, &props);
+    for (std::uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+        if ((type_bits & (1u << i)) && (props.memoryTypes[i].propertyFlags & required) == required) return i;
+    }
+    throw std::runtime_error("No memory type with properties " + std::to_string(required));
+}
+vk::plugins::GpuBuffer vk::plugins::create_buffer(const context::EngineContext& eng, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, std::span<const std::uint32_t> queue_families) {
+    GpuBuffer out{.size = size};
+    const bool shared = queue_families.size() > 1;
+    const VkBufferCreateInfo bci{
+        .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size                  = size,
+        .usage                 = usage,
+        .sharingMode           = shared ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = shared ? static_cast<std::uint32_t>(queue_families.size()) : 0u,
+        .pQueueFamilyIndices   = shared ? queue_families.data() : nullptr,
+    };
+    VK_CHECK(vkCreateBuffer(eng.device, &bci, nullptr, &out.buffer));
+
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(eng.device, out.buffer, &req);
+    const VkMemoryAllocateFlagsInfo flags{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    };
+    const VkMemoryAllocateInfo mai{
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &flags : nullptr,
+        .allocationSize  = req.size,
+        .memoryTypeIndex = find_memory_type(eng, req.memoryTypeBits, properties),
+    };
+    VK_CHECK(vkAllocateMemory(eng.device, &mai, nullptr, &out.memory));
+    VK_CHECK(vkBindBufferMemory(eng.device, out.buffer, out.memory, 0));
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) VK_CHECK(vkMapMemory(eng.device, out.memory, 0, VK_WHOLE_SIZE, 0, &out.mapped));
+    return out;
+}
+void vk::plugins::destroy_buffer(const context::EngineContext& eng, GpuBuffer& buffer) {
+    if (buffer.mapped) vkUnmapMemory(eng.device, buffer.memory);
+    vkDestroyBuffer(eng.device, buffer.buffer, nullptr);
+    vkFreeMemory(eng.device, buffer.memory, nullptr);
+    buffer = GpuBuffer{};
+}
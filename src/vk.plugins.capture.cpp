@@ -0,0 +1,296 @@
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.capture;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::array<std::uint32_t, 256> kCrcTable = [] {
+            std::array<std::uint32_t, 256> table{};
+            for (std::uint32_t n = 0; n < 256; ++n) {
+                std::uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            return table;
+        }();
+
+        std::uint32_t crc32(std::span<const std::byte> data) {
+            std::uint32_t c = 0xFFFFFFFFu;
+            for (const std::byte b : data) c = kCrcTable[(c ^ static_cast<std::uint8_t>(b)) & 0xFF] ^ (c >> 8);
+            return c ^ 0xFFFFFFFFu;
+        }
+        void put_be32(std::vector<std::byte>& out, std::uint32_t v) {
+            for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<std::byte>((v >> shift) & 0xFF));
+        }
+        void put_chunk(std::vector<std::byte>& out, const char (&type)[5], std::span<const std::byte> data) {
+            put_be32(out, static_cast<std::uint32_t>(data.size()));
+            const std::size_t start = out.size();
+            for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::byte>(type[i]));
+            out.insert(out.end(), data.begin(), data.end());
+            put_be32(out, crc32(std::span(out).subspan(start)));
+        }
+
+        bool is_bgra(VkFormat format) {
+            return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+        }
+        bool is_rgba8(VkFormat format) {
+            return is_bgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+        }
+
+        VkMemoryPropertyFlags readback_memory(const context::EngineContext& eng) {
+            // Cached memory makes the writer's reads fast; fall back to plain coherent memory where there is none.
+            constexpr VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            VkPhysicalDeviceMemoryProperties props{};
+            vkGetPhysicalDeviceMemoryProperties(eng.physical, &props);
+            for (std::uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+                if ((props.memoryTypes[i].propertyFlags & cached) == cached) return cached;
+            }
+            return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        }
+    } // namespace
+
+    std::vector<std::byte> encode_png(std::span<const std::byte> pixels, std::uint32_t width, std::uint32_t height, bool bgra) {
+        const std::size_t row_bytes = static_cast<std::size_t>(width) * 4;
+        if (pixels.size() < row_bytes * height) throw std::invalid_argument("encode_png: pixel buffer smaller than width * height * 4");
+
+        // Scanlines with filter type 0, swizzled to RGBA.
+        std::vector<std::byte> scanlines((row_bytes + 1) * height);
+        for (std::uint32_t y = 0; y < height; ++y) {
+            std::byte* dst       = scanlines.data() + y * (row_bytes + 1);
+            const std::byte* src = pixels.data() + y * row_bytes;
+            dst[0]               = std::byte{0};
+            std::memcpy(dst + 1, src, row_bytes);
+            if (bgra)
+                for (std::size_t x = 0; x < row_bytes; x += 4) std::swap(dst[1 + x], dst[1 + x + 2]);
+        }
+
+        // zlib stream of stored deflate blocks.
+        std::vector<std::byte> zlib{std::byte{0x78}, std::byte{0x01}};
+        zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+        std::size_t offset = 0;
+        do {
+            const auto len   = static_cast<std::uint16_t>(std::min<std::size_t>(65535, scanlines.size() - offset));
+            const bool final = offset + len == scanlines.size();
+            zlib.push_back(static_cast<std::byte>(final ? 1 : 0));
+            zlib.push_back(static_cast<std::byte>(len & 0xFF));
+            zlib.push_back(static_cast<std::byte>(len >> 8));
+            zlib.push_back(static_cast<std::byte>(~len & 0xFF));
+            zlib.push_back(static_cast<std::byte>((~len >> 8) & 0xFF));
+            zlib.insert(zlib.end(), scanlines.begin() + static_cast<std::ptrdiff_t>(offset), scanlines.begin() + static_cast<std::ptrdiff_t>(offset + len));
+            offset += len;
+        } while (offset < scanlines.size());
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        for (const std::byte v : scanlines) {
+            a = (a + static_cast<std::uint8_t>(v)) % 65521;
+            b = (b + a) % 65521;
+        }
+        put_be32(zlib, (b << 16) | a);
+
+        std::vector<std::byte> out{std::byte{0x89}, std::byte{'P'}, std::byte{'N'}, std::byte{'G'}, std::byte{'\r'}, std::byte{'\n'}, std::byte{0x1A}, std::byte{'\n'}};
+        std::vector<std::byte> ihdr;
+        put_be32(ihdr, width);
+        put_be32(ihdr, height);
+        ihdr.insert(ihdr.end(), {std::byte{8}, std::byte{6}, std::byte{0}, std::byte{0}, std::byte{0}}); // 8-bit RGBA, no interlace
+        put_chunk(out, "IHDR", ihdr);
+        put_chunk(out, "IDAT", zlib);
+        put_chunk(out, "IEND", {});
+        return out;
+    }
+} // namespace vk::plugins
+
+vk::plugins::FrameCapture::~FrameCapture() {
+    // destroy() must have run; the writer only references mapped memory the device owns.
+    m_writer.reset();
+}
+void vk::plugins::FrameCapture::initialize(const CaptureConfig& config) {
+    m_config                 = config;
+    m_config.ring_size       = std::max(m_config.ring_size, 1u);
+    m_config.every_nth_frame = std::max(m_config.every_nth_frame, 1u);
+    m_write_failed           = false;
+    std::filesystem::create_directories(m_config.output);
+    if (m_config.format == CaptureFormat::Chunked) {
+        const auto path = m_config.output / "capture.vvcap";
+        m_chunked.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_chunked) throw std::runtime_error("Cannot open capture file " + path.string());
+        const CaptureFileHeader header{};
+        m_chunked.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    m_ring.clear();
+    for (std::uint32_t i = 0; i < m_config.ring_size; ++i) m_ring.push_back(std::make_unique<Readback>());
+    m_writer = std::make_unique<ThreadPool>(1);
+}
+void vk::plugins::FrameCapture::destroy(const context::EngineContext& eng) {
+    if (!active()) return;
+    flush();
+    m_writer.reset();
+    for (auto& readback : m_ring) {
+        if (readback->buffer.buffer != VK_NULL_HANDLE) destroy_buffer(eng, readback->buffer);
+    }
+    m_ring.clear();
+    if (m_chunked.is_open()) m_chunked.close();
+
+    const auto s = stats();
+    std::println("[capture] {} frames written to {} ({} dropped, {:.1f} MiB)", s.written, m_config.output.string(), s.dropped, static_cast<double>(s.bytes_written) / (1024.0 * 1024.0));
+}
+void vk::plugins::FrameCapture::prepare(const context::EngineContext& eng, VkFormat format, VkExtent2D extent, std::uint32_t frame_slot) {
+    if (!active()) return;
+    if (!is_rgba8(format)) throw std::runtime_error("FrameCapture supports 8-bit RGBA/BGRA attachments only");
+
+    // The copy recorded in this slot last time round has completed: the engine waited on the slot's fence before
+    // calling prepare for it again (see the frame-slot contract above ViewportRenderer).
+    if (auto& done = m_slot_pending[frame_slot]) {
+        submit_write(*done);
+        done.reset();
+    }
+    // A reservation that never got its copy recorded (the frame was not finished) goes back to the ring.
+    if (m_next) m_ring[std::exchange(m_next, std::nullopt)->buffer]->state.store(BufferState::Free, std::memory_order_relaxed);
+    const std::uint64_t frame = m_frame++;
+    if (frame % m_config.every_nth_frame != 0) return;
+
+    std::uint32_t index = 0;
+    while (index < m_ring.size() && m_ring[index]->state.load(std::memory_order_acquire) != BufferState::Free) ++index;
+    if (index == m_ring.size()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto& readback          = *m_ring[index];
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    if (readback.buffer.size < size) {
+        if (readback.buffer.buffer != VK_NULL_HANDLE) destroy_buffer(eng, readback.buffer);
+        readback.buffer = create_buffer(eng, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, readback_memory(eng));
+    }
+    readback.state.store(BufferState::Gpu, std::memory_order_relaxed);
+    m_next = Pending{.slot = frame_slot, .buffer = index, .frame = frame, .format = format, .extent = extent};
+}
+void vk::plugins::FrameCapture::record(VkCommandBuffer cmd, VkImage image) {
+    if (!m_next) return;
+    const Pending next   = *std::exchange(m_next, std::nullopt);
+    const auto& readback = *m_ring[next.buffer];
+    const auto& buffer   = readback.buffer;
+
+    const VkBufferImageCopy region{
+        .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .imageExtent      = {next.extent.width, next.extent.height, 1},
+    };
+    vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_GENERAL, buffer.buffer, 1, &region);
+    const VkBufferMemoryBarrier2 to_host{
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = buffer.buffer,
+        .size                = VK_WHOLE_SIZE,
+    };
+    const VkDependencyInfo dep{
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers    = &to_host,
+    };
+    // Makes the copy available to the host; the fence the engine waits on before this slot comes round again (or the
+    // idle device before flush) is what makes it visible to the writer.
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    m_slot_pending[next.slot] = next;
+    ++m_captured;
+}
+void vk::plugins::FrameCapture::flush() {
+    if (!active()) return;
+    for (auto& pending : m_slot_pending) {
+        if (!pending) continue;
+        submit_write(*pending);
+        pending.reset();
+    }
+    m_writer->wait_idle();
+    if (m_chunked.is_open()) m_chunked.flush();
+}
+vk::plugins::CaptureStats vk::plugins::FrameCapture::stats() const {
+    return {
+        .captured      = m_captured,
+        .written       = m_written.load(std::memory_order_relaxed),
+        .dropped       = m_dropped.load(std::memory_order_relaxed),
+        .bytes_written = m_bytes_written.load(std::memory_order_relaxed),
+    };
+}
+void vk::plugins::FrameCapture::submit_write(const Pending& pending) {
+    m_ring[pending.buffer]->state.store(BufferState::Writing, std::memory_order_relaxed);
+    m_writer->submit([this, pending](std::uint32_t) {
+        write_frame(pending);
+        m_ring[pending.buffer]->state.store(BufferState::Free, std::memory_order_release);
+    });
+}
+void vk::plugins::FrameCapture::write_frame(const Pending& pending) {
+    const auto& buffer   = m_ring[pending.buffer]->buffer;
+    const auto row_pitch = pending.extent.width * 4;
+    const std::span pixels(static_cast<const std::byte*>(buffer.mapped), static_cast<std::size_t>(row_pitch) * pending.extent.height);
+
+    std::filesystem::path target = m_config.output;
+    std::uint64_t bytes          = 0;
+    bool ok                      = false;
+    switch (m_config.format) {
+    case CaptureFormat::Raw: {
+        target /= std::format("frame_{:06}_{}x{}.raw", pending.frame, pending.extent.width, pending.extent.height);
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+        out.close();
+        ok    = !out.fail();
+        bytes = pixels.size();
+        break;
+    }
+    case CaptureFormat::Png: {
+        const auto png = encode_png(pixels, pending.extent.width, pending.extent.height, is_bgra(pending.format));
+        target /= std::format("frame_{:06}.png", pending.frame);
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+        out.close();
+        ok    = !out.fail();
+        bytes = png.size();
+        break;
+    }
+    case CaptureFormat::Chunked: {
+        const CaptureChunkHeader header{
+            .frame     = pending.frame,
+            .width     = pending.extent.width,
+            .height    = pending.extent.height,
+            .format    = static_cast<std::uint32_t>(pending.format),
+            .row_pitch = row_pitch,
+            .size      = pixels.size(),
+        };
+        target /= "capture.vvcap";
+        m_chunked.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_chunked.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+        // Flushed per frame so a full disk shows up on the frame that hit it rather than at close.
+        m_chunked.flush();
+        ok    = !m_chunked.fail();
+        bytes = sizeof(header) + pixels.size();
+        break;
+    }
+    }
+    if (!ok) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        if (!std::exchange(m_write_failed, true)) std::println("[capture] writing frame {} to {} failed; this and every further failed frame counts as dropped", pending.frame, target.string());
+        return;
+    }
+    m_written.fetch_add(1, std::memory_order_relaxed);
+    m_bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+}
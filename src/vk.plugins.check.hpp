@@ -0,0 +1,11 @@
+// Internal to the plugin translation units: include from the global module fragment, after <vulkan/vulkan.h>.
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <vulkan/vulkan.h>
+
+// clang-format off
+#ifndef VK_CHECK
+#define VK_CHECK(x) do { VkResult _vk_check_res = (x); if (_vk_check_res != VK_SUCCESS) { throw std::runtime_error(std::string("Vulkan error ") + std::to_string(_vk_check_res) + " at " #x); } } while (false)
+#endif
+// clang-format on
@@ -0,0 +1,385 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.culling;
+import vk.plugins.shader;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::uint32_t kWorkgroupSize = 64;
+
+        struct CullPush {
+            float view_proj[16];
+            std::uint32_t instance_count;
+            std::uint32_t draw_record;
+            std::uint32_t hiz_mip_count;
+            std::uint32_t pad;
+        };
+
+        // Row i of a column-major matrix.
+        std::array<float, 4> row(const std::array<float, 16>& m, int i) {
+            return {m[i], m[4 + i], m[8 + i], m[12 + i]};
+        }
+        std::array<float, 4> transform(const std::array<float, 16>& m, float x, float y, float z) {
+            return {
+                m[0] * x + m[4] * y + m[8] * z + m[12],
+                m[1] * x + m[5] * y + m[9] * z + m[13],
+                m[2] * x + m[6] * y + m[10] * z + m[14],
+                m[3] * x + m[7] * y + m[11] * z + m[15],
+            };
+        }
+    } // namespace
+
+    Frustum extract_frustum(const std::array<float, 16>& view_proj) {
+        const auto r0 = row(view_proj, 0);
+        const auto r1 = row(view_proj, 1);
+        const auto r2 = row(view_proj, 2);
+        const auto r3 = row(view_proj, 3);
+        const std::array<std::array<float, 4>, 6> raw{{
+            {r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]}, // left
+            {r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]}, // right
+            {r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]}, // bottom
+            {r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]}, // top
+            {r2[0], r2[1], r2[2], r2[3]}, // near (z >= 0)
+            {r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]}, // far
+        }};
+        Frustum out{};
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            const auto& p   = raw[i];
+            const float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+            out[i]          = {{p[0] * inv, p[1] * inv, p[2] * inv}, p[3] * inv};
+        }
+        return out;
+    }
+    bool sphere_in_frustum(const Frustum& frustum, const float center[3], float radius) {
+        for (const Plane& p : frustum) {
+            if (p.normal[0] * center[0] + p.normal[1] * center[1] + p.normal[2] * center[2] + p.distance < -radius) return false;
+        }
+        return true;
+    }
+    HiZPyramid build_hiz_pyramid(std::span<const float> depth, std::uint32_t width, std::uint32_t height) {
+        if (depth.size() < static_cast<std::size_t>(width) * height) throw std::runtime_error("Depth buffer smaller than its extent");
+        HiZPyramid hiz;
+        hiz.levels.push_back({width, height, {depth.begin(), depth.begin() + static_cast<std::ptrdiff_t>(width) * height}});
+        while (hiz.levels.back().width > 1 || hiz.levels.back().height > 1) {
+            const auto& src = hiz.levels.back();
+            HiZPyramid::Level dst{std::max(1u, src.width / 2), std::max(1u, src.height / 2), {}};
+            dst.depth.resize(static_cast<std::size_t>(dst.width) * dst.height);
+            for (std::uint32_t y = 0; y < dst.height; ++y) {
+                for (std::uint32_t x = 0; x < dst.width; ++x) {
+                    // Odd source sizes fold the trailing row/column into the last destination texel.
+                    const std::uint32_t x0 = x * 2, x1 = (x == dst.width - 1) ? src.width - 1 : x * 2 + 1;
+                    const std::uint32_t y0 = y * 2, y1 = (y == dst.height - 1) ? src.height - 1 : y * 2 + 1;
+                    float m                = 0.0f;
+                    for (std::uint32_t sy = y0; sy <= y1; ++sy)
+                        for (std::uint32_t sx = x0; sx <= x1; ++sx) m = std::max(m, src.depth[static_cast<std::size_t>(sy) * src.width + sx]);
+                    dst.depth[static_cast<std::size_t>(y) * dst.width + x] = m;
+                }
+            }
+            hiz.levels.push_back(std::move(dst));
+        }
+        return hiz;
+    }
+    bool hiz_occluded(const HiZPyramid& hiz, const std::array<float, 16>& view_proj, const float center[3], float radius) {
+        if (hiz.levels.empty()) return false;
+
+        float min_u = 1.0f, min_v = 1.0f, max_u = 0.0f, max_v = 0.0f, min_z = 1.0f;
+        for (int i = 0; i < 8; ++i) {
+            const auto clip = transform(view_proj, center[0] + ((i & 1) ? radius : -radius), center[1] + ((i & 2) ? radius : -radius), center[2] + ((i & 4) ? radius : -radius));
+            if (clip[3] <= 1e-5f) return false; // crosses the camera plane: cannot be judged, keep it
+            const float u = clip[0] / clip[3] * 0.5f + 0.5f;
+            const float v = clip[1] / clip[3] * 0.5f + 0.5f;
+            min_u         = std::min(min_u, u);
+            max_u         = std::max(max_u, u);
+            min_v         = std::min(min_v, v);
+            max_v         = std::max(max_v, v);
+            min_z         = std::min(min_z, clip[2] / clip[3]);
+        }
+        min_u = std::clamp(min_u, 0.0f, 1.0f);
+        max_u = std::clamp(max_u, 0.0f, 1.0f);
+        min_v = std::clamp(min_v, 0.0f, 1.0f);
+        max_v = std::clamp(max_v, 0.0f, 1.0f);
+
+        // Pick the level where the footprint covers at most 2x2 texels, then take the max of those four.
+        const auto& base     = hiz.levels.front();
+        const float extent   = std::max((max_u - min_u) * static_cast<float>(base.width), (max_v - min_v) * static_cast<float>(base.height));
+        const auto level     = static_cast<std::size_t>(std::clamp(static_cast<int>(std::ceil(std::log2(std::max(extent, 1.0f)))), 0, static_cast<int>(hiz.levels.size()) - 1));
+        const auto& l        = hiz.levels[level];
+        const auto texel     = [&](float u, float v) {
+            const auto x = std::min(static_cast<std::uint32_t>(u * static_cast<float>(l.width)), l.width - 1);
+            const auto y = std::min(static_cast<std::uint32_t>(v * static_cast<float>(l.height)), l.height - 1);
+            return l.depth[static_cast<std::size_t>(y) * l.width + x];
+        };
+        const float occluder = std::max({texel(min_u, min_v), texel(max_u, min_v), texel(min_u, max_v), texel(max_u, max_v)});
+        return min_z > occluder;
+    }
+    float instance_radius(const InstanceData& instance) {
+        return instance.scale * 1.41421356f; // quad corners sit at +-scale in x and y
+    }
+    std::uint32_t cull_instances_cpu(std::span<const InstanceData> instances, const std::array<float, 16>& view_proj, const HiZPyramid* hiz, std::vector<std::uint32_t>& visible) {
+        const Frustum frustum = extract_frustum(view_proj);
+        std::uint32_t count   = 0;
+        for (std::uint32_t i = 0; i < instances.size(); ++i) {
+            const float radius = instance_radius(instances[i]);
+            if (!sphere_in_frustum(frustum, instances[i].position, radius)) continue;
+            if (hiz != nullptr && hiz_occluded(*hiz, view_proj, instances[i].position, radius)) continue;
+            visible.push_back(i);
+            ++count;
+        }
+        return count;
+    }
+} // namespace vk::plugins
+
+void vk::plugins::CullingPass::initialize(const context::EngineContext& eng, VkPipelineCache cache, DescriptorAllocator& descriptors) {
+    const std::array<VkDescriptorSetLayoutBinding, 4> bindings{{
+        {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT}, // instances
+        {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT}, // visible indices
+        {.binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT}, // indirect records
+        {.binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT}, // Hi-Z
+    }};
+    m_set_layout = descriptors.create_layout(bindings);
+    for (auto& set : m_sets) set = descriptors.allocate(m_set_layout);
+
+    const VkPushConstantRange push{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof(CullPush),
+    };
+    const VkPipelineLayoutCreateInfo plci{
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &m_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+    VK_CHECK(vkCreatePipelineLayout(eng.device, &plci, nullptr, &m_layout));
+
+    // Both variants up front; kUseHiZ is a specialization constant so the frustum-only variant carries no Hi-Z code.
+    auto& shaders  = ShaderLibrary::shared();
+    this->m_shader = shaders.acquire(eng, "shader/viewport_cull.comp.spv");
+    for (std::uint32_t variant = 0; variant < m_pipelines.size(); ++variant) {
+        const VkBool32 use_hiz = variant == 1 ? VK_TRUE : VK_FALSE;
+        const VkSpecializationMapEntry entry{.constantID = 0, .offset = 0, .size = sizeof(VkBool32)};
+        const VkSpecializationInfo specialization{
+            .mapEntryCount = 1,
+            .pMapEntries   = &entry,
+            .dataSize      = sizeof(use_hiz),
+            .pData         = &use_hiz,
+        };
+        VkPipelineShaderStageCreateInfo stage{};
+        VkPipelineShaderStageModuleIdentifierCreateInfoEXT identifier{};
+        ShaderRef hold{};
+        (void) shaders.describe_stage(eng, m_shader, VK_SHADER_STAGE_COMPUTE_BIT, stage, identifier, hold);
+        stage.pSpecializationInfo = &specialization;
+        const VkComputePipelineCreateInfo cpci{
+            .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage  = stage,
+            .layout = m_layout,
+        };
+        VK_CHECK(vkCreateComputePipelines(eng.device, cache, 1, &cpci, nullptr, &m_pipelines[variant]));
+    }
+    if (m_compute_queue != VK_NULL_HANDLE) this->create_async_resources(eng);
+}
+void vk::plugins::CullingPass::create_async_resources(const context::EngineContext& eng) {
+    const VkSemaphoreCreateInfo sci{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for (std::uint32_t slot = 0; slot < context::FRAME_OVERLAP; ++slot) {
+        const VkCommandPoolCreateInfo pci{
+            .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = m_compute_family,
+        };
+        VK_CHECK(vkCreateCommandPool(eng.device, &pci, nullptr, &m_compute_pools[slot]));
+        const VkCommandBufferAllocateInfo cai{
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool        = m_compute_pools[slot],
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        VK_CHECK(vkAllocateCommandBuffers(eng.device, &cai, &m_compute_cmds[slot]));
+        VK_CHECK(vkCreateSemaphore(eng.device, &sci, nullptr, &m_culled[slot]));
+    }
+
+    // The handoff never changes, so it is recorded once and resubmitted every frame.
+    const VkCommandPoolCreateInfo pci{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = eng.graphics_queue_family,
+    };
+    VK_CHECK(vkCreateCommandPool(eng.device, &pci, nullptr, &m_handoff_pool));
+    const VkCommandBufferAllocateInfo cai{
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = m_handoff_pool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    VK_CHECK(vkAllocateCommandBuffers(eng.device, &cai, &m_handoff_cmd));
+    const VkCommandBufferBeginInfo bi{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT};
+    VK_CHECK(vkBeginCommandBuffer(m_handoff_cmd, &bi));
+    const VkMemoryBarrier2 barrier{
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT,
+        .dstStageMask  = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+    };
+    const VkDependencyInfo dep{
+        .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers    = &barrier,
+    };
+    vkCmdPipelineBarrier2(m_handoff_cmd, &dep);
+    VK_CHECK(vkEndCommandBuffer(m_handoff_cmd));
+}
+void vk::plugins::CullingPass::destroy(const context::EngineContext& eng) {
+    for (auto& p : m_pipelines) {
+        vkDestroyPipeline(eng.device, p, nullptr);
+        p = VK_NULL_HANDLE;
+    }
+    ShaderLibrary::shared().release(eng, m_shader);
+    for (std::uint32_t slot = 0; slot < context::FRAME_OVERLAP; ++slot) {
+        vkDestroySemaphore(eng.device, m_culled[slot], nullptr);
+        vkDestroyCommandPool(eng.device, m_compute_pools[slot], nullptr);
+    }
+    vkDestroyCommandPool(eng.device, m_handoff_pool, nullptr);
+    m_culled        = {};
+    m_compute_pools = {};
+    m_compute_cmds  = {};
+    m_handoff_pool  = VK_NULL_HANDLE;
+    m_handoff_cmd   = VK_NULL_HANDLE;
+    vkDestroyPipelineLayout(eng.device, m_layout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+    // The layout and sets belong to the descriptor allocator.
+    m_set_layout = VK_NULL_HANDLE;
+    m_sets       = {};
+}
+void vk::plugins::CullingPass::set_hiz_source(VkImageView view, VkSampler sampler, std::uint32_t mip_count) {
+    m_hiz_view    = view;
+    m_hiz_sampler = sampler;
+    m_hiz_mips    = view != VK_NULL_HANDLE ? mip_count : 0;
+    ++m_hiz_generation;
+}
+void vk::plugins::CullingPass::record(VkCommandBuffer cmd, const context::EngineContext& eng, BatchRenderer& batch, std::uint32_t frame_slot, RenderGraph& graph) {
+    const auto count = static_cast<std::uint32_t>(batch.scene().size());
+    m_stats          = {};
+    batch.set_use_visible_list(m_enabled && count > 0);
+    if (!m_enabled || count == 0) return;
+
+    update_set(eng, batch, frame_slot);
+
+    // The Hi-Z pyramid is an exclusive graphics-queue image, so occlusion culling stays on the graphics queue.
+    const bool async = submits_async();
+    if (async) {
+        submit_async(eng, batch, frame_slot);
+    } else {
+        const auto [draw, visible] = record_dispatch(cmd, batch, frame_slot, graph);
+        graph.use(draw, states::kIndirectRead);
+        graph.use(visible, states::kVertexStorageRead);
+    }
+
+    m_stats = {.dispatches = 1, .instances_tested = count, .async = async};
+}
+std::array<vk::plugins::ResourceId, 2> vk::plugins::CullingPass::record_dispatch(VkCommandBuffer cmd, const BatchRenderer& batch, std::uint32_t frame_slot, RenderGraph& graph) {
+    const auto count               = static_cast<std::uint32_t>(batch.scene().size());
+    const VkDeviceSize draw_offset = batch.indirect_offset(frame_slot);
+    const auto visible_region      = batch.visible_region(frame_slot);
+    const ResourceId draw          = graph.import_buffer(batch.indirect_buffer(), draw_offset, sizeof(VkDrawIndexedIndirectCommand), states::kUntouched);
+    const ResourceId visible       = graph.import_buffer(visible_region.buffer, visible_region.offset, visible_region.range, states::kUntouched);
+
+    // instanceCount is the second word of VkDrawIndexedIndirectCommand; the shader bumps it per survivor.
+    graph.use(draw, states::kTransferWrite);
+    graph.flush(cmd);
+    vkCmdFillBuffer(cmd, batch.indirect_buffer(), draw_offset + sizeof(std::uint32_t), sizeof(std::uint32_t), 0);
+    graph.use(draw, states::kComputeReadWrite);
+    graph.use(visible, states::kComputeReadWrite);
+    graph.flush(cmd);
+
+    const bool use_hiz = m_hiz_view != VK_NULL_HANDLE;
+    CullPush push{
+        .instance_count = count,
+        .draw_record    = static_cast<std::uint32_t>(draw_offset / kBatchIndirectStride),
+        .hiz_mip_count  = m_hiz_mips,
+    };
+    std::memcpy(push.view_proj, batch.view_projection().data(), sizeof(push.view_proj));
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[use_hiz ? 1 : 0]);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &m_sets[frame_slot], 0, nullptr);
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdDispatch(cmd, (count + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1);
+    return {draw, visible};
+}
+void vk::plugins::CullingPass::submit_async(const context::EngineContext& eng, const BatchRenderer& batch, std::uint32_t frame_slot) {
+    // The slot's last compute submission is done: the graphics batch waiting on it ran before the frame the engine
+    // fenced for this slot, and the engine waited on that fence before recording.
+    VkCommandBuffer cmd = m_compute_cmds[frame_slot];
+    VK_CHECK(vkResetCommandPool(eng.device, m_compute_pools[frame_slot], 0));
+    const VkCommandBufferBeginInfo bi{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+    (void) record_dispatch(cmd, batch, frame_slot, m_compute_graph);
+    m_compute_graph.end_frame(cmd);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    // The buffers are shared concurrently with the compute family, so the semaphore is the whole handoff.
+    const VkCommandBufferSubmitInfo compute_cmd{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = cmd};
+    const VkSemaphoreSubmitInfo signal{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO, .semaphore = m_culled[frame_slot], .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT};
+    const VkSubmitInfo2 compute_submit{
+        .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .commandBufferInfoCount   = 1,
+        .pCommandBufferInfos      = &compute_cmd,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos    = &signal,
+    };
+    VK_CHECK(vkQueueSubmit2(m_compute_queue, 1, &compute_submit, VK_NULL_HANDLE));
+
+    // Everything submitted to the graphics queue after this batch, the engine's frame included, is ordered behind
+    // the culling by the wait and the barrier that follows it.
+    const VkSemaphoreSubmitInfo wait{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO, .semaphore = m_culled[frame_slot], .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT};
+    const VkCommandBufferSubmitInfo handoff{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = m_handoff_cmd};
+    const VkSubmitInfo2 graphics_submit{
+        .sType                  = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .waitSemaphoreInfoCount = 1,
+        .pWaitSemaphoreInfos    = &wait,
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos    = &handoff,
+    };
+    VK_CHECK(vkQueueSubmit2(eng.graphics_queue, 1, &graphics_submit, VK_NULL_HANDLE));
+}
+void vk::plugins::CullingPass::update_set(const context::EngineContext& eng, const BatchRenderer& batch, std::uint32_t frame_slot) {
+    if (m_slot_buffer_generation[frame_slot] == batch.buffer_generation() && m_slot_hiz_generation[frame_slot] == m_hiz_generation) return;
+
+    const VkDescriptorBufferInfo buffers[3]{
+        batch.instance_region(frame_slot),
+        batch.visible_region(frame_slot),
+        {batch.indirect_buffer(), 0, VK_WHOLE_SIZE},
+    };
+    const VkDescriptorImageInfo hiz{m_hiz_sampler, m_hiz_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    const VkWriteDescriptorSet writes[2]{
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_sets[frame_slot],
+            .dstBinding      = 0,
+            .descriptorCount = 3,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = buffers,
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_sets[frame_slot],
+            .dstBinding      = 3,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo      = &hiz,
+        },
+    };
+    // Binding 3 is only statically used by the Hi-Z variant, so it may stay unwritten without a source.
+    vkUpdateDescriptorSets(eng.device, m_hiz_view != VK_NULL_HANDLE ? 2 : 1, writes, 0, nullptr);
+    m_slot_buffer_generation[frame_slot] = batch.buffer_generation();
+    m_slot_hiz_generation[frame_slot]    = m_hiz_generation;
+}
@@ -0,0 +1,207 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.descriptor;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::array<const char*, DescriptorUsage::kTrackedTypes> kTypeNames{
+            "sampler", "combined image sampler", "sampled image", "storage image", "uniform texel buffer", "storage texel buffer", "uniform buffer", "storage buffer", "uniform buffer dynamic", "storage buffer dynamic", "input attachment",
+        };
+
+        std::string describe(const DescriptorUsage& usage) {
+            std::string out = std::to_string(usage.sets) + " sets";
+            for (std::uint32_t type = 0; type < DescriptorUsage::kTrackedTypes; ++type) {
+                if (usage.descriptors[type] == 0) continue;
+                out += ", " + std::to_string(usage.descriptors[type]) + " " + kTypeNames[type];
+            }
+            return out;
+        }
+    } // namespace
+
+    void DescriptorUsage::add(const DescriptorUsage& other) {
+        sets += other.sets;
+        for (std::uint32_t type = 0; type < kTrackedTypes; ++type) descriptors[type] += other.descriptors[type];
+    }
+    void DescriptorUsage::raise_to(const DescriptorUsage& other) {
+        sets = std::max(sets, other.sets);
+        for (std::uint32_t type = 0; type < kTrackedTypes; ++type) descriptors[type] = std::max(descriptors[type], other.descriptors[type]);
+    }
+    std::uint32_t DescriptorUsage::total_descriptors() const {
+        std::uint32_t total = 0;
+        for (const std::uint32_t count : descriptors) total += count;
+        return total;
+    }
+
+    DescriptorUsage layout_usage(std::span<const VkDescriptorSetLayoutBinding> bindings) {
+        DescriptorUsage usage{.sets = 1};
+        for (const auto& binding : bindings) {
+            if (binding.descriptorType < DescriptorUsage::kTrackedTypes) usage.descriptors[binding.descriptorType] += binding.descriptorCount;
+        }
+        return usage;
+    }
+    std::vector<VkDescriptorPoolSize> descriptor_pool_sizes(std::span<const DescriptorRatio> ratios, std::uint32_t sets) {
+        std::vector<VkDescriptorPoolSize> sizes;
+        sizes.reserve(ratios.size());
+        for (const auto& ratio : ratios) {
+            const auto count = static_cast<std::uint32_t>(std::ceil(ratio.per_set * static_cast<float>(sets)));
+            sizes.push_back({ratio.type, std::max(count, 1u)});
+        }
+        return sizes;
+    }
+    std::uint32_t next_pool_sets(std::uint32_t current, std::uint32_t max_sets) {
+        return std::min(current + std::max(current / 2, 1u), max_sets);
+    }
+} // namespace vk::plugins
+
+void vk::plugins::DescriptorPoolChain::initialize(const DescriptorPoolConfig& config) {
+    m_config                   = config;
+    m_config.max_sets_per_pool = std::max(m_config.max_sets_per_pool, 1u);
+    m_config.initial_sets      = std::clamp(m_config.initial_sets, 1u, m_config.max_sets_per_pool);
+    m_next_sets                = m_config.initial_sets;
+    m_growths                  = 0;
+    m_usage                    = {};
+}
+void vk::plugins::DescriptorPoolChain::destroy(VkDevice device) {
+    for (VkDescriptorPool pool : m_ready) vkDestroyDescriptorPool(device, pool, nullptr);
+    for (VkDescriptorPool pool : m_full) vkDestroyDescriptorPool(device, pool, nullptr);
+    m_ready.clear();
+    m_full.clear();
+    m_usage = {};
+}
+VkDescriptorSet vk::plugins::DescriptorPoolChain::allocate(VkDevice device, VkDescriptorSetLayout layout, const DescriptorUsage& usage) {
+    for (;;) {
+        const bool fresh = m_ready.empty();
+        const VkDescriptorSetAllocateInfo dsai{
+            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool     = acquire_pool(device),
+            .descriptorSetCount = 1,
+            .pSetLayouts        = &layout,
+        };
+        VkDescriptorSet set{VK_NULL_HANDLE};
+        const VkResult result = vkAllocateDescriptorSets(device, &dsai, &set);
+        if (result == VK_SUCCESS) {
+            m_usage.add(usage);
+            return set;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) VK_CHECK(result);
+        // A new pool that cannot hold the set means the ratios do not cover this layout; growing would not help.
+        if (fresh) throw std::runtime_error("Descriptor set does not fit an empty pool; the pool ratios do not cover its layout");
+        m_full.push_back(m_ready.back());
+        m_ready.pop_back();
+    }
+}
+void vk::plugins::DescriptorPoolChain::reset(VkDevice device) {
+    for (VkDescriptorPool pool : m_full) m_ready.push_back(pool);
+    m_full.clear();
+    for (VkDescriptorPool pool : m_ready) VK_CHECK(vkResetDescriptorPool(device, pool, 0));
+    m_usage = {};
+}
+VkDescriptorPool vk::plugins::DescriptorPoolChain::acquire_pool(VkDevice device) {
+    if (!m_ready.empty()) return m_ready.back();
+
+    const auto sizes = descriptor_pool_sizes(m_config.ratios, m_next_sets);
+    const VkDescriptorPoolCreateInfo dpci{
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = m_next_sets,
+        .poolSizeCount = static_cast<std::uint32_t>(sizes.size()),
+        .pPoolSizes    = sizes.data(),
+    };
+    VkDescriptorPool pool{VK_NULL_HANDLE};
+    VK_CHECK(vkCreateDescriptorPool(device, &dpci, nullptr, &pool));
+    if (!m_full.empty()) ++m_growths;
+    m_next_sets = next_pool_sets(m_next_sets, m_config.max_sets_per_pool);
+    m_ready.push_back(pool);
+    return pool;
+}
+
+void vk::plugins::DescriptorAllocator::initialize(const context::EngineContext& eng, const DescriptorPoolConfig& persistent, const DescriptorPoolConfig& per_frame) {
+    m_device = eng.device;
+    m_persistent.initialize(persistent);
+    for (auto& frame : m_frames) frame.initialize(per_frame);
+    m_frame_slot = 0;
+    m_frame_peak = {};
+}
+void vk::plugins::DescriptorAllocator::destroy(const context::EngineContext& eng) {
+    if (m_device == VK_NULL_HANDLE) return;
+    report();
+    m_persistent.destroy(eng.device);
+    for (auto& frame : m_frames) frame.destroy(eng.device);
+    for (VkDescriptorPool pool : m_fixed_pools) vkDestroyDescriptorPool(eng.device, pool, nullptr);
+    m_fixed_pools.clear();
+    for (const auto& [layout, usage] : m_layouts) vkDestroyDescriptorSetLayout(eng.device, layout, nullptr);
+    m_layouts.clear();
+    m_device = VK_NULL_HANDLE;
+}
+VkDescriptorSetLayout vk::plugins::DescriptorAllocator::create_layout(std::span<const VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags) {
+    const VkDescriptorSetLayoutCreateInfo dslci{
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .flags        = flags,
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings    = bindings.data(),
+    };
+    VkDescriptorSetLayout layout{VK_NULL_HANDLE};
+    VK_CHECK(vkCreateDescriptorSetLayout(m_device, &dslci, nullptr, &layout));
+    m_layouts.emplace(layout, layout_usage(bindings));
+    return layout;
+}
+VkDescriptorSet vk::plugins::DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    return m_persistent.allocate(m_device, layout, usage_of(layout));
+}
+VkDescriptorSet vk::plugins::DescriptorAllocator::allocate_frame(VkDescriptorSetLayout layout) {
+    return m_frames[m_frame_slot].allocate(m_device, layout, usage_of(layout));
+}
+void vk::plugins::DescriptorAllocator::begin_frame(std::uint32_t frame_slot) {
+    // The slot's previous frame has retired: record what it used, then recycle its pools in one call each.
+    auto& frame = m_frames[frame_slot];
+    m_frame_peak.raise_to(frame.usage());
+    frame.reset(m_device);
+    m_frame_slot = frame_slot;
+}
+VkDescriptorPool vk::plugins::DescriptorAllocator::create_fixed_pool(std::span<const VkDescriptorPoolSize> sizes, std::uint32_t max_sets, VkDescriptorPoolCreateFlags flags) {
+    const VkDescriptorPoolCreateInfo dpci{
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags         = flags,
+        .maxSets       = max_sets,
+        .poolSizeCount = static_cast<std::uint32_t>(sizes.size()),
+        .pPoolSizes    = sizes.data(),
+    };
+    VkDescriptorPool pool{VK_NULL_HANDLE};
+    VK_CHECK(vkCreateDescriptorPool(m_device, &dpci, nullptr, &pool));
+    m_fixed_pools.push_back(pool);
+    return pool;
+}
+vk::plugins::DescriptorAllocatorStats vk::plugins::DescriptorAllocator::stats() const {
+    DescriptorAllocatorStats out{
+        .persistent_pools = m_persistent.pool_count(),
+        .pool_growths     = m_persistent.growths(),
+        .persistent       = m_persistent.usage(),
+        .frame_peak       = m_frame_peak,
+    };
+    for (const auto& frame : m_frames) {
+        out.frame_pools += frame.pool_count();
+        out.pool_growths += frame.growths();
+    }
+    out.frame_peak.raise_to(m_frames[m_frame_slot].usage());
+    return out;
+}
+void vk::plugins::DescriptorAllocator::report() const {
+    const auto s = stats();
+    std::println("[descriptors] persistent: {} pools, {}", s.persistent_pools, describe(s.persistent));
+    std::println("[descriptors] per-frame peak: {} pools, {} ({} pool growths)", s.frame_pools, describe(s.frame_peak), s.pool_growths);
+}
+const vk::plugins::DescriptorUsage& vk::plugins::DescriptorAllocator::usage_of(VkDescriptorSetLayout layout) const {
+    const auto it = m_layouts.find(layout);
+    if (it == m_layouts.end()) throw std::invalid_argument("DescriptorAllocator: layout was not created by this allocator");
+    return it->second;
+}
@@ -0,0 +1,362 @@
+module;
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.headless;
+import vk.plugins.buffer;
+import vk.plugins.device;
+
+namespace vk::plugins {
+    namespace {
+        struct Candidate {
+            VkPhysicalDevice physical{VK_NULL_HANDLE};
+            std::uint32_t queue_family{0};
+            int score{-1};
+        };
+
+        Candidate pick_device(VkInstance instance, bool prefer_software) {
+            std::uint32_t count = 0;
+            VK_CHECK(vkEnumeratePhysicalDevices(instance, &count, nullptr));
+            std::vector<VkPhysicalDevice> devices(count);
+            VK_CHECK(vkEnumeratePhysicalDevices(instance, &count, devices.data()));
+
+            Candidate best{};
+            for (VkPhysicalDevice physical : devices) {
+                VkPhysicalDeviceProperties props{};
+                vkGetPhysicalDeviceProperties(physical, &props);
+                if (props.apiVersion < VK_API_VERSION_1_3) continue;
+
+                std::uint32_t family_count = 0;
+                vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, nullptr);
+                std::vector<VkQueueFamilyProperties> families(family_count);
+                vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, families.data());
+                for (std::uint32_t family = 0; family < family_count; ++family) {
+                    if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) continue;
+                    int score = 0;
+                    switch (props.deviceType) {
+                    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score = 4; break;
+                    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score = 3; break;
+                    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score = 2; break;
+                    case VK_PHYSICAL_DEVICE_TYPE_CPU: score = prefer_software ? 5 : 1; break;
+                    default: break;
+                    }
+                    if (score > best.score) best = {physical, family, score};
+                    break;
+                }
+            }
+            return best;
+        }
+
+        bool has_extension(VkPhysicalDevice physical, const char* name) {
+            std::uint32_t count = 0;
+            VK_CHECK(vkEnumerateDeviceExtensionProperties(physical, nullptr, &count, nullptr));
+            std::vector<VkExtensionProperties> extensions(count);
+            VK_CHECK(vkEnumerateDeviceExtensionProperties(physical, nullptr, &count, extensions.data()));
+            for (const auto& ext : extensions) {
+                if (std::strcmp(ext.extensionName, name) == 0) return true;
+            }
+            return false;
+        }
+
+        // A compute-only family, so work submitted there can overlap the graphics queue.
+        std::optional<std::uint32_t> find_compute_family(VkPhysicalDevice physical) {
+            std::uint32_t count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, nullptr);
+            std::vector<VkQueueFamilyProperties> families(count);
+            vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, families.data());
+            for (std::uint32_t family = 0; family < count; ++family) {
+                if ((families[family].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) return family;
+            }
+            return std::nullopt;
+        }
+
+        // Everything the runner creates, torn down in reverse on every exit path.
+        struct HeadlessDevice {
+            context::EngineContext eng{};
+            VkImage image{VK_NULL_HANDLE};
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            VkImageView view{VK_NULL_HANDLE};
+            std::array<VkCommandPool, context::FRAME_OVERLAP> pools{};
+            std::array<VkCommandBuffer, context::FRAME_OVERLAP> cmds{};
+            std::array<VkFence, context::FRAME_OVERLAP> fences{};
+            VkQueue compute_queue{VK_NULL_HANDLE};
+            std::uint32_t compute_family{0};
+
+            ~HeadlessDevice() {
+                if (eng.device != VK_NULL_HANDLE) {
+                    vkDeviceWaitIdle(eng.device);
+                    for (VkFence fence : fences) vkDestroyFence(eng.device, fence, nullptr);
+                    for (VkCommandPool pool : pools) vkDestroyCommandPool(eng.device, pool, nullptr);
+                    vkDestroyImageView(eng.device, view, nullptr);
+                    vkDestroyImage(eng.device, image, nullptr);
+                    vkFreeMemory(eng.device, memory, nullptr);
+                    vkDestroyDevice(eng.device, nullptr);
+                }
+                if (eng.instance != VK_NULL_HANDLE) vkDestroyInstance(eng.instance, nullptr);
+            }
+        };
+
+        DeviceFeatures create_device(HeadlessDevice& dev, const HeadlessConfig& config, bool async_compute, std::string& device_name) {
+            const VkApplicationInfo app{
+                .sType            = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+                .pApplicationName = "vulkan-visualizer headless",
+                .apiVersion       = VK_API_VERSION_1_3,
+            };
+            const VkInstanceCreateInfo ici{
+                .sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+                .pApplicationInfo = &app,
+            };
+            if (vkCreateInstance(&ici, nullptr, &dev.eng.instance) != VK_SUCCESS) throw NoSuitableDevice("No Vulkan instance available");
+
+            const Candidate candidate = pick_device(dev.eng.instance, config.prefer_software);
+            if (candidate.physical == VK_NULL_HANDLE) throw NoSuitableDevice("No Vulkan 1.3 device with a graphics queue");
+            VkPhysicalDeviceProperties props{};
+            vkGetPhysicalDeviceProperties(candidate.physical, &props);
+            device_name = props.deviceName;
+
+            // Enable what the plugins use whenever the device has it; only dynamic rendering and sync2 are required.
+            VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT identifier{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT};
+            VkPhysicalDeviceVulkan13Features features13{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+            VkPhysicalDeviceVulkan12Features features12{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES, .pNext = &features13};
+            VkPhysicalDeviceFeatures2 supported{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &features12};
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic3{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT};
+            const bool identifiers    = has_extension(candidate.physical, VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME);
+            const bool dynamic_state3 = has_extension(candidate.physical, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            if (identifiers) features13.pNext = &identifier;
+            if (dynamic_state3) {
+                dynamic3.pNext   = features13.pNext;
+                features13.pNext = &dynamic3;
+            }
+            vkGetPhysicalDeviceFeatures2(candidate.physical, &supported);
+            if (!features13.dynamicRendering || !features13.synchronization2) throw NoSuitableDevice(device_name + " lacks dynamic rendering or synchronization2");
+
+            // Only the extended dynamic state 3 features PipelineVariantCache sets while recording.
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT enable_dynamic3{
+                .sType                                   = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+                .extendedDynamicState3PolygonMode        = dynamic3.extendedDynamicState3PolygonMode,
+                .extendedDynamicState3ColorBlendEnable   = dynamic3.extendedDynamicState3ColorBlendEnable,
+                .extendedDynamicState3ColorBlendEquation = dynamic3.extendedDynamicState3ColorBlendEquation,
+            };
+            VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT enable_identifier{
+                .sType                  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT,
+                .shaderModuleIdentifier = identifier.shaderModuleIdentifier,
+            };
+            VkPhysicalDeviceVulkan13Features enable13{
+                .sType                        = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                .pipelineCreationCacheControl = features13.pipelineCreationCacheControl,
+                .synchronization2             = VK_TRUE,
+                .dynamicRendering             = VK_TRUE,
+            };
+            if (identifiers) enable13.pNext = &enable_identifier;
+            if (dynamic_state3) {
+                enable_dynamic3.pNext = enable13.pNext;
+                enable13.pNext        = &enable_dynamic3;
+            }
+            VkPhysicalDeviceVulkan12Features enable12{
+                .sType               = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .pNext               = &enable13,
+                .drawIndirectCount   = features12.drawIndirectCount,
+                .bufferDeviceAddress = features12.bufferDeviceAddress,
+            };
+            VkPhysicalDeviceFeatures2 enable{
+                .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext    = &enable12,
+                .features = {.fillModeNonSolid = supported.features.fillModeNonSolid, .pipelineStatisticsQuery = supported.features.pipelineStatisticsQuery},
+            };
+
+            const float priority = 1.0f;
+            std::vector<VkDeviceQueueCreateInfo> queues{{
+                .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = candidate.queue_family,
+                .queueCount       = 1,
+                .pQueuePriorities = &priority,
+            }};
+            // Without a compute-only family the renderer keeps its compute work on the graphics queue.
+            const auto compute_family = async_compute ? find_compute_family(candidate.physical) : std::nullopt;
+            if (compute_family) queues.push_back({.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, .queueFamilyIndex = *compute_family, .queueCount = 1, .pQueuePriorities = &priority});
+            std::vector<const char*> extensions;
+            if (identifiers) extensions.push_back(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME);
+            if (dynamic_state3) extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            const VkDeviceCreateInfo dci{
+                .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .pNext                   = &enable,
+                .queueCreateInfoCount    = static_cast<std::uint32_t>(queues.size()),
+                .pQueueCreateInfos       = queues.data(),
+                .enabledExtensionCount   = static_cast<std::uint32_t>(extensions.size()),
+                .ppEnabledExtensionNames = extensions.data(),
+            };
+            VK_CHECK(vkCreateDevice(candidate.physical, &dci, nullptr, &dev.eng.device));
+            dev.eng.physical              = candidate.physical;
+            dev.eng.graphics_queue_family = candidate.queue_family;
+            vkGetDeviceQueue(dev.eng.device, candidate.queue_family, 0, &dev.eng.graphics_queue);
+            if (compute_family) {
+                dev.compute_family = *compute_family;
+                vkGetDeviceQueue(dev.eng.device, *compute_family, 0, &dev.compute_queue);
+            }
+            return {
+                .shader_module_identifier        = identifiers && identifier.shaderModuleIdentifier == VK_TRUE,
+                .pipeline_creation_cache_control = enable13.pipelineCreationCacheControl == VK_TRUE,
+                .draw_indirect_count             = enable12.drawIndirectCount == VK_TRUE,
+                .pipeline_statistics_query       = enable.features.pipelineStatisticsQuery == VK_TRUE,
+                .buffer_device_address           = enable12.bufferDeviceAddress == VK_TRUE,
+                .fill_mode_non_solid             = enable.features.fillModeNonSolid == VK_TRUE,
+                .dynamic_polygon_mode            = dynamic_state3 && enable_dynamic3.extendedDynamicState3PolygonMode == VK_TRUE,
+                .dynamic_color_blend             = dynamic_state3 && enable_dynamic3.extendedDynamicState3ColorBlendEnable == VK_TRUE && enable_dynamic3.extendedDynamicState3ColorBlendEquation == VK_TRUE,
+            };
+        }
+
+        void create_attachment(HeadlessDevice& dev, const context::RendererCaps& caps, VkExtent2D extent) {
+            const auto& eng                    = dev.eng;
+            const VkFormat format              = caps.color_attachments.empty() ? VK_FORMAT_B8G8R8A8_UNORM : caps.color_attachments.front().format;
+            const VkImageUsageFlags usage      = caps.color_attachments.empty() ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT : caps.color_attachments.front().usage;
+            const VkImageAspectFlags aspect    = caps.color_attachments.empty() ? VK_IMAGE_ASPECT_COLOR_BIT : caps.color_attachments.front().aspect;
+            const VkImageLayout initial_layout = caps.color_attachments.empty() ? VK_IMAGE_LAYOUT_GENERAL : caps.color_attachments.front().initial_layout;
+            const VkImageCreateInfo ici{
+                .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType     = VK_IMAGE_TYPE_2D,
+                .format        = format,
+                .extent        = {extent.width, extent.height, 1},
+                .mipLevels     = 1,
+                .arrayLayers   = 1,
+                .samples       = VK_SAMPLE_COUNT_1_BIT,
+                .tiling        = VK_IMAGE_TILING_OPTIMAL,
+                .usage         = usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            };
+            VK_CHECK(vkCreateImage(eng.device, &ici, nullptr, &dev.image));
+            VkMemoryRequirements req{};
+            vkGetImageMemoryRequirements(eng.device, dev.image, &req);
+            const VkMemoryAllocateInfo mai{
+                .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize  = req.size,
+                .memoryTypeIndex = find_memory_type(eng, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+            };
+            VK_CHECK(vkAllocateMemory(eng.device, &mai, nullptr, &dev.memory));
+            VK_CHECK(vkBindImageMemory(eng.device, dev.image, dev.memory, 0));
+            const VkImageViewCreateInfo vci{
+                .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image            = dev.image,
+                .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+                .format           = format,
+                .subresourceRange = {aspect, 0, 1, 0, 1},
+            };
+            VK_CHECK(vkCreateImageView(eng.device, &vci, nullptr, &dev.view));
+
+            for (std::uint32_t i = 0; i < context::FRAME_OVERLAP; ++i) {
+                const VkCommandPoolCreateInfo pci{
+                    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                    .queueFamilyIndex = eng.graphics_queue_family,
+                };
+                VK_CHECK(vkCreateCommandPool(eng.device, &pci, nullptr, &dev.pools[i]));
+                const VkCommandBufferAllocateInfo cai{
+                    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool        = dev.pools[i],
+                    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1,
+                };
+                VK_CHECK(vkAllocateCommandBuffers(eng.device, &cai, &dev.cmds[i]));
+                const VkFenceCreateInfo fci{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+                VK_CHECK(vkCreateFence(eng.device, &fci, nullptr, &dev.fences[i]));
+            }
+
+            // The engine hands attachments over in their requested initial layout.
+            VkCommandBuffer cmd = dev.cmds[0];
+            const VkCommandBufferBeginInfo bi{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+            VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+            const VkImageMemoryBarrier2 barrier{
+                .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask     = VK_PIPELINE_STAGE_2_NONE,
+                .dstStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .dstAccessMask    = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                .oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout        = initial_layout,
+                .image            = dev.image,
+                .subresourceRange = {aspect, 0, 1, 0, 1},
+            };
+            const VkDependencyInfo dep{
+                .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .imageMemoryBarrierCount = 1,
+                .pImageMemoryBarriers    = &barrier,
+            };
+            vkCmdPipelineBarrier2(cmd, &dep);
+            VK_CHECK(vkEndCommandBuffer(cmd));
+            const VkSubmitInfo si{
+                .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount = 1,
+                .pCommandBuffers    = &cmd,
+            };
+            VK_CHECK(vkQueueSubmit(eng.graphics_queue, 1, &si, VK_NULL_HANDLE));
+            VK_CHECK(vkQueueWaitIdle(eng.graphics_queue));
+        }
+    } // namespace
+} // namespace vk::plugins
+
+vk::plugins::HeadlessStats vk::plugins::HeadlessRunner::run(ViewportRenderer& renderer, const HeadlessConfig& config) {
+    HeadlessStats stats{};
+    HeadlessDevice dev{};
+    context::RendererCaps caps{};
+    renderer.query_required_device_caps(caps);
+    renderer.set_device_features(create_device(dev, config, caps.allow_async_compute, stats.device_name));
+    renderer.set_compute_queue(dev.compute_queue, dev.compute_family);
+    renderer.get_capabilities(caps);
+    create_attachment(dev, caps, config.extent);
+
+    context::AttachmentView attachment{};
+    attachment.image  = dev.image;
+    attachment.view   = dev.view;
+    attachment.aspect = caps.color_attachments.empty() ? VK_IMAGE_ASPECT_COLOR_BIT : caps.color_attachments.front().aspect;
+    context::FrameContext frm{};
+    frm.extent            = config.extent;
+    frm.presentation_mode = context::PresentationMode::EngineBlit;
+    frm.color_attachments.push_back(attachment);
+
+    // A renderer that fails part way through initialize is destroyed like a running one, before `dev` tears down the
+    // device its partial state lives on.
+    try {
+        renderer.initialize(dev.eng, caps);
+        if (config.wait_for_pipelines) renderer.wait_for_pipeline_builds();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t frame = 0; frame < config.frames; ++frame) {
+            const std::uint32_t slot = frame % context::FRAME_OVERLAP;
+            VK_CHECK(vkWaitForFences(dev.eng.device, 1, &dev.fences[slot], VK_TRUE, UINT64_MAX));
+            VK_CHECK(vkResetFences(dev.eng.device, 1, &dev.fences[slot]));
+            VK_CHECK(vkResetCommandPool(dev.eng.device, dev.pools[slot], 0));
+
+            VkCommandBuffer cmd = dev.cmds[slot];
+            const VkCommandBufferBeginInfo bi{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+            VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+            renderer.record_graphics(cmd, dev.eng, frm);
+            VK_CHECK(vkEndCommandBuffer(cmd));
+
+            const VkCommandBufferSubmitInfo cbsi{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = cmd};
+            const VkSubmitInfo2 si{
+                .sType                  = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                .commandBufferInfoCount = 1,
+                .pCommandBufferInfos    = &cbsi,
+            };
+            VK_CHECK(vkQueueSubmit2(dev.eng.graphics_queue, 1, &si, dev.fences[slot]));
+        }
+        VK_CHECK(vkDeviceWaitIdle(dev.eng.device));
+        stats.frames  = config.frames;
+        stats.elapsed = std::chrono::steady_clock::now() - start;
+    } catch (...) {
+        vkDeviceWaitIdle(dev.eng.device);
+        renderer.destroy(dev.eng);
+        throw;
+    }
+    renderer.destroy(dev.eng);
+
+    const double ms = std::chrono::duration<double, std::milli>(stats.elapsed).count();
+    std::println("[headless] {} frames at {}x{} on {} in {:.1f} ms ({:.1f} fps)", stats.frames, config.extent.width, config.extent.height, stats.device_name, ms, ms > 0.0 ? stats.frames * 1000.0 / ms : 0.0);
+    return stats;
+}
@@ -0,0 +1,97 @@
+module;
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+module vk.plugins.hot_reload;
+
+namespace vk::plugins {
+    int compile_glsl(const std::filesystem::path& compiler, const std::filesystem::path& source, const std::filesystem::path& output) {
+        const auto quoted   = [](const std::filesystem::path& p) { return "\"" + p.string() + "\""; };
+        std::string command = quoted(compiler) + " --target-env=vulkan1.3 -O -c " + quoted(source) + " -o " + quoted(output);
+#ifdef _WIN32
+        // cmd.exe strips the outer quotes of a command line that starts with one.
+        command = "\"" + command + "\"";
+#endif
+        return std::system(command.c_str());
+    }
+} // namespace vk::plugins
+
+vk::plugins::FileWatcher::~FileWatcher() {
+    stop();
+}
+void vk::plugins::FileWatcher::start(std::chrono::milliseconds interval) {
+    stop();
+    m_thread = std::jthread([this, interval](std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            scan();
+            std::unique_lock lock(m_mutex);
+            m_wake.wait_for(lock, stop, interval, [] { return false; });
+        }
+    });
+}
+void vk::plugins::FileWatcher::stop() {
+    if (!m_thread.joinable()) return;
+    m_thread.request_stop();
+    m_thread.join();
+}
+void vk::plugins::FileWatcher::watch(const std::filesystem::path& path, Callback on_change) {
+    Entry entry{.path = path, .reported = stamp(path), .on_change = std::move(on_change)};
+    std::scoped_lock lock(m_mutex);
+    m_entries.push_back(std::move(entry));
+}
+void vk::plugins::FileWatcher::clear() {
+    std::scoped_lock lock(m_mutex);
+    m_entries.clear();
+    m_changes.clear();
+}
+void vk::plugins::FileWatcher::scan() {
+    std::vector<std::pair<std::filesystem::path, Callback>> settled;
+    {
+        std::scoped_lock lock(m_mutex);
+        for (Entry& entry : m_entries) {
+            const Stamp now = stamp(entry.path);
+            if (now == entry.reported) {
+                entry.settling = false;
+            } else if (entry.settling && now == entry.pending) {
+                entry.reported = now;
+                entry.settling = false;
+                if (now.exists) settled.emplace_back(entry.path, entry.on_change);
+            } else {
+                entry.pending  = now;
+                entry.settling = true;
+            }
+        }
+    }
+    if (settled.empty()) return;
+
+    // Callbacks may take a while (a shader compile), so they run unlocked; watch() and take_changes() stay responsive.
+    for (const auto& [path, on_change] : settled) {
+        if (on_change) on_change(path);
+    }
+    std::scoped_lock lock(m_mutex);
+    for (auto& [path, on_change] : settled) {
+        if (std::ranges::find(m_changes, path) == m_changes.end()) m_changes.push_back(std::move(path));
+    }
+}
+std::vector<std::filesystem::path> vk::plugins::FileWatcher::take_changes() {
+    std::scoped_lock lock(m_mutex);
+    return std::exchange(m_changes, {});
+}
+vk::plugins::FileWatcher::Stamp vk::plugins::FileWatcher::stamp(const std::filesystem::path& path) {
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return {};
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return {};
+    return {.time = time, .size = size, .exists = true};
+}
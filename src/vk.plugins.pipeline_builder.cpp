@@ -0,0 +1,204 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.pipeline_builder;
+import vk.plugins.shader;
+
+VkResult vk::plugins::GraphicsPipelineDesc::create(const context::EngineContext& eng, VkPipelineCache cache, VkPipeline& out) const {
+    auto& shaders = ShaderLibrary::shared();
+    VkPipelineShaderStageCreateInfo stages[2]{};
+    VkPipelineShaderStageModuleIdentifierCreateInfoEXT identifiers[2]{};
+    std::array<VkSpecializationMapEntry, std::tuple_size_v<decltype(specialization)>> spec_entries{};
+    for (std::uint32_t i = 0; i < specialization_count; ++i) spec_entries[i] = {.constantID = i, .offset = i * 4, .size = 4};
+    const VkSpecializationInfo spec_info{
+        .mapEntryCount = specialization_count,
+        .pMapEntries   = spec_entries.data(),
+        .dataSize      = specialization_count * sizeof(std::uint32_t),
+        .pData         = specialization.data(),
+    };
+    // Whoever requested the build may release its own references while this runs on a worker; these keep the modules
+    // the stages point at alive until the pipeline is created.
+    ShaderRef holds[2]{};
+    const auto describe_stages = [&] {
+        const bool vs_by_id = shaders.describe_stage(eng, vert_shader, VK_SHADER_STAGE_VERTEX_BIT, stages[0], identifiers[0], holds[0]);
+        const bool fs_by_id = shaders.describe_stage(eng, frag_shader, VK_SHADER_STAGE_FRAGMENT_BIT, stages[1], identifiers[1], holds[1]);
+        if (specialization_count > 0) stages[0].pSpecializationInfo = stages[1].pSpecializationInfo = &spec_info;
+        return vs_by_id || fs_by_id;
+    };
+    const bool by_identifier   = describe_stages();
+
+    const VkPipelineRenderingCreateInfo rendering_info{
+        .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount    = 1,
+        .pColorAttachmentFormats = &color_format,
+    };
+    const VkPipelineVertexInputStateCreateInfo vertex_input_state{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    const VkPipelineInputAssemblyStateCreateInfo input_assembly_state{
+        .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = topology,
+    };
+    const VkPipelineViewportStateCreateInfo viewport_state{
+        .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount  = 1,
+    };
+    const VkPipelineRasterizationStateCreateInfo rasterization_state{
+        .sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = polygon_mode,
+        .cullMode    = cull_mode,
+        .frontFace   = front_face,
+        .lineWidth   = 1.0f,
+    };
+    const VkPipelineMultisampleStateCreateInfo multisample_state{
+        .sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = samples,
+    };
+    const VkPipelineColorBlendStateCreateInfo color_blend_state{
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments    = &color_blend,
+    };
+    const VkPipelineDynamicStateCreateInfo dynamic_state{
+        .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<std::uint32_t>(dynamic_states.size()),
+        .pDynamicStates    = dynamic_states.data(),
+    };
+
+    VkGraphicsPipelineCreateInfo pci{
+        .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext               = &rendering_info,
+        .flags               = by_identifier ? VkPipelineCreateFlags{VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT} : VkPipelineCreateFlags{0},
+        .stageCount          = 2,
+        .pStages             = stages,
+        .pVertexInputState   = &vertex_input_state,
+        .pInputAssemblyState = &input_assembly_state,
+        .pViewportState      = &viewport_state,
+        .pRasterizationState = &rasterization_state,
+        .pMultisampleState   = &multisample_state,
+        .pColorBlendState    = &color_blend_state,
+        .pDynamicState       = &dynamic_state,
+        .layout              = layout,
+    };
+    VkResult result = vkCreateGraphicsPipelines(eng.device, cache, 1, &pci, nullptr, &out);
+    if (result == VK_PIPELINE_COMPILE_REQUIRED) {
+        // The driver no longer has the shaders cached; bring the modules back for this one build.
+        // The references release the modules again on every exit, including a throw from the second reacquire.
+        const ShaderRef vert = shaders.reacquire(eng, vert_shader);
+        const ShaderRef frag = vert ? shaders.reacquire(eng, frag_shader) : ShaderRef{};
+        if (!vert || !frag) throw std::runtime_error("Shader binaries changed on disk since the pipeline was first built.");
+        describe_stages();
+        pci.flags = 0;
+        result    = vkCreateGraphicsPipelines(eng.device, cache, 1, &pci, nullptr, &out);
+    }
+    return result;
+}
+
+void vk::plugins::PipelineBuildScheduler::initialize(const context::EngineContext& eng, PipelineCache& parent, std::uint32_t worker_count) {
+    this->m_eng    = &eng;
+    this->m_parent = &parent;
+    this->m_pool   = std::make_unique<ThreadPool>(worker_count);
+    this->m_stats  = PipelineBuildStats{};
+
+    std::size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(eng.device, parent.handle(), &size, nullptr));
+    std::vector<std::byte> seed(size);
+    VK_CHECK(vkGetPipelineCacheData(eng.device, parent.handle(), &size, seed.data()));
+
+    // One cache per worker, so compilations never contend on a shared cache inside the driver.
+    const VkPipelineCacheCreateInfo ci{
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = size,
+        .pInitialData    = seed.data(),
+    };
+    this->m_worker_caches.assign(m_pool->worker_count(), VK_NULL_HANDLE);
+    for (auto& cache : m_worker_caches) VK_CHECK(vkCreatePipelineCache(eng.device, &ci, nullptr, &cache));
+}
+void vk::plugins::PipelineBuildScheduler::destroy(const context::EngineContext& eng) {
+    if (!m_pool) return;
+    m_pool->wait_idle();
+    m_pool.reset();
+    {
+        std::scoped_lock lock(m_mutex);
+        m_in_flight.clear();
+    }
+    merge_worker_caches(eng);
+    for (auto& cache : m_worker_caches) vkDestroyPipelineCache(eng.device, cache, nullptr);
+    m_worker_caches.clear();
+    m_parent = nullptr;
+    m_eng    = nullptr;
+}
+vk::plugins::PipelineBuildTicket vk::plugins::PipelineBuildScheduler::submit(GraphicsPipelineDesc desc, bool may_fail) {
+    auto ticket       = std::make_shared<PipelineBuild>();
+    ticket->submitted = std::chrono::steady_clock::now();
+    ticket->may_fail  = may_fail;
+    {
+        std::scoped_lock lock(m_mutex);
+        m_in_flight.push_back(ticket);
+    }
+    m_queue_depth.fetch_add(1, std::memory_order_relaxed);
+    m_pool->submit([this, desc = std::move(desc), ticket](std::uint32_t worker) {
+        m_queue_depth.fetch_sub(1, std::memory_order_relaxed);
+        const auto t0 = std::chrono::steady_clock::now();
+        try {
+            ticket->result = desc.create(*m_eng, m_worker_caches[worker], ticket->pipeline);
+        } catch (const std::exception& e) {
+            ticket->result = VK_ERROR_UNKNOWN;
+            ticket->error  = e.what();
+        }
+        const auto t1         = std::chrono::steady_clock::now();
+        ticket->compile_time  = t1 - t0;
+        ticket->time_to_ready = t1 - ticket->submitted;
+        ticket->ready.store(true, std::memory_order_release);
+    });
+    return ticket;
+}
+void vk::plugins::PipelineBuildScheduler::poll(const context::EngineContext& eng) {
+    std::vector<PipelineBuildTicket> finished;
+    bool idle = false;
+    {
+        std::scoped_lock lock(m_mutex);
+        const auto it = std::stable_partition(m_in_flight.begin(), m_in_flight.end(), [](const PipelineBuildTicket& t) { return !t->ready.load(std::memory_order_acquire); });
+        finished.assign(std::make_move_iterator(it), std::make_move_iterator(m_in_flight.end()));
+        m_in_flight.erase(it, m_in_flight.end());
+        idle = m_in_flight.empty();
+
+        for (const auto& t : finished) {
+            ++m_stats.completed;
+            m_stats.last_time_to_ready = t->time_to_ready;
+            m_stats.max_time_to_ready  = std::max(m_stats.max_time_to_ready, t->time_to_ready);
+        }
+    }
+    for (const auto& t : finished) {
+        if (t->result != VK_SUCCESS && t->may_fail) continue;
+        if (t->result != VK_SUCCESS) throw std::runtime_error("Pipeline build failed: " + (t->error.empty() ? std::string("Vulkan error ") + std::to_string(t->result) : t->error));
+        m_parent->record_creation(t->compile_time);
+    }
+    if (!finished.empty()) m_worker_caches_dirty = true;
+    if (idle && m_worker_caches_dirty) merge_worker_caches(eng);
+}
+void vk::plugins::PipelineBuildScheduler::wait_idle() {
+    if (m_pool) m_pool->wait_idle();
+}
+vk::plugins::PipelineBuildStats vk::plugins::PipelineBuildScheduler::stats() const {
+    std::scoped_lock lock(m_mutex);
+    PipelineBuildStats s = m_stats;
+    s.queue_depth        = m_queue_depth.load(std::memory_order_relaxed);
+    return s;
+}
+void vk::plugins::PipelineBuildScheduler::merge_worker_caches(const context::EngineContext& eng) {
+    if (m_parent == nullptr || m_worker_caches.empty()) return;
+    VK_CHECK(vkMergePipelineCaches(eng.device, m_parent->handle(), static_cast<std::uint32_t>(m_worker_caches.size()), m_worker_caches.data()));
+    m_worker_caches_dirty = false;
+}
@@ -0,0 +1,164 @@
+module;
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.pipeline_cache;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::uint32_t kCacheMagic   = 0x43505656u; // "VVPC"
+        constexpr std::uint32_t kCacheVersion = 1u;
+
+        // Prefix written in front of the driver blob. The driver validates its own header too, but checking
+        // UUID/driver/content up front lets us discard stale blobs without handing them to the driver at all.
+        // Written byte for byte, so every byte is a member: `reserved` takes the place of the alignment padding and
+        // keeps the file deterministic.
+        struct CacheFileHeader {
+            std::uint32_t magic{0};
+            std::uint32_t version{0};
+            std::uint32_t vendor_id{0};
+            std::uint32_t device_id{0};
+            std::uint32_t driver_version{0};
+            std::uint8_t uuid[VK_UUID_SIZE]{};
+            std::uint32_t reserved{0};
+            std::uint64_t content_hash{0};
+            std::uint64_t payload_size{0};
+            std::uint64_t payload_hash{0};
+            std::int64_t cold_create_ns{0};
+        };
+        static_assert(std::has_unique_object_representations_v<CacheFileHeader>, "CacheFileHeader must have no padding");
+
+        double to_ms(std::chrono::nanoseconds ns) {
+            return std::chrono::duration<double, std::milli>(ns).count();
+        }
+
+        std::vector<std::byte> read_cache_file(const std::filesystem::path& path) {
+            std::ifstream f(path, std::ios::binary | std::ios::ate);
+            if (!f) return {};
+            const auto size = static_cast<std::size_t>(f.tellg());
+            f.seekg(0);
+            std::vector<std::byte> data(size);
+            if (!f.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size))) return {};
+            return data;
+        }
+
+        bool header_matches(const CacheFileHeader& h, const VkPhysicalDeviceProperties& props, std::uint64_t content_hash) {
+            return h.magic == kCacheMagic && h.version == kCacheVersion && h.vendor_id == props.vendorID && h.device_id == props.deviceID && h.driver_version == props.driverVersion && std::memcmp(h.uuid, props.pipelineCacheUUID, VK_UUID_SIZE) == 0 && h.content_hash == content_hash;
+        }
+    } // namespace
+
+    std::uint64_t hash_bytes(std::span<const std::byte> bytes, std::uint64_t seed) {
+        std::uint64_t h = seed;
+        for (const std::byte b : bytes) {
+            h ^= static_cast<std::uint64_t>(b);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+} // namespace vk::plugins
+
+void vk::plugins::PipelineCache::load(const context::EngineContext& eng, const std::filesystem::path& path, std::uint64_t content_hash) {
+    this->m_path         = path;
+    this->m_content_hash = content_hash;
+    this->m_stats        = PipelineCacheStats{};
+    vkGetPhysicalDeviceProperties(eng.physical, &this->m_props);
+
+    const std::vector<std::byte> file = read_cache_file(path);
+    std::span<const std::byte> payload{};
+    if (file.size() >= sizeof(CacheFileHeader)) {
+        CacheFileHeader header{};
+        std::memcpy(&header, file.data(), sizeof(header));
+        const auto body = std::span(file).subspan(sizeof(header));
+        if (header_matches(header, m_props, content_hash) && header.payload_size == body.size() && header.payload_hash == hash_bytes(body)) {
+            payload                  = body;
+            m_stats.cold_create_time = std::chrono::nanoseconds{header.cold_create_ns};
+        } else {
+            std::println("[pipeline-cache] discarding stale cache {}", path.string());
+        }
+    }
+
+    const VkPipelineCacheCreateInfo ci{
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = payload.size(),
+        .pInitialData    = payload.empty() ? nullptr : payload.data(),
+    };
+    if (vkCreatePipelineCache(eng.device, &ci, nullptr, &cache) != VK_SUCCESS) {
+        // A blob the driver rejects is not fatal; start from an empty cache instead.
+        const VkPipelineCacheCreateInfo empty{.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+        VK_CHECK(vkCreatePipelineCache(eng.device, &empty, nullptr, &cache));
+        payload = {};
+    }
+    m_stats.cache_hit    = !payload.empty();
+    m_stats.loaded_bytes = payload.size();
+}
+void vk::plugins::PipelineCache::save(const context::EngineContext& eng) {
+    if (cache == VK_NULL_HANDLE || m_path.empty()) return;
+
+    std::size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(eng.device, cache, &size, nullptr));
+    std::vector<std::byte> payload(size);
+    VK_CHECK(vkGetPipelineCacheData(eng.device, cache, &size, payload.data()));
+    payload.resize(size);
+
+    CacheFileHeader header{
+        .magic          = kCacheMagic,
+        .version        = kCacheVersion,
+        .vendor_id      = m_props.vendorID,
+        .device_id      = m_props.deviceID,
+        .driver_version = m_props.driverVersion,
+        .content_hash   = m_content_hash,
+        .payload_size   = payload.size(),
+        .payload_hash   = hash_bytes(payload),
+        .cold_create_ns = (m_stats.cache_hit ? m_stats.cold_create_time : m_stats.create_time).count(),
+    };
+    std::memcpy(header.uuid, m_props.pipelineCacheUUID, VK_UUID_SIZE);
+
+    // Write-then-rename so a crash mid-write never leaves a truncated cache behind.
+    std::filesystem::path tmp = m_path;
+    tmp += ".tmp";
+    std::error_code ec;
+    if (m_path.has_parent_path()) std::filesystem::create_directories(m_path.parent_path(), ec);
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!f.flush()) {
+            std::println("[pipeline-cache] failed to write {}", tmp.string());
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, m_path, ec);
+    if (ec) {
+        std::println("[pipeline-cache] failed to replace {}: {}", m_path.string(), ec.message());
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+    m_stats.saved_bytes = payload.size();
+}
+void vk::plugins::PipelineCache::destroy(const context::EngineContext& eng) {
+    vkDestroyPipelineCache(eng.device, cache, nullptr);
+    cache = VK_NULL_HANDLE;
+}
+void vk::plugins::PipelineCache::record_creation(std::chrono::nanoseconds elapsed) {
+    m_stats.create_time += elapsed;
+    ++m_stats.pipelines_created;
+}
+void vk::plugins::PipelineCache::report() const {
+    if (m_stats.cache_hit && m_stats.cold_create_time.count() > 0) {
+        std::println("[pipeline-cache] hit ({} bytes): {} pipeline(s) in {:.3f} ms, cold {:.3f} ms, {:.1f}x faster", m_stats.loaded_bytes, m_stats.pipelines_created, to_ms(m_stats.create_time), to_ms(m_stats.cold_create_time), to_ms(m_stats.cold_create_time) / std::max(to_ms(m_stats.create_time), 1e-6));
+    } else {
+        std::println("[pipeline-cache] {}: {} pipeline(s) in {:.3f} ms", m_stats.cache_hit ? "hit" : "miss", m_stats.pipelines_created, to_ms(m_stats.create_time));
+    }
+}
@@ -0,0 +1,280 @@
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <print>
+#include <string>
+#include <utility>
+#include <vulkan/vulkan.h>
+module vk.plugins.pipeline_variants;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::uint32_t kReportInterval = 600;
+
+        VkPrimitiveTopology topology_class(VkPrimitiveTopology topology) {
+            switch (topology) {
+            case VK_PRIMITIVE_TOPOLOGY_POINT_LIST: return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY: return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST: return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+            default: return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            }
+        }
+
+        VkColorBlendEquationEXT blend_equation(BlendMode blend) {
+            const auto attachment = blend_attachment(blend);
+            return {
+                .srcColorBlendFactor = attachment.srcColorBlendFactor,
+                .dstColorBlendFactor = attachment.dstColorBlendFactor,
+                .colorBlendOp        = attachment.colorBlendOp,
+                .srcAlphaBlendFactor = attachment.srcAlphaBlendFactor,
+                .dstAlphaBlendFactor = attachment.dstAlphaBlendFactor,
+                .alphaBlendOp        = attachment.alphaBlendOp,
+            };
+        }
+    } // namespace
+
+    PipelineVariantKey pipeline_key(const PipelineVariantKey& key, const VariantDynamicState& dynamic) {
+        PipelineVariantKey out = key;
+        if (dynamic.cull_mode) out.cull_mode = VK_CULL_MODE_NONE;
+        if (dynamic.front_face) out.front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        if (dynamic.topology) out.topology = dynamic.topology_unrestricted ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : topology_class(static_cast<VkPrimitiveTopology>(key.topology));
+        if (dynamic.polygon_mode) out.polygon_mode = VK_POLYGON_MODE_FILL;
+        if (dynamic.blend) out.blend = BlendMode::Opaque;
+        return out;
+    }
+    bool variant_supported(const PipelineVariantKey& key, const DeviceFeatures& features) {
+        if (key.topology >= VK_PRIMITIVE_TOPOLOGY_PATCH_LIST || key.polygon_mode > VK_POLYGON_MODE_POINT) return false;
+        if (key.cull_mode > VK_CULL_MODE_FRONT_AND_BACK || key.front_face > VK_FRONT_FACE_CLOCKWISE) return false;
+        if (key.blend > BlendMode::Additive || key.reserved != 0) return false;
+        return key.polygon_mode == VK_POLYGON_MODE_FILL || features.fill_mode_non_solid;
+    }
+    VkPipelineColorBlendAttachmentState blend_attachment(BlendMode blend) {
+        VkPipelineColorBlendAttachmentState state{
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        };
+        switch (blend) {
+        case BlendMode::Alpha:
+            state.blendEnable         = VK_TRUE;
+            state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            break;
+        case BlendMode::Additive:
+            state.blendEnable         = VK_TRUE;
+            state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+        case BlendMode::Opaque: break;
+        }
+        return state;
+    }
+} // namespace vk::plugins
+
+void vk::plugins::PipelineVariantCache::initialize(const context::EngineContext& eng, PipelineBuildScheduler& builds, const DeviceFeatures& features, GraphicsPipelineDesc base) {
+    m_eng      = &eng;
+    m_builds   = &builds;
+    m_base     = std::move(base);
+    m_features = features;
+    m_dynamic  = {};
+
+    // Any of these implies the device was created with the extension, so its properties and commands are valid.
+    if (features.dynamic_polygon_mode || features.dynamic_color_blend) {
+        VkPhysicalDeviceExtendedDynamicState3PropertiesEXT props3{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2 props{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &props3};
+        vkGetPhysicalDeviceProperties2(eng.physical, &props);
+
+        m_set_polygon_mode              = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(eng.device, "vkCmdSetPolygonModeEXT"));
+        m_set_color_blend_enable        = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(vkGetDeviceProcAddr(eng.device, "vkCmdSetColorBlendEnableEXT"));
+        m_set_color_blend_equation      = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(vkGetDeviceProcAddr(eng.device, "vkCmdSetColorBlendEquationEXT"));
+        m_dynamic.polygon_mode          = features.dynamic_polygon_mode && m_set_polygon_mode != nullptr;
+        m_dynamic.blend                 = features.dynamic_color_blend && m_set_color_blend_enable != nullptr && m_set_color_blend_equation != nullptr;
+        m_dynamic.topology_unrestricted = props3.dynamicPrimitiveTopologyUnrestricted == VK_TRUE;
+    }
+    std::println("[variants] dynamic: cull, front face, topology{}{}{}", m_dynamic.topology_unrestricted ? " (any class)" : " (per class)", m_dynamic.polygon_mode ? ", polygon mode" : "", m_dynamic.blend ? ", blend" : "");
+}
+void vk::plugins::PipelineVariantCache::destroy(const context::EngineContext& eng) {
+    if (m_eng == nullptr) return;
+    // The caller has drained the build workers, so every ticket is final.
+    for (auto& [key, slot] : m_pipelines) {
+        vkDestroyPipeline(eng.device, slot.pipeline, nullptr);
+        if (slot.build) vkDestroyPipeline(eng.device, slot.build->pipeline, nullptr);
+        if (slot.rebuild) vkDestroyPipeline(eng.device, slot.rebuild->pipeline, nullptr);
+    }
+    for (const auto& build : m_discarded) vkDestroyPipeline(eng.device, build->pipeline, nullptr);
+    for (auto& retired : m_retired) {
+        for (VkPipeline pipeline : retired) vkDestroyPipeline(eng.device, pipeline, nullptr);
+        retired.clear();
+    }
+    m_pipelines.clear();
+    m_variants.clear();
+    m_discarded.clear();
+    m_rebuilding = false;
+    m_stats      = {};
+    m_builds     = nullptr;
+    m_eng        = nullptr;
+}
+void vk::plugins::PipelineVariantCache::request(const PipelineVariantKey& key) {
+    if (!m_variants.insert(key).second) return;
+    m_stats.variants = static_cast<std::uint32_t>(m_variants.size());
+    if (!variant_supported(key, m_features)) {
+        std::println("[variants] {} variant {:016x} is not supported by the device's enabled features; it is not drawn", m_base.name, std::bit_cast<std::uint64_t>(key));
+        return;
+    }
+
+    const PipelineVariantKey compiled = pipeline_key(key, m_dynamic);
+    if (m_pipelines.contains(compiled)) return;
+    Slot& slot = m_pipelines[compiled];
+    slot.build = submit(m_base, compiled);
+    if (m_rebuilding) slot.rebuild = submit(m_next_base, compiled);
+    m_stats.pipelines = static_cast<std::uint32_t>(m_pipelines.size());
+}
+vk::plugins::PipelineVariantCache::RebuildResult vk::plugins::PipelineVariantCache::begin_frame(std::uint32_t frame_slot) {
+    for (VkPipeline pipeline : m_retired[frame_slot]) vkDestroyPipeline(m_eng->device, pipeline, nullptr);
+    m_retired[frame_slot].clear();
+    std::erase_if(m_discarded, [&](const PipelineBuildTicket& build) {
+        if (!build->ready.load(std::memory_order_acquire)) return false;
+        vkDestroyPipeline(m_eng->device, build->pipeline, nullptr);
+        return true;
+    });
+
+    for (auto& [key, slot] : m_pipelines) {
+        if (!slot.build || !slot.build->ready.load(std::memory_order_acquire)) continue;
+        const PipelineBuildTicket build = std::exchange(slot.build, {});
+        if (build->result != VK_SUCCESS) {
+            std::println("[variants] {} failed to build: {}", m_base.name, build->error.empty() ? "Vulkan error " + std::to_string(build->result) : build->error);
+            continue;
+        }
+        // A rebuild may have filled the slot first; this older pipeline was never bound.
+        if (slot.pipeline == VK_NULL_HANDLE) {
+            slot.pipeline = std::exchange(build->pipeline, VK_NULL_HANDLE);
+        } else {
+            vkDestroyPipeline(m_eng->device, std::exchange(build->pipeline, VK_NULL_HANDLE), nullptr);
+        }
+    }
+
+    const std::uint32_t pipeline_switches = m_frame_pipeline_switches.exchange(0, std::memory_order_relaxed);
+    const std::uint32_t state_switches    = m_frame_state_switches.exchange(0, std::memory_order_relaxed);
+    ++m_stats.frames;
+    m_stats.binds += m_frame_binds.exchange(0, std::memory_order_relaxed);
+    m_stats.pipeline_switches += pipeline_switches;
+    m_stats.state_switches += state_switches;
+    m_stats.last_frame_pipeline_switches = pipeline_switches;
+    m_stats.last_frame_state_switches    = state_switches;
+    if (m_stats.frames >= kReportInterval) {
+        const auto per_frame = [&](std::uint64_t total) { return static_cast<double>(total) / m_stats.frames; };
+        std::println("[variants] pipelines={} variants={} per frame: {:.2f} binds, {:.2f} pipeline switches, {:.2f} dynamic-state switches", m_stats.pipelines, m_stats.variants, per_frame(m_stats.binds), per_frame(m_stats.pipeline_switches), per_frame(m_stats.state_switches));
+        m_stats = {.pipelines = m_stats.pipelines, .variants = m_stats.variants};
+    }
+
+    if (!m_rebuilding) return RebuildResult::None;
+    bool succeeded = true;
+    for (const auto& [key, slot] : m_pipelines) {
+        if (!slot.rebuild->ready.load(std::memory_order_acquire)) return RebuildResult::None;
+        if (slot.rebuild->result == VK_SUCCESS) continue;
+        if (succeeded) std::println("[variants] {} failed to rebuild: {}", m_next_base.name, slot.rebuild->error.empty() ? "Vulkan error " + std::to_string(slot.rebuild->result) : slot.rebuild->error);
+        succeeded = false;
+    }
+    finish_rebuild(succeeded, frame_slot);
+    return succeeded ? RebuildResult::Swapped : RebuildResult::Failed;
+}
+void vk::plugins::PipelineVariantCache::rebuild(GraphicsPipelineDesc base) {
+    // A rebuild still in flight is superseded: its pipelines were never bound.
+    if (m_rebuilding) finish_rebuild(false, 0);
+    m_next_base  = std::move(base);
+    m_rebuilding = true;
+    for (auto& [key, slot] : m_pipelines) slot.rebuild = submit(m_next_base, key);
+}
+void vk::plugins::PipelineVariantCache::finish_rebuild(bool swap, std::uint32_t frame_slot) {
+    for (auto& [key, slot] : m_pipelines) {
+        PipelineBuildTicket build = std::exchange(slot.rebuild, {});
+        if (!build) continue;
+        // Only a superseded rebuild can still be compiling; begin_frame frees what it produces once it lands.
+        if (!build->ready.load(std::memory_order_acquire)) {
+            m_discarded.push_back(std::move(build));
+            continue;
+        }
+        VkPipeline pipeline = std::exchange(build->pipeline, VK_NULL_HANDLE);
+        if (!swap) {
+            vkDestroyPipeline(m_eng->device, pipeline, nullptr);
+            continue;
+        }
+        // Frames still in flight keep the old pipeline; it is destroyed when this slot comes round again.
+        if (slot.pipeline != VK_NULL_HANDLE) m_retired[frame_slot].push_back(slot.pipeline);
+        slot.pipeline = pipeline;
+    }
+    if (swap) m_base = m_next_base;
+    m_rebuilding = false;
+}
+bool vk::plugins::PipelineVariantCache::bind(VkCommandBuffer cmd, const PipelineVariantKey& key, VariantBinding& binding) const {
+    // Checked here too: an unsupported key can collapse onto a supported pipeline through its dynamic fields.
+    if (!variant_supported(key, m_features)) return false;
+    const auto it = m_pipelines.find(pipeline_key(key, m_dynamic));
+    if (it == m_pipelines.end() || it->second.pipeline == VK_NULL_HANDLE) return false;
+
+    m_frame_binds.fetch_add(1, std::memory_order_relaxed);
+    if (binding.pipeline != it->second.pipeline) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, it->second.pipeline);
+        binding.pipeline = it->second.pipeline;
+        m_frame_pipeline_switches.fetch_add(1, std::memory_order_relaxed);
+    } else if (binding.key == key) {
+        return true;
+    } else {
+        m_frame_state_switches.fetch_add(1, std::memory_order_relaxed);
+    }
+    set_dynamic_state(cmd, key);
+    binding.key = key;
+    return true;
+}
+bool vk::plugins::PipelineVariantCache::ready(const PipelineVariantKey& key) const {
+    if (!variant_supported(key, m_features)) return false;
+    const auto it = m_pipelines.find(pipeline_key(key, m_dynamic));
+    return it != m_pipelines.end() && it->second.pipeline != VK_NULL_HANDLE;
+}
+bool vk::plugins::PipelineVariantCache::failed(const PipelineVariantKey& key) const {
+    if (!variant_supported(key, m_features)) return true;
+    const auto it = m_pipelines.find(pipeline_key(key, m_dynamic));
+    return it != m_pipelines.end() && it->second.pipeline == VK_NULL_HANDLE && !it->second.build;
+}
+vk::plugins::PipelineBuildTicket vk::plugins::PipelineVariantCache::submit(const GraphicsPipelineDesc& base, const PipelineVariantKey& key) const {
+    GraphicsPipelineDesc desc = base;
+    desc.topology             = static_cast<VkPrimitiveTopology>(key.topology);
+    desc.polygon_mode         = static_cast<VkPolygonMode>(key.polygon_mode);
+    desc.cull_mode            = key.cull_mode;
+    desc.front_face           = static_cast<VkFrontFace>(key.front_face);
+    desc.color_blend          = blend_attachment(key.blend);
+    desc.specialization[0]    = key.shading;
+    desc.specialization_count = std::max<std::uint32_t>(desc.specialization_count, 1);
+    desc.name                 = std::format("{}#{:016x}", base.name, std::bit_cast<std::uint64_t>(key));
+    if (m_dynamic.cull_mode) desc.dynamic_states.push_back(VK_DYNAMIC_STATE_CULL_MODE);
+    if (m_dynamic.front_face) desc.dynamic_states.push_back(VK_DYNAMIC_STATE_FRONT_FACE);
+    if (m_dynamic.topology) desc.dynamic_states.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+    if (m_dynamic.polygon_mode) desc.dynamic_states.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+    if (m_dynamic.blend) {
+        desc.dynamic_states.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+        desc.dynamic_states.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+    }
+    // A variant that fails to compile is reported and left undrawn rather than taking the frame down.
+    return m_builds->submit(std::move(desc), true);
+}
+void vk::plugins::PipelineVariantCache::set_dynamic_state(VkCommandBuffer cmd, const PipelineVariantKey& key) const {
+    if (m_dynamic.cull_mode) vkCmdSetCullMode(cmd, key.cull_mode);
+    if (m_dynamic.front_face) vkCmdSetFrontFace(cmd, static_cast<VkFrontFace>(key.front_face));
+    if (m_dynamic.topology) vkCmdSetPrimitiveTopology(cmd, static_cast<VkPrimitiveTopology>(key.topology));
+    if (m_dynamic.polygon_mode) m_set_polygon_mode(cmd, static_cast<VkPolygonMode>(key.polygon_mode));
+    if (m_dynamic.blend) {
+        const VkBool32 enable                  = key.blend != BlendMode::Opaque ? VK_TRUE : VK_FALSE;
+        const VkColorBlendEquationEXT equation = blend_equation(key.blend);
+        m_set_color_blend_enable(cmd, 0, 1, &enable);
+        m_set_color_blend_equation(cmd, 0, 1, &equation);
+    }
+}
@@ -0,0 +1,507 @@
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.pointcloud;
+import vk.plugins.culling;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::uint32_t kMaxLevel  = 16; // cell indices are packed into 17 bits per axis
+        constexpr float kQuantisationSteps = 65535.0f;
+
+        struct PointPush {
+            float view_proj[16];
+            float point_size;
+        };
+
+        // Spatial cell of a point at a level: the level in the top bits, then the cell index along x, y and z.
+        std::uint64_t cell_key(const PointVertex& p, std::uint32_t level, const float min[3], const float extent[3]) {
+            const std::uint32_t cells = 1u << level;
+            std::uint64_t key         = level;
+            for (int axis = 0; axis < 3; ++axis) {
+                const float t          = extent[axis] > 0.0f ? (p.position[axis] - min[axis]) / extent[axis] : 0.0f;
+                const std::uint32_t at = std::min(static_cast<std::uint32_t>(std::max(t, 0.0f) * static_cast<float>(cells)), cells - 1);
+                key                    = key << 17 | at;
+            }
+            return key;
+        }
+        std::uint32_t key_level(std::uint64_t key) {
+            return static_cast<std::uint32_t>(key >> 51);
+        }
+        // Fixed scramble of the input order, so each cell's first-come sample is spread over the whole cell.
+        std::uint64_t scramble(std::uint64_t i) {
+            i += 0x9e3779b97f4a7c15ull;
+            i = (i ^ (i >> 30)) * 0xbf58476d1ce4e5b9ull;
+            i = (i ^ (i >> 27)) * 0x94d049bb133111ebull;
+            return i ^ (i >> 31);
+        }
+        void bounding_sphere(const ChunkRecord& chunk, float center[3], float& radius) {
+            float squared = 0.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                center[axis]     = 0.5f * (chunk.bounds_min[axis] + chunk.bounds_max[axis]);
+                const float half = 0.5f * (chunk.bounds_max[axis] - chunk.bounds_min[axis]);
+                squared += half * half;
+            }
+            radius = std::sqrt(squared);
+        }
+        float row_length(const std::array<float, 16>& m, int i) {
+            return std::sqrt(m[i] * m[i] + m[4 + i] * m[4 + i] + m[8 + i] * m[8 + i]);
+        }
+    } // namespace
+
+    void write_point_cloud(const std::filesystem::path& path, std::span<const PointVertex> points, const PointCloudBuildOptions& options) {
+        const std::uint32_t capacity  = std::max(options.chunk_capacity, 1u);
+        const std::uint32_t max_level = std::min(options.max_level, kMaxLevel);
+
+        PointCloudHeader header{.point_count = points.size()};
+        for (int axis = 0; axis < 3; ++axis) {
+            header.bounds_min[axis] = points.empty() ? 0.0f : std::numeric_limits<float>::max();
+            header.bounds_max[axis] = points.empty() ? 0.0f : std::numeric_limits<float>::lowest();
+        }
+        for (const auto& p : points) {
+            for (int axis = 0; axis < 3; ++axis) {
+                header.bounds_min[axis] = std::min(header.bounds_min[axis], p.position[axis]);
+                header.bounds_max[axis] = std::max(header.bounds_max[axis], p.position[axis]);
+            }
+        }
+        const float extent[3]{header.bounds_max[0] - header.bounds_min[0], header.bounds_max[1] - header.bounds_min[1], header.bounds_max[2] - header.bounds_min[2]};
+
+        std::vector<std::uint32_t> order(points.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::sort(order, {}, [](std::uint32_t i) { return scramble(i); });
+
+        // Each point goes to the coarsest level whose cell still has room; the finest level takes whatever is left.
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells;
+        for (const std::uint32_t index : order) {
+            for (std::uint32_t level = 0; level <= max_level; ++level) {
+                auto& members = cells[cell_key(points[index], level, header.bounds_min, extent)];
+                if (members.size() < capacity || level == max_level) {
+                    members.push_back(index);
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::uint64_t> keys;
+        keys.reserve(cells.size());
+        for (const auto& [key, members] : cells) {
+            if (!members.empty()) keys.push_back(key);
+        }
+        std::ranges::sort(keys); // coarse levels first, then spatially ordered within a level
+
+        std::vector<ChunkRecord> chunks;
+        std::vector<PackedPoint> packed;
+        packed.reserve(points.size());
+        for (const std::uint64_t key : keys) {
+            const auto& members = cells[key];
+            for (std::size_t first = 0; first < members.size(); first += capacity) {
+                const std::size_t count = std::min<std::size_t>(capacity, members.size() - first);
+                ChunkRecord chunk{.first_point = packed.size(), .point_count = static_cast<std::uint32_t>(count), .level = key_level(key)};
+                std::copy_n(points[members[first]].position, 3, chunk.bounds_min);
+                std::copy_n(points[members[first]].position, 3, chunk.bounds_max);
+                for (std::size_t i = first; i < first + count; ++i) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        chunk.bounds_min[axis] = std::min(chunk.bounds_min[axis], points[members[i]].position[axis]);
+                        chunk.bounds_max[axis] = std::max(chunk.bounds_max[axis], points[members[i]].position[axis]);
+                    }
+                }
+                for (std::size_t i = first; i < first + count; ++i) {
+                    const PointVertex& p = points[members[i]];
+                    PackedPoint q{.reserved = 0, .color = p.color};
+                    for (int axis = 0; axis < 3; ++axis) {
+                        const float range = chunk.bounds_max[axis] - chunk.bounds_min[axis];
+                        const float t     = range > 0.0f ? (p.position[axis] - chunk.bounds_min[axis]) / range : 0.0f;
+                        q.position[axis]  = static_cast<std::uint16_t>(std::clamp(std::lround(t * kQuantisationSteps), 0l, 65535l));
+                    }
+                    packed.push_back(q);
+                }
+                header.chunk_capacity = std::max(header.chunk_capacity, chunk.point_count);
+                header.levels         = std::max(header.levels, chunk.level + 1);
+                chunks.push_back(chunk);
+            }
+        }
+        header.chunk_count = static_cast<std::uint32_t>(chunks.size());
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(chunks.data()), static_cast<std::streamsize>(chunks.size() * sizeof(ChunkRecord)));
+        file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size() * sizeof(PackedPoint)));
+        if (!file) throw std::runtime_error("Failed to write point cloud " + path.string());
+    }
+
+    float projected_radius(const ChunkRecord& chunk, const std::array<float, 16>& view_proj) {
+        float center[3];
+        float radius = 0.0f;
+        bounding_sphere(chunk, center, radius);
+        const float w = view_proj[3] * center[0] + view_proj[7] * center[1] + view_proj[11] * center[2] + view_proj[15];
+        // w varies over the sphere by at most radius * |row 3|; a sphere reaching w <= 0 covers the eye.
+        if (w <= radius * row_length(view_proj, 3)) return std::numeric_limits<float>::infinity();
+        return radius * std::max(row_length(view_proj, 0), row_length(view_proj, 1)) / w;
+    }
+
+    std::uint64_t select_chunks(std::span<const ChunkRecord> chunks, const std::array<float, 16>& view_proj, const LodSettings& lod, std::vector<std::uint32_t>& selected) {
+        struct Candidate {
+            std::uint32_t chunk;
+            std::uint32_t level;
+            float size;
+        };
+        const Frustum frustum = extract_frustum(view_proj);
+        std::vector<Candidate> candidates;
+        for (std::uint32_t i = 0; i < chunks.size(); ++i) {
+            float center[3];
+            float radius = 0.0f;
+            bounding_sphere(chunks[i], center, radius);
+            if (!sphere_in_frustum(frustum, center, radius)) continue;
+            const float size = projected_radius(chunks[i], view_proj);
+            if (chunks[i].level > 0 && size < lod.detail) continue;
+            candidates.push_back({i, chunks[i].level, size});
+        }
+        // Coarse levels first so the budget always covers the whole view before adding detail anywhere.
+        std::ranges::sort(candidates, [](const Candidate& a, const Candidate& b) {
+            if (a.level != b.level) return a.level < b.level;
+            if (a.size != b.size) return a.size > b.size;
+            return a.chunk < b.chunk;
+        });
+
+        std::uint64_t total = 0;
+        for (const auto& c : candidates) {
+            if (total + chunks[c.chunk].point_count > lod.point_budget) break;
+            total += chunks[c.chunk].point_count;
+            selected.push_back(c.chunk);
+        }
+        return total;
+    }
+} // namespace vk::plugins
+
+vk::plugins::PointCloudFile::PointCloudFile(const std::filesystem::path& path) : m_file(path) {
+    const auto bytes = m_file.bytes();
+    const auto fail  = [&](const char* what) { throw std::runtime_error("Malformed point cloud " + path.string() + ": " + what); };
+    if (bytes.size() < sizeof(PointCloudHeader)) fail("shorter than its header");
+    m_header = reinterpret_cast<const PointCloudHeader*>(bytes.data());
+    if (m_header->magic != kPointCloudMagic) fail("bad magic");
+    if (m_header->version != kPointCloudVersion) fail("unsupported version");
+
+    const std::size_t table_end = sizeof(PointCloudHeader) + std::size_t{m_header->chunk_count} * sizeof(ChunkRecord);
+    if (bytes.size() < table_end) fail("chunk table truncated");
+    if (m_header->point_count > (bytes.size() - table_end) / sizeof(PackedPoint)) fail("point data truncated");
+    m_chunks = {reinterpret_cast<const ChunkRecord*>(bytes.data() + sizeof(PointCloudHeader)), m_header->chunk_count};
+    m_points = {reinterpret_cast<const PackedPoint*>(bytes.data() + table_end), static_cast<std::size_t>(m_header->point_count)};
+    for (const auto& chunk : m_chunks) {
+        if (chunk.first_point > m_header->point_count || chunk.point_count > m_header->point_count - chunk.first_point) fail("chunk outside the point data");
+        if (chunk.point_count > m_header->chunk_capacity) fail("chunk larger than the declared capacity");
+    }
+}
+std::span<const vk::plugins::PackedPoint> vk::plugins::PointCloudFile::packed(std::uint32_t chunk) const {
+    const auto& record = m_chunks[chunk];
+    return m_points.subspan(static_cast<std::size_t>(record.first_point), record.point_count);
+}
+std::uint32_t vk::plugins::PointCloudFile::decode(std::uint32_t chunk, std::span<PointVertex> out) const {
+    const auto& record = m_chunks[chunk];
+    const auto points  = packed(chunk);
+    if (out.size() < points.size()) throw std::runtime_error("Point cloud decode target smaller than the chunk");
+
+    float scale[3];
+    for (int axis = 0; axis < 3; ++axis) scale[axis] = (record.bounds_max[axis] - record.bounds_min[axis]) / kQuantisationSteps;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        for (int axis = 0; axis < 3; ++axis) out[i].position[axis] = record.bounds_min[axis] + static_cast<float>(points[i].position[axis]) * scale[axis];
+        out[i].color = points[i].color;
+    }
+    return record.point_count;
+}
+
+vk::plugins::ChunkResidencyCache::ChunkResidencyCache(std::uint32_t slots) {
+    reset(slots);
+}
+void vk::plugins::ChunkResidencyCache::reset(std::uint32_t slots) {
+    m_slots.assign(slots, Slot{});
+    m_chunk_slots.clear();
+    m_head = kNone;
+    m_tail = kNone;
+    for (std::uint32_t i = 0; i < slots; ++i) push_front(i);
+    m_frame     = 1;
+    m_resident  = 0;
+    m_evictions = 0;
+}
+std::uint32_t vk::plugins::ChunkResidencyCache::touch(std::uint32_t chunk) {
+    const auto it = m_chunk_slots.find(chunk);
+    if (it == m_chunk_slots.end()) return kNone;
+    const std::uint32_t slot = it->second;
+    m_slots[slot].last_used  = m_frame;
+    unlink(slot);
+    push_front(slot);
+    return m_slots[slot].loading ? kNone : slot;
+}
+vk::plugins::ChunkResidencyCache::Grant vk::plugins::ChunkResidencyCache::reserve(std::uint32_t chunk) {
+    // The tail is the least recently used slot (free slots were never used); if even it is pinned, all are.
+    if (m_tail == kNone || m_chunk_slots.contains(chunk) || m_slots[m_tail].last_used == m_frame) return {};
+    const std::uint32_t slot = m_tail;
+    Slot& s                  = m_slots[slot];
+    const Grant grant{.slot = slot, .evicted = s.chunk};
+    if (s.chunk != kNone) {
+        m_chunk_slots.erase(s.chunk);
+        if (!s.loading) --m_resident;
+        ++m_evictions;
+    }
+    s.chunk     = chunk;
+    s.loading   = true;
+    s.last_used = m_frame;
+    unlink(slot);
+    push_front(slot);
+    m_chunk_slots.emplace(chunk, slot);
+    return grant;
+}
+bool vk::plugins::ChunkResidencyCache::mark_resident(std::uint32_t chunk, std::uint32_t slot) {
+    const auto it = m_chunk_slots.find(chunk);
+    if (it == m_chunk_slots.end() || it->second != slot || !m_slots[slot].loading) return false;
+    m_slots[slot].loading = false;
+    ++m_resident;
+    return true;
+}
+bool vk::plugins::ChunkResidencyCache::loading(std::uint32_t chunk) const {
+    const auto it = m_chunk_slots.find(chunk);
+    return it != m_chunk_slots.end() && m_slots[it->second].loading;
+}
+void vk::plugins::ChunkResidencyCache::unlink(std::uint32_t slot) {
+    Slot& s = m_slots[slot];
+    if (s.prev != kNone) m_slots[s.prev].next = s.next;
+    else m_head = s.next;
+    if (s.next != kNone) m_slots[s.next].prev = s.prev;
+    else m_tail = s.prev;
+    s.prev = kNone;
+    s.next = kNone;
+}
+void vk::plugins::ChunkResidencyCache::push_front(std::uint32_t slot) {
+    Slot& s = m_slots[slot];
+    s.prev  = kNone;
+    s.next  = m_head;
+    if (m_head != kNone) m_slots[m_head].prev = slot;
+    m_head = slot;
+    if (m_tail == kNone) m_tail = slot;
+}
+
+void vk::plugins::PointCloudStreamer::initialize(const context::EngineContext& eng, VkFormat color_format, PipelineBuildScheduler& builds, DescriptorAllocator& descriptors, const PointCloudStreamConfig& config) {
+    m_config                   = config;
+    m_config.gpu_slots         = std::max(m_config.gpu_slots, 1u);
+    m_config.uploads_per_frame = std::max(m_config.uploads_per_frame, 1u);
+    m_config.decodes_in_flight = std::max(m_config.decodes_in_flight, 1u);
+    m_workers                  = std::make_unique<ThreadPool>(std::max(m_config.decode_workers, 1u));
+    m_staging_slots            = std::make_unique<Staging[]>(m_config.decodes_in_flight);
+
+    const VkDescriptorSetLayoutBinding binding{.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT};
+    m_set_layout = descriptors.create_layout(std::span(&binding, 1));
+    m_set        = descriptors.allocate(m_set_layout);
+
+    const VkPushConstantRange push{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset     = 0,
+        .size       = sizeof(PointPush),
+    };
+    const VkPipelineLayoutCreateInfo plci{
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &m_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+    VK_CHECK(vkCreatePipelineLayout(eng.device, &plci, nullptr, &m_layout));
+
+    auto& shaders       = ShaderLibrary::shared();
+    this->m_vert_shader = shaders.acquire(eng, "shader/pointcloud.vert.spv");
+    this->m_frag_shader = shaders.acquire(eng, "shader/viewport.frag.spv");
+    GraphicsPipelineDesc desc{
+        .vert_shader  = m_vert_shader,
+        .frag_shader  = m_frag_shader,
+        .layout       = m_layout,
+        .color_format = color_format,
+        .topology     = VK_PRIMITIVE_TOPOLOGY_POINT_LIST,
+        .name         = "pointcloud",
+    };
+    this->m_pending_pipeline = builds.submit(std::move(desc));
+}
+void vk::plugins::PointCloudStreamer::destroy(const context::EngineContext& eng) {
+    if (m_layout == VK_NULL_HANDLE) return;
+    close(eng);
+    m_workers.reset();
+    // The owner drains the build scheduler first, so a pending ticket is always finished here.
+    if (m_pending_pipeline) {
+        vkDestroyPipeline(eng.device, m_pending_pipeline->pipeline, nullptr);
+        m_pending_pipeline.reset();
+    }
+    vkDestroyPipeline(eng.device, m_pipeline, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+    ShaderLibrary::shared().release(eng, m_vert_shader);
+    ShaderLibrary::shared().release(eng, m_frag_shader);
+    vkDestroyPipelineLayout(eng.device, m_layout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+    // The layout and set belong to the descriptor allocator.
+    m_set_layout = VK_NULL_HANDLE;
+    m_set        = VK_NULL_HANDLE;
+}
+void vk::plugins::PointCloudStreamer::open(const context::EngineContext& eng, const std::filesystem::path& path) {
+    close(eng);
+    m_file.emplace(path);
+    m_slot_bytes = VkDeviceSize{std::max(m_file->header().chunk_capacity, 1u)} * sizeof(PointVertex);
+    m_pool       = create_buffer(eng, m_slot_bytes * m_config.gpu_slots, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_staging    = create_buffer(eng, m_slot_bytes * m_config.decodes_in_flight, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_cache.reset(m_config.gpu_slots);
+
+    const VkDescriptorBufferInfo info{m_pool.buffer, 0, VK_WHOLE_SIZE};
+    const VkWriteDescriptorSet write{
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet          = m_set,
+        .dstBinding      = 0,
+        .descriptorCount = 1,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo     = &info,
+    };
+    vkUpdateDescriptorSets(eng.device, 1, &write, 0, nullptr);
+}
+void vk::plugins::PointCloudStreamer::close(const context::EngineContext& eng) {
+    if (!m_file) return;
+    // Decodes write into the staging buffer and frames in flight read the pool through the one descriptor set.
+    m_workers->wait_idle();
+    VK_CHECK(vkDeviceWaitIdle(eng.device));
+    destroy_buffer(eng, m_pool);
+    destroy_buffer(eng, m_staging);
+    for (std::uint32_t i = 0; i < m_config.decodes_in_flight; ++i) {
+        Staging& s = m_staging_slots[i];
+        s.busy     = false;
+        s.ready.store(false, std::memory_order_relaxed);
+        s.release_frame = 0;
+    }
+    m_file.reset();
+    m_draws.clear();
+    m_stats = {};
+}
+void vk::plugins::PointCloudStreamer::update(VkCommandBuffer cmd, const context::EngineContext& eng, RenderGraph& graph, const std::array<float, 16>& view_proj) {
+    if (m_pending_pipeline && m_pending_pipeline->ready.load(std::memory_order_acquire)) {
+        m_pipeline = std::exchange(m_pending_pipeline->pipeline, VK_NULL_HANDLE);
+        m_pending_pipeline.reset();
+    }
+    m_draws.clear();
+    if (!m_file) return;
+
+    ++m_frame;
+    m_cache.begin_frame();
+    m_stats = {};
+    record_uploads(cmd, graph);
+
+    // Chunks copied above are resident now and drawn this frame; the copy's barrier precedes the scene pass.
+    m_selected.clear();
+    m_missing.clear();
+    select_chunks(m_file->chunks(), view_proj, m_config.lod, m_selected);
+    const std::uint32_t capacity = m_file->header().chunk_capacity;
+    for (const std::uint32_t chunk : m_selected) {
+        const std::uint32_t slot = m_cache.touch(chunk);
+        if (slot != ChunkResidencyCache::kNone) {
+            m_draws.push_back({.first_vertex = slot * capacity, .count = m_file->chunks()[chunk].point_count});
+            m_stats.drawn_points += m_file->chunks()[chunk].point_count;
+        } else if (!m_cache.loading(chunk)) {
+            m_missing.push_back(chunk);
+        }
+    }
+    request_loads();
+
+    m_stats.selected_chunks = static_cast<std::uint32_t>(m_selected.size());
+    m_stats.drawn_chunks    = static_cast<std::uint32_t>(m_draws.size());
+    m_stats.resident_chunks = m_cache.resident_count();
+    m_stats.evictions       = m_cache.evictions();
+}
+void vk::plugins::PointCloudStreamer::record(VkCommandBuffer cmd, VkRect2D area, const std::array<float, 16>& view_proj) const {
+    if (m_pipeline == VK_NULL_HANDLE || m_draws.empty()) return;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    const VkViewport viewport{
+        .x        = static_cast<float>(area.offset.x),
+        .y        = static_cast<float>(area.offset.y),
+        .width    = static_cast<float>(area.extent.width),
+        .height   = static_cast<float>(area.extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &area);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout, 0, 1, &m_set, 0, nullptr);
+    PointPush push{.point_size = m_config.point_size};
+    std::memcpy(push.view_proj, view_proj.data(), sizeof(push.view_proj));
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+    for (const Draw& draw : m_draws) vkCmdDraw(cmd, draw.count, 1, draw.first_vertex, 0);
+}
+void vk::plugins::PointCloudStreamer::record_uploads(VkCommandBuffer cmd, RenderGraph& graph) {
+    m_copies.clear();
+    for (std::uint32_t i = 0; i < m_config.decodes_in_flight; ++i) {
+        Staging& s = m_staging_slots[i];
+        if (!s.busy) continue;
+        if (s.release_frame != 0) {
+            if (s.release_frame > m_frame) continue;
+            s.busy          = false;
+            s.release_frame = 0;
+            continue;
+        }
+        if (m_copies.size() >= m_config.uploads_per_frame || !s.ready.load(std::memory_order_acquire)) continue;
+        s.ready.store(false, std::memory_order_relaxed);
+
+        // The chunk may have been evicted while it was decoding; then the staging slot is simply dropped.
+        if (!m_cache.mark_resident(s.chunk, s.slot)) {
+            s.busy = false;
+            continue;
+        }
+        const VkDeviceSize bytes = VkDeviceSize{s.count} * sizeof(PointVertex);
+        if (bytes > 0) m_copies.push_back({.srcOffset = i * m_slot_bytes, .dstOffset = s.slot * m_slot_bytes, .size = bytes});
+        m_stats.bytes_uploaded += bytes;
+        m_stats.decode_time += s.decode_time;
+        ++m_stats.uploads;
+        // Reusable once this frame's command buffer has retired.
+        s.release_frame = m_frame + context::FRAME_OVERLAP;
+    }
+    if (m_copies.empty()) return;
+
+    // Frames still in flight may draw from the slots being overwritten; the graph orders their reads before the copy.
+    const ResourceId pool = graph.import_buffer(m_pool.buffer, 0, m_pool.size, states::kVertexStorageRead);
+    graph.use(pool, states::kTransferWrite);
+    graph.flush(cmd);
+    vkCmdCopyBuffer(cmd, m_staging.buffer, m_pool.buffer, static_cast<std::uint32_t>(m_copies.size()), m_copies.data());
+    graph.use(pool, states::kVertexStorageRead);
+}
+void vk::plugins::PointCloudStreamer::request_loads() {
+    const std::uint32_t capacity = m_file->header().chunk_capacity;
+    std::uint32_t next           = 0;
+    for (const std::uint32_t chunk : m_missing) {
+        while (next < m_config.decodes_in_flight && m_staging_slots[next].busy) ++next;
+        if (next == m_config.decodes_in_flight) break;
+        const auto grant = m_cache.reserve(chunk);
+        if (grant.slot == ChunkResidencyCache::kNone) break;
+
+        Staging& s      = m_staging_slots[next];
+        s.busy          = true;
+        s.chunk         = chunk;
+        s.slot          = grant.slot;
+        s.release_frame = 0;
+        auto* target    = reinterpret_cast<PointVertex*>(static_cast<std::byte*>(m_staging.mapped) + next * m_slot_bytes);
+        m_workers->submit([this, &s, target, chunk, capacity](std::uint32_t) {
+            const auto t0 = std::chrono::steady_clock::now();
+            s.count       = m_file->decode(chunk, {target, capacity});
+            s.decode_time = std::chrono::steady_clock::now() - t0;
+            s.ready.store(true, std::memory_order_release);
+        });
+    }
+}
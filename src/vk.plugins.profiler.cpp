@@ -0,0 +1,203 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.profiler;
+
+namespace vk::plugins {
+    namespace {
+        constexpr VkQueryPipelineStatisticFlags kStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        double to_ms(std::chrono::steady_clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        }
+        std::string json_escape(std::string_view text) {
+            std::string out;
+            out.reserve(text.size());
+            for (const char c : text) {
+                if (c == '"' || c == '\\') out.push_back('\\');
+                out.push_back(c);
+            }
+            return out;
+        }
+        void pop_scope(std::vector<std::uint32_t>& stack, std::uint32_t scope) {
+            if (!stack.empty() && stack.back() == scope) stack.pop_back();
+            else std::erase(stack, scope);
+        }
+    } // namespace
+} // namespace vk::plugins
+
+void vk::plugins::Profiler::initialize(const context::EngineContext& eng, const DeviceFeatures& features, std::uint32_t max_gpu_scopes, std::size_t history) {
+    m_epoch          = std::chrono::steady_clock::now();
+    m_max_gpu_scopes = max_gpu_scopes;
+    m_history_length = history;
+
+    std::uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(eng.physical, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(eng.physical, &family_count, families.data());
+    const std::uint32_t valid_bits = eng.graphics_queue_family < family_count ? families[eng.graphics_queue_family].timestampValidBits : 0;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(eng.physical, &props);
+    if (valid_bits == 0 || props.limits.timestampPeriod <= 0.0f) {
+        std::println("[profiler] graphics queue does not support timestamps; GPU scopes disabled");
+    } else {
+        m_timestamp_period = props.limits.timestampPeriod;
+        m_timestamp_mask   = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+        const VkQueryPoolCreateInfo qci{
+            .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * m_max_gpu_scopes,
+        };
+        for (auto& pool : m_timestamp_pools) VK_CHECK(vkCreateQueryPool(eng.device, &qci, nullptr, &pool));
+    }
+
+    if (m_want_pipeline_statistics) {
+        // Physical support is not enough: the query type is only valid if the device was created with the feature.
+        if (!features.pipeline_statistics_query) {
+            std::println("[profiler] pipelineStatisticsQuery not enabled; pipeline statistics disabled");
+        } else {
+            const VkQueryPoolCreateInfo qci{
+                .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                .queryCount         = 1,
+                .pipelineStatistics = kStatistics,
+            };
+            for (auto& pool : m_statistics_pools) VK_CHECK(vkCreateQueryPool(eng.device, &qci, nullptr, &pool));
+        }
+    }
+}
+void vk::plugins::Profiler::destroy(const context::EngineContext& eng) {
+    for (auto& pool : m_timestamp_pools) {
+        vkDestroyQueryPool(eng.device, pool, nullptr);
+        pool = VK_NULL_HANDLE;
+    }
+    for (auto& pool : m_statistics_pools) {
+        vkDestroyQueryPool(eng.device, pool, nullptr);
+        pool = VK_NULL_HANDLE;
+    }
+    m_timestamp_period = 0.0;
+    m_slots            = {};
+    m_current_slot.reset();
+}
+void vk::plugins::Profiler::begin_frame(VkCommandBuffer cmd, const context::EngineContext& eng, std::uint32_t frame_slot) {
+    // The previous frame's CPU side is complete; its GPU side is collected when its slot comes round again.
+    if (m_current_slot) m_slots[*m_current_slot].frame = std::move(m_current);
+    harvest(eng, frame_slot);
+
+    const auto now = std::chrono::steady_clock::now();
+    m_frame_start  = now;
+    m_current      = ProfileFrame{.frame = m_frame_number++, .cpu_start_ms = to_ms(now - m_epoch)};
+    m_current_slot = frame_slot;
+    m_gpu_stack.clear();
+    m_cpu_stack.clear();
+    m_slots[frame_slot].statistics_written = false;
+    if (gpu_available()) vkCmdResetQueryPool(cmd, m_timestamp_pools[frame_slot], 0, 2 * m_max_gpu_scopes);
+    if (pipeline_statistics()) vkCmdResetQueryPool(cmd, m_statistics_pools[frame_slot], 0, 1);
+}
+void vk::plugins::Profiler::harvest(const context::EngineContext& eng, std::uint32_t frame_slot) {
+    auto& slot = m_slots[frame_slot];
+    if (!slot.frame) return;
+    ProfileFrame frame = std::move(*slot.frame);
+    slot.frame.reset();
+
+    // Each result is {value, availability}; a scope whose queries are not available yet is dropped, never waited on.
+    const auto queries = static_cast<std::uint32_t>(2 * frame.gpu.size());
+    if (queries > 0 && gpu_available()) {
+        std::vector<std::uint64_t> data(2 * queries);
+        const VkResult res = vkGetQueryPoolResults(eng.device, m_timestamp_pools[frame_slot], 0, queries, data.size() * sizeof(std::uint64_t), data.data(), 2 * sizeof(std::uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (res != VK_NOT_READY) VK_CHECK(res);
+
+        frame.gpu_valid = true;
+        for (std::uint32_t q = 0; q < queries; ++q) frame.gpu_valid = frame.gpu_valid && data[2 * q + 1] != 0;
+        if (frame.gpu_valid) {
+            const std::uint64_t origin = data[0] & m_timestamp_mask;
+            const auto ticks_to_ms     = [&](std::uint64_t ticks) { return static_cast<double>(((ticks & m_timestamp_mask) - origin) & m_timestamp_mask) * m_timestamp_period * 1e-6; };
+            for (std::size_t i = 0; i < frame.gpu.size(); ++i) {
+                frame.gpu[i].begin_ms = ticks_to_ms(data[4 * i]);
+                frame.gpu[i].end_ms   = ticks_to_ms(data[4 * i + 2]);
+            }
+        }
+    }
+    if (slot.statistics_written && pipeline_statistics()) {
+        std::array<std::uint64_t, 6> stats{};
+        const VkResult res = vkGetQueryPoolResults(eng.device, m_statistics_pools[frame_slot], 0, 1, sizeof(stats), stats.data(), sizeof(stats), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (res != VK_NOT_READY) VK_CHECK(res);
+        if (stats[5] != 0) frame.pipeline = PipelineStatistics{stats[0], stats[1], stats[2], stats[3], stats[4]};
+    }
+
+    m_history.push_back(std::move(frame));
+    while (m_history.size() > m_history_length) m_history.pop_front();
+}
+std::uint32_t vk::plugins::Profiler::begin_gpu_scope(VkCommandBuffer cmd, std::string_view name) {
+    if (!gpu_available() || !m_current_slot || m_current.gpu.size() >= m_max_gpu_scopes) return kInvalidScope;
+    const auto scope = static_cast<std::uint32_t>(m_current.gpu.size());
+    m_current.gpu.push_back({.name = std::string(name), .depth = static_cast<std::uint32_t>(m_gpu_stack.size())});
+    m_gpu_stack.push_back(scope);
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_timestamp_pools[*m_current_slot], 2 * scope);
+    return scope;
+}
+void vk::plugins::Profiler::end_gpu_scope(VkCommandBuffer cmd, std::uint32_t scope) {
+    if (scope == kInvalidScope || !m_current_slot) return;
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_timestamp_pools[*m_current_slot], 2 * scope + 1);
+    pop_scope(m_gpu_stack, scope);
+}
+void vk::plugins::Profiler::begin_pipeline_statistics(VkCommandBuffer cmd) {
+    if (!pipeline_statistics() || !m_current_slot || m_slots[*m_current_slot].statistics_written) return;
+    vkCmdBeginQuery(cmd, m_statistics_pools[*m_current_slot], 0, 0);
+    m_slots[*m_current_slot].statistics_written = true;
+}
+void vk::plugins::Profiler::end_pipeline_statistics(VkCommandBuffer cmd) {
+    if (!pipeline_statistics() || !m_current_slot || !m_slots[*m_current_slot].statistics_written) return;
+    vkCmdEndQuery(cmd, m_statistics_pools[*m_current_slot], 0);
+}
+std::uint32_t vk::plugins::Profiler::begin_cpu_scope(std::string_view name) {
+    const auto scope = static_cast<std::uint32_t>(m_current.cpu.size());
+    const double now = to_ms(std::chrono::steady_clock::now() - m_frame_start);
+    m_current.cpu.push_back({.name = std::string(name), .depth = static_cast<std::uint32_t>(m_cpu_stack.size()), .begin_ms = now, .end_ms = now});
+    m_cpu_stack.push_back(scope);
+    return scope;
+}
+void vk::plugins::Profiler::end_cpu_scope(std::uint32_t scope) {
+    if (scope >= m_current.cpu.size()) return;
+    m_current.cpu[scope].end_ms = to_ms(std::chrono::steady_clock::now() - m_frame_start);
+    pop_scope(m_cpu_stack, scope);
+}
+bool vk::plugins::Profiler::export_chrome_trace(const std::filesystem::path& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::println("[profiler] cannot write {}", path.string());
+        return false;
+    }
+
+    // Complete ("X") events in microseconds; pid 1 is the process, tid 1/2 the CPU and GPU tracks.
+    out << R"({"displayTimeUnit":"ms","traceEvents":[)" << '\n';
+    out << R"({"name":"thread_name","ph":"M","pid":1,"tid":1,"args":{"name":"CPU"}},)" << '\n';
+    out << R"({"name":"thread_name","ph":"M","pid":1,"tid":2,"args":{"name":"GPU"}})";
+    const auto emit = [&](const ProfileFrame& frame, const ProfileScope& scope, int tid, std::string_view category) {
+        const double ts  = (frame.cpu_start_ms + scope.begin_ms) * 1000.0;
+        const double dur = std::max(0.0, scope.end_ms - scope.begin_ms) * 1000.0;
+        out << std::format(",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{},\"args\":{{\"frame\":{}}}}}", json_escape(scope.name), category, ts, dur, tid, frame.frame);
+    };
+    for (const auto& frame : m_history) {
+        for (const auto& scope : frame.cpu) emit(frame, scope, 1, "cpu");
+        if (frame.gpu_valid)
+            for (const auto& scope : frame.gpu) emit(frame, scope, 2, "gpu");
+    }
+    out << "\n]}\n";
+
+    std::println("[profiler] wrote {} frames to {}", m_history.size(), path.string());
+    return static_cast<bool>(out);
+}
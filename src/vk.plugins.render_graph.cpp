@@ -0,0 +1,163 @@
+module;
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+module vk.plugins.render_graph;
+
+namespace vk::plugins {
+    namespace {
+        constexpr VkAccessFlags2 kWriteAccess = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+        ResourceState write_part(const ResourceState& state) {
+            if ((state.access & kWriteAccess) == 0) return {};
+            return {state.stage, state.access & kWriteAccess};
+        }
+        bool covers(const ResourceState& visible, const ResourceState& next) {
+            return (next.stage & ~visible.stage) == 0 && (next.access & ~visible.access) == 0;
+        }
+    } // namespace
+} // namespace vk::plugins
+
+vk::plugins::RenderGraph::RenderGraph() : RenderGraph([](VkCommandBuffer cmd, const VkDependencyInfo& dep) { vkCmdPipelineBarrier2(cmd, &dep); }) {}
+vk::plugins::RenderGraph::RenderGraph(BarrierSink sink) : m_sink(std::move(sink)) {}
+vk::plugins::ResourceId vk::plugins::RenderGraph::import_image(VkImage image, VkImageAspectFlags aspect, const ResourceState& current, std::optional<ResourceState> final_state) {
+    for (ResourceId id = 0; id < m_resources.size(); ++id) {
+        if (image != VK_NULL_HANDLE && m_resources[id].image == image) return id;
+    }
+    m_resources.push_back({.image = image, .aspect = aspect, .state = current, .last_write = write_part(current), .final_state = final_state});
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+vk::plugins::ResourceId vk::plugins::RenderGraph::import_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const ResourceState& current, std::optional<ResourceState> final_state) {
+    for (ResourceId id = 0; id < m_resources.size(); ++id) {
+        const auto& r = m_resources[id];
+        if (r.buffer == buffer && r.offset == offset && r.size == size) return id;
+    }
+    m_resources.push_back({.buffer = buffer, .offset = offset, .size = size, .state = current, .last_write = write_part(current), .final_state = final_state});
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+void vk::plugins::RenderGraph::use(ResourceId id, const ResourceState& next) {
+    auto& r                  = m_resources.at(id);
+    const bool layout_change = r.image != VK_NULL_HANDLE && next.layout != r.state.layout;
+    const bool prev_writes   = (r.state.access & kWriteAccess) != 0;
+    const bool next_writes   = (next.access & kWriteAccess) != 0;
+    r.used                   = true;
+
+    if (r.pending >= 0) {
+        // A barrier into r.state is already queued; two reads can share it, anything else needs a flush in between.
+        if (layout_change || prev_writes || next_writes) throw std::logic_error("RenderGraph: conflicting uses of one resource before flush()");
+        r.state.stage |= next.stage;
+        r.state.access |= next.access;
+        r.visible.stage |= next.stage;
+        r.visible.access |= next.access;
+        if (r.image != VK_NULL_HANDLE) {
+            m_image_barriers[r.pending].dstStageMask |= next.stage;
+            m_image_barriers[r.pending].dstAccessMask |= next.access;
+        } else {
+            m_buffer_barriers[r.pending].dstStageMask |= next.stage;
+            m_buffer_barriers[r.pending].dstAccessMask |= next.access;
+        }
+        ++m_frame.elided;
+        return;
+    }
+    if (!layout_change && r.state.stage == VK_PIPELINE_STAGE_2_NONE && r.state.access == VK_ACCESS_2_NONE) {
+        r.state      = {next.stage, next.access, r.state.layout};
+        r.last_write = write_part(next);
+        ++m_frame.elided;
+        return;
+    }
+    // A read joins the current readers only if the last write is already visible to its stage and access.
+    const bool read_after_read = !layout_change && !prev_writes && !next_writes;
+    const bool no_write        = r.last_write.stage == VK_PIPELINE_STAGE_2_NONE && r.last_write.access == VK_ACCESS_2_NONE;
+    if (read_after_read && (no_write || covers(r.visible, next))) {
+        r.state.stage |= next.stage;
+        r.state.access |= next.access;
+        ++m_frame.elided;
+        return;
+    }
+
+    // Only writes need to be made available; a read before a write is a pure execution dependency. A read the last
+    // write is not yet visible to waits on that write rather than on the readers in between.
+    const VkPipelineStageFlags2 src_stage = read_after_read ? r.last_write.stage : r.state.stage;
+    const VkAccessFlags2 src_access       = read_after_read ? r.last_write.access : r.state.access & kWriteAccess;
+    const ResourceState previous          = r.state;
+    if (r.image != VK_NULL_HANDLE) {
+        r.pending = static_cast<std::int32_t>(m_image_barriers.size());
+        m_image_barriers.push_back({
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = src_stage,
+            .srcAccessMask       = src_access,
+            .dstStageMask        = next.stage,
+            .dstAccessMask       = next.access,
+            .oldLayout           = r.state.layout,
+            .newLayout           = next.layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = r.image,
+            .subresourceRange    = {r.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+        });
+        r.state = next;
+    } else {
+        r.pending = static_cast<std::int32_t>(m_buffer_barriers.size());
+        m_buffer_barriers.push_back({
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = src_stage,
+            .srcAccessMask       = src_access,
+            .dstStageMask        = next.stage,
+            .dstAccessMask       = next.access,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = r.buffer,
+            .offset              = r.offset,
+            .size                = r.size,
+        });
+        r.state = {next.stage, next.access, VK_IMAGE_LAYOUT_UNDEFINED};
+    }
+
+    if (next_writes) {
+        r.last_write = write_part(next);
+        r.visible    = {};
+    } else if (layout_change) {
+        // The transition itself is the last write; later barriers chain through the stages it was ordered before.
+        r.last_write = {next.stage, VK_ACCESS_2_NONE};
+        r.visible    = {next.stage, next.access};
+    } else {
+        r.visible.stage |= next.stage;
+        r.visible.access |= next.access;
+    }
+    // Earlier readers stay in the state so a later write still waits on all of them.
+    if (read_after_read) {
+        r.state.stage |= previous.stage;
+        r.state.access |= previous.access;
+    }
+}
+void vk::plugins::RenderGraph::flush(VkCommandBuffer cmd) {
+    if (m_image_barriers.empty() && m_buffer_barriers.empty()) return;
+
+    const VkDependencyInfo dep{
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = static_cast<std::uint32_t>(m_buffer_barriers.size()),
+        .pBufferMemoryBarriers    = m_buffer_barriers.data(),
+        .imageMemoryBarrierCount  = static_cast<std::uint32_t>(m_image_barriers.size()),
+        .pImageMemoryBarriers     = m_image_barriers.data(),
+    };
+    m_sink(cmd, dep);
+
+    ++m_frame.barrier_calls;
+    m_frame.image_barriers += static_cast<std::uint32_t>(m_image_barriers.size());
+    m_frame.buffer_barriers += static_cast<std::uint32_t>(m_buffer_barriers.size());
+    m_image_barriers.clear();
+    m_buffer_barriers.clear();
+    for (auto& r : m_resources) r.pending = -1;
+}
+void vk::plugins::RenderGraph::end_frame(VkCommandBuffer cmd) {
+    // Resources nobody used this frame are left exactly as they were imported.
+    for (ResourceId id = 0; id < m_resources.size(); ++id) {
+        const auto& r = m_resources[id];
+        if (r.used && r.final_state) use(id, *r.final_state);
+    }
+    flush(cmd);
+    m_last_frame = std::exchange(m_frame, RenderGraphStats{});
+    m_resources.clear();
+}
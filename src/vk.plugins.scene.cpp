@@ -0,0 +1,410 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64)
+#define VK_SCENE_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VK_SCENE_AVX2_TARGET
+#else
+#define VK_SCENE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define VK_SCENE_NEON 1
+#include <arm_neon.h>
+#endif
+module vk.plugins.scene;
+
+namespace vk::plugins {
+    namespace {
+        // Instances run through all four kernels before moving on, so the block's streams stay in L1/L2 between them.
+        constexpr std::size_t kBlock = 1024;
+
+        using Matrix     = std::array<const float*, 12>;
+        using MatrixOut  = std::array<float*, 12>;
+        using Vector3    = std::array<const float*, 3>;
+        using Vector3Out = std::array<float*, 3>;
+
+        template <std::size_t N>
+        std::array<const float*, N> streams(const std::array<std::vector<float>, N>& v) {
+            std::array<const float*, N> out{};
+            for (std::size_t i = 0; i < N; ++i) out[i] = v[i].data();
+            return out;
+        }
+        template <std::size_t N>
+        std::array<float*, N> streams(std::array<std::vector<float>, N>& v) {
+            std::array<float*, N> out{};
+            for (std::size_t i = 0; i < N; ++i) out[i] = v[i].data();
+            return out;
+        }
+
+        // The SIMD kernels evaluate every expression in the same order as these, without fused multiply-adds, so all
+        // levels produce identical results.
+        void transform_scalar(const Affine& p, const Matrix& local, const MatrixOut& world, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                for (std::size_t r = 0; r < 3; ++r) {
+                    for (std::size_t c = 0; c < 4; ++c) {
+                        const float v       = p[r * 4] * local[c][i] + p[r * 4 + 1] * local[4 + c][i] + p[r * 4 + 2] * local[8 + c][i];
+                        world[r * 4 + c][i] = c == 3 ? v + p[r * 4 + 3] : v;
+                    }
+                }
+            }
+        }
+        void bounds_scalar(const Matrix& w, const Vector3& center, const Vector3& extent, const Vector3Out& world_center, const Vector3Out& world_extent, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                for (std::size_t r = 0; r < 3; ++r) {
+                    world_center[r][i] = w[r * 4][i] * center[0][i] + w[r * 4 + 1][i] * center[1][i] + w[r * 4 + 2][i] * center[2][i] + w[r * 4 + 3][i];
+                    world_extent[r][i] = std::abs(w[r * 4][i]) * extent[0][i] + std::abs(w[r * 4 + 1][i]) * extent[1][i] + std::abs(w[r * 4 + 2][i]) * extent[2][i];
+                }
+            }
+        }
+        void cull_scalar(const Frustum& frustum, const Vector3& center, const Vector3& extent, std::uint8_t* visible, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                bool inside = true;
+                for (const Plane& p : frustum) {
+                    const float d = p.normal[0] * center[0][i] + p.normal[1] * center[1][i] + p.normal[2] * center[2][i] + p.distance;
+                    const float r = std::abs(p.normal[0]) * extent[0][i] + std::abs(p.normal[1]) * extent[1][i] + std::abs(p.normal[2]) * extent[2][i];
+                    inside &= d + r >= 0.0f;
+                }
+                visible[i] = inside ? 1 : 0;
+            }
+        }
+        void keys_scalar(const std::array<float, 16>& vp, const Vector3& center, std::uint32_t* keys, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) keys[i] = depth_sort_key(vp[2] * center[0][i] + vp[6] * center[1][i] + vp[10] * center[2][i] + vp[14]);
+        }
+
+#if defined(VK_SCENE_AVX2)
+        bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int regs[4]{};
+            __cpuid(regs, 1);
+            const bool os_saves_ymm = (regs[2] & (1 << 27)) != 0 && (regs[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+            if (!os_saves_ymm) return false;
+            __cpuidex(regs, 7, 0);
+            return (regs[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }
+
+        VK_SCENE_AVX2_TARGET void transform_avx2(const Affine& p, const Matrix& local, const MatrixOut& world, std::size_t begin, std::size_t end) {
+            std::size_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256 l[12];
+                for (std::size_t k = 0; k < 12; ++k) l[k] = _mm256_loadu_ps(local[k] + i);
+                for (std::size_t r = 0; r < 3; ++r) {
+                    const __m256 p0 = _mm256_broadcast_ss(&p[r * 4]);
+                    const __m256 p1 = _mm256_broadcast_ss(&p[r * 4 + 1]);
+                    const __m256 p2 = _mm256_broadcast_ss(&p[r * 4 + 2]);
+                    for (std::size_t c = 0; c < 4; ++c) {
+                        __m256 v = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p0, l[c]), _mm256_mul_ps(p1, l[4 + c])), _mm256_mul_ps(p2, l[8 + c]));
+                        if (c == 3) v = _mm256_add_ps(v, _mm256_broadcast_ss(&p[r * 4 + 3]));
+                        _mm256_storeu_ps(world[r * 4 + c] + i, v);
+                    }
+                }
+            }
+            transform_scalar(p, local, world, i, end);
+        }
+        VK_SCENE_AVX2_TARGET void bounds_avx2(const Matrix& w, const Vector3& center, const Vector3& extent, const Vector3Out& world_center, const Vector3Out& world_extent, std::size_t begin, std::size_t end) {
+            const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+            std::size_t i         = begin;
+            for (; i + 8 <= end; i += 8) {
+                const __m256 c0 = _mm256_loadu_ps(center[0] + i);
+                const __m256 c1 = _mm256_loadu_ps(center[1] + i);
+                const __m256 c2 = _mm256_loadu_ps(center[2] + i);
+                const __m256 e0 = _mm256_loadu_ps(extent[0] + i);
+                const __m256 e1 = _mm256_loadu_ps(extent[1] + i);
+                const __m256 e2 = _mm256_loadu_ps(extent[2] + i);
+                for (std::size_t r = 0; r < 3; ++r) {
+                    const __m256 m0 = _mm256_loadu_ps(w[r * 4] + i);
+                    const __m256 m1 = _mm256_loadu_ps(w[r * 4 + 1] + i);
+                    const __m256 m2 = _mm256_loadu_ps(w[r * 4 + 2] + i);
+                    const __m256 m3 = _mm256_loadu_ps(w[r * 4 + 3] + i);
+                    const __m256 wc = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, c0), _mm256_mul_ps(m1, c1)), _mm256_mul_ps(m2, c2)), m3);
+                    const __m256 we = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_and_ps(m0, abs_mask), e0), _mm256_mul_ps(_mm256_and_ps(m1, abs_mask), e1)), _mm256_mul_ps(_mm256_and_ps(m2, abs_mask), e2));
+                    _mm256_storeu_ps(world_center[r] + i, wc);
+                    _mm256_storeu_ps(world_extent[r] + i, we);
+                }
+            }
+            bounds_scalar(w, center, extent, world_center, world_extent, i, end);
+        }
+        VK_SCENE_AVX2_TARGET void cull_avx2(const Frustum& frustum, const Vector3& center, const Vector3& extent, std::uint8_t* visible, std::size_t begin, std::size_t end) {
+            const __m256 zero = _mm256_setzero_ps();
+            std::size_t i     = begin;
+            for (; i + 8 <= end; i += 8) {
+                const __m256 c0 = _mm256_loadu_ps(center[0] + i);
+                const __m256 c1 = _mm256_loadu_ps(center[1] + i);
+                const __m256 c2 = _mm256_loadu_ps(center[2] + i);
+                const __m256 e0 = _mm256_loadu_ps(extent[0] + i);
+                const __m256 e1 = _mm256_loadu_ps(extent[1] + i);
+                const __m256 e2 = _mm256_loadu_ps(extent[2] + i);
+                __m256 inside   = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (const Plane& p : frustum) {
+                    const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.normal[0]), c0), _mm256_mul_ps(_mm256_set1_ps(p.normal[1]), c1)), _mm256_mul_ps(_mm256_set1_ps(p.normal[2]), c2)), _mm256_set1_ps(p.distance));
+                    const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal[0])), e0), _mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal[1])), e1)), _mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal[2])), e2));
+                    inside         = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+                }
+                const int mask = _mm256_movemask_ps(inside);
+                for (std::size_t k = 0; k < 8; ++k) visible[i + k] = static_cast<std::uint8_t>((mask >> k) & 1);
+            }
+            cull_scalar(frustum, center, extent, visible, i, end);
+        }
+        VK_SCENE_AVX2_TARGET void keys_avx2(const std::array<float, 16>& vp, const Vector3& center, std::uint32_t* keys, std::size_t begin, std::size_t end) {
+            const __m256 r0   = _mm256_set1_ps(vp[2]);
+            const __m256 r1   = _mm256_set1_ps(vp[6]);
+            const __m256 r2   = _mm256_set1_ps(vp[10]);
+            const __m256 r3   = _mm256_set1_ps(vp[14]);
+            const __m256i top = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+            std::size_t i     = begin;
+            for (; i + 8 <= end; i += 8) {
+                const __m256 z     = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r0, _mm256_loadu_ps(center[0] + i)), _mm256_mul_ps(r1, _mm256_loadu_ps(center[1] + i))), _mm256_mul_ps(r2, _mm256_loadu_ps(center[2] + i))), r3);
+                const __m256i bits = _mm256_castps_si256(z);
+                const __m256i flip = _mm256_or_si256(_mm256_srai_epi32(bits, 31), top);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys + i), _mm256_xor_si256(bits, flip));
+            }
+            keys_scalar(vp, center, keys, i, end);
+        }
+#endif
+
+#if defined(VK_SCENE_NEON)
+        void transform_neon(const Affine& p, const Matrix& local, const MatrixOut& world, std::size_t begin, std::size_t end) {
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                float32x4_t l[12];
+                for (std::size_t k = 0; k < 12; ++k) l[k] = vld1q_f32(local[k] + i);
+                for (std::size_t r = 0; r < 3; ++r) {
+                    const float32x4_t p0 = vdupq_n_f32(p[r * 4]);
+                    const float32x4_t p1 = vdupq_n_f32(p[r * 4 + 1]);
+                    const float32x4_t p2 = vdupq_n_f32(p[r * 4 + 2]);
+                    for (std::size_t c = 0; c < 4; ++c) {
+                        float32x4_t v = vaddq_f32(vaddq_f32(vmulq_f32(p0, l[c]), vmulq_f32(p1, l[4 + c])), vmulq_f32(p2, l[8 + c]));
+                        if (c == 3) v = vaddq_f32(v, vdupq_n_f32(p[r * 4 + 3]));
+                        vst1q_f32(world[r * 4 + c] + i, v);
+                    }
+                }
+            }
+            transform_scalar(p, local, world, i, end);
+        }
+        void bounds_neon(const Matrix& w, const Vector3& center, const Vector3& extent, const Vector3Out& world_center, const Vector3Out& world_extent, std::size_t begin, std::size_t end) {
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                const float32x4_t c0 = vld1q_f32(center[0] + i);
+                const float32x4_t c1 = vld1q_f32(center[1] + i);
+                const float32x4_t c2 = vld1q_f32(center[2] + i);
+                const float32x4_t e0 = vld1q_f32(extent[0] + i);
+                const float32x4_t e1 = vld1q_f32(extent[1] + i);
+                const float32x4_t e2 = vld1q_f32(extent[2] + i);
+                for (std::size_t r = 0; r < 3; ++r) {
+                    const float32x4_t m0 = vld1q_f32(w[r * 4] + i);
+                    const float32x4_t m1 = vld1q_f32(w[r * 4 + 1] + i);
+                    const float32x4_t m2 = vld1q_f32(w[r * 4 + 2] + i);
+                    const float32x4_t m3 = vld1q_f32(w[r * 4 + 3] + i);
+                    vst1q_f32(world_center[r] + i, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m0, c0), vmulq_f32(m1, c1)), vmulq_f32(m2, c2)), m3));
+                    vst1q_f32(world_extent[r] + i, vaddq_f32(vaddq_f32(vmulq_f32(vabsq_f32(m0), e0), vmulq_f32(vabsq_f32(m1), e1)), vmulq_f32(vabsq_f32(m2), e2)));
+                }
+            }
+            bounds_scalar(w, center, extent, world_center, world_extent, i, end);
+        }
+        void cull_neon(const Frustum& frustum, const Vector3& center, const Vector3& extent, std::uint8_t* visible, std::size_t begin, std::size_t end) {
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            std::size_t i          = begin;
+            for (; i + 4 <= end; i += 4) {
+                const float32x4_t c0 = vld1q_f32(center[0] + i);
+                const float32x4_t c1 = vld1q_f32(center[1] + i);
+                const float32x4_t c2 = vld1q_f32(center[2] + i);
+                const float32x4_t e0 = vld1q_f32(extent[0] + i);
+                const float32x4_t e1 = vld1q_f32(extent[1] + i);
+                const float32x4_t e2 = vld1q_f32(extent[2] + i);
+                uint32x4_t inside    = vdupq_n_u32(~0u);
+                for (const Plane& p : frustum) {
+                    const float32x4_t d = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(c0, p.normal[0]), vmulq_n_f32(c1, p.normal[1])), vmulq_n_f32(c2, p.normal[2])), vdupq_n_f32(p.distance));
+                    const float32x4_t r = vaddq_f32(vaddq_f32(vmulq_n_f32(e0, std::abs(p.normal[0])), vmulq_n_f32(e1, std::abs(p.normal[1]))), vmulq_n_f32(e2, std::abs(p.normal[2])));
+                    inside              = vandq_u32(inside, vcgeq_f32(vaddq_f32(d, r), zero));
+                }
+                const uint16x4_t narrow = vmovn_u32(inside);
+                const uint8x8_t bytes   = vand_u8(vmovn_u16(vcombine_u16(narrow, narrow)), vdup_n_u8(1));
+                vst1_lane_u32(reinterpret_cast<std::uint32_t*>(visible + i), vreinterpret_u32_u8(bytes), 0);
+            }
+            cull_scalar(frustum, center, extent, visible, i, end);
+        }
+        void keys_neon(const std::array<float, 16>& vp, const Vector3& center, std::uint32_t* keys, std::size_t begin, std::size_t end) {
+            const uint32x4_t top = vdupq_n_u32(0x80000000u);
+            std::size_t i        = begin;
+            for (; i + 4 <= end; i += 4) {
+                const float32x4_t z   = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(vld1q_f32(center[0] + i), vp[2]), vmulq_n_f32(vld1q_f32(center[1] + i), vp[6])), vmulq_n_f32(vld1q_f32(center[2] + i), vp[10])), vdupq_n_f32(vp[14]));
+                const uint32x4_t bits = vreinterpretq_u32_f32(z);
+                const uint32x4_t flip = vorrq_u32(vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(bits), 31)), top);
+                vst1q_u32(keys + i, veorq_u32(bits, flip));
+            }
+            keys_scalar(vp, center, keys, i, end);
+        }
+#endif
+
+        SimdLevel usable(SimdLevel level) {
+            return level == best_simd_level() ? level : SimdLevel::Scalar;
+        }
+    } // namespace
+
+    SimdLevel best_simd_level() {
+#if defined(VK_SCENE_NEON)
+        return SimdLevel::Neon;
+#elif defined(VK_SCENE_AVX2)
+        static const SimdLevel level = cpu_has_avx2() ? SimdLevel::Avx2 : SimdLevel::Scalar;
+        return level;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+    const char* simd_level_name(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Neon: return "neon";
+        case SimdLevel::Scalar: break;
+        }
+        return "scalar";
+    }
+} // namespace vk::plugins
+
+std::uint32_t vk::plugins::SceneInstances::add(const SceneInstance& instance) {
+    const auto index = static_cast<std::uint32_t>(size());
+    resize(size() + 1);
+    set(index, instance);
+    return index;
+}
+void vk::plugins::SceneInstances::set(std::uint32_t index, const SceneInstance& instance) {
+    for (std::size_t k = 0; k < 12; ++k) m_local[k][index] = instance.local[k];
+    for (std::size_t k = 0; k < 3; ++k) {
+        m_center[k][index] = instance.center[k];
+        m_extent[k][index] = instance.extent[k];
+    }
+    m_color[index] = instance.color;
+}
+void vk::plugins::SceneInstances::resize(std::size_t count) {
+    for (std::size_t k = 0; k < 12; ++k) {
+        m_local[k].resize(count, kIdentityAffine[k]);
+        m_world[k].resize(count);
+    }
+    for (std::size_t k = 0; k < 3; ++k) {
+        m_center[k].resize(count);
+        m_extent[k].resize(count, 0.5f);
+        m_world_center[k].resize(count);
+        m_world_extent[k].resize(count);
+    }
+    m_color.resize(count, 0xffffffff);
+    m_visible.resize(count);
+    m_depth_key.resize(count);
+}
+void vk::plugins::SceneInstances::clear() {
+    resize(0);
+    m_sort_keys.clear();
+    m_stats = {};
+}
+void vk::plugins::SceneInstances::transform(SimdLevel level, const Affine& parent, std::size_t begin, std::size_t end) {
+    const Matrix local    = streams(std::as_const(m_local));
+    const MatrixOut world = streams(m_world);
+    switch (usable(level)) {
+#if defined(VK_SCENE_AVX2)
+    case SimdLevel::Avx2: return transform_avx2(parent, local, world, begin, end);
+#endif
+#if defined(VK_SCENE_NEON)
+    case SimdLevel::Neon: return transform_neon(parent, local, world, begin, end);
+#endif
+    default: return transform_scalar(parent, local, world, begin, end);
+    }
+}
+void vk::plugins::SceneInstances::compute_bounds(SimdLevel level, std::size_t begin, std::size_t end) {
+    const Matrix world        = streams(std::as_const(m_world));
+    const Vector3 center      = streams(std::as_const(m_center));
+    const Vector3 extent      = streams(std::as_const(m_extent));
+    const Vector3Out w_center = streams(m_world_center);
+    const Vector3Out w_extent = streams(m_world_extent);
+    switch (usable(level)) {
+#if defined(VK_SCENE_AVX2)
+    case SimdLevel::Avx2: return bounds_avx2(world, center, extent, w_center, w_extent, begin, end);
+#endif
+#if defined(VK_SCENE_NEON)
+    case SimdLevel::Neon: return bounds_neon(world, center, extent, w_center, w_extent, begin, end);
+#endif
+    default: return bounds_scalar(world, center, extent, w_center, w_extent, begin, end);
+    }
+}
+void vk::plugins::SceneInstances::cull(SimdLevel level, const Frustum& frustum, std::size_t begin, std::size_t end) {
+    const Vector3 center = streams(std::as_const(m_world_center));
+    const Vector3 extent = streams(std::as_const(m_world_extent));
+    switch (usable(level)) {
+#if defined(VK_SCENE_AVX2)
+    case SimdLevel::Avx2: return cull_avx2(frustum, center, extent, m_visible.data(), begin, end);
+#endif
+#if defined(VK_SCENE_NEON)
+    case SimdLevel::Neon: return cull_neon(frustum, center, extent, m_visible.data(), begin, end);
+#endif
+    default: return cull_scalar(frustum, center, extent, m_visible.data(), begin, end);
+    }
+}
+void vk::plugins::SceneInstances::depth_keys(SimdLevel level, const std::array<float, 16>& view_proj, std::size_t begin, std::size_t end) {
+    const Vector3 center = streams(std::as_const(m_world_center));
+    switch (usable(level)) {
+#if defined(VK_SCENE_AVX2)
+    case SimdLevel::Avx2: return keys_avx2(view_proj, center, m_depth_key.data(), begin, end);
+#endif
+#if defined(VK_SCENE_NEON)
+    case SimdLevel::Neon: return keys_neon(view_proj, center, m_depth_key.data(), begin, end);
+#endif
+    default: return keys_scalar(view_proj, center, m_depth_key.data(), begin, end);
+    }
+}
+void vk::plugins::SceneInstances::prepare(const Affine& parent, const std::array<float, 16>& view_proj, SimdLevel level, ThreadPool* pool) {
+    const auto start      = std::chrono::steady_clock::now();
+    const Frustum frustum = extract_frustum(view_proj);
+    level                 = usable(level);
+    const auto body       = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t block = begin; block < end; block += kBlock) {
+            const std::size_t block_end = std::min(block + kBlock, end);
+            transform(level, parent, block, block_end);
+            compute_bounds(level, block, block_end);
+            cull(level, frustum, block, block_end);
+            depth_keys(level, view_proj, block, block_end);
+        }
+    };
+    if (pool != nullptr) {
+        pool->parallel_for(size(), kPrepareGrain, body);
+    } else {
+        body(0, size());
+    }
+    m_stats.instances    = static_cast<std::uint32_t>(size());
+    m_stats.level        = level;
+    m_stats.prepare_time = std::chrono::steady_clock::now() - start;
+}
+std::size_t vk::plugins::SceneInstances::sorted_visible(std::vector<std::uint32_t>& out) {
+    const auto start = std::chrono::steady_clock::now();
+    // Index in the low half: equal depths stay in index order and the order is the same on every run.
+    m_sort_keys.clear();
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (m_visible[i] != 0) m_sort_keys.push_back(static_cast<std::uint64_t>(m_depth_key[i]) << 32 | i);
+    }
+    std::ranges::sort(m_sort_keys);
+    out.resize(m_sort_keys.size());
+    for (std::size_t i = 0; i < m_sort_keys.size(); ++i) out[i] = static_cast<std::uint32_t>(m_sort_keys[i]);
+    m_stats.visible   = static_cast<std::uint32_t>(out.size());
+    m_stats.sort_time = std::chrono::steady_clock::now() - start;
+    return out.size();
+}
+vk::plugins::Affine vk::plugins::SceneInstances::world(std::size_t index) const {
+    Affine out{};
+    for (std::size_t k = 0; k < 12; ++k) out[k] = m_world[k][index];
+    return out;
+}
+std::array<float, 3> vk::plugins::SceneInstances::world_center(std::size_t index) const {
+    return {m_world_center[0][index], m_world_center[1][index], m_world_center[2][index]};
+}
+std::array<float, 3> vk::plugins::SceneInstances::world_extent(std::size_t index) const {
+    return {m_world_extent[0][index], m_world_extent[1][index], m_world_extent[2][index]};
+}
@@ -0,0 +1,248 @@
+module;
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
+module vk.plugins.shader;
+import vk.plugins.pipeline_cache;
+
+namespace vk::plugins {
+    namespace {
+        constexpr std::uint32_t kSpirvMagic         = 0x07230203u;
+        constexpr std::size_t kSpirvHeaderWordCount = 5;
+    } // namespace
+
+    std::span<const std::uint32_t> as_spirv(std::span<const std::byte> bytes, const std::filesystem::path& origin) {
+        if (bytes.size() < kSpirvHeaderWordCount * sizeof(std::uint32_t)) throw std::runtime_error("SPIR-V too small: " + origin.string());
+        if (bytes.size() % sizeof(std::uint32_t) != 0) throw std::runtime_error("SPIR-V size is not a multiple of 4: " + origin.string());
+        if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(std::uint32_t) != 0) throw std::runtime_error("SPIR-V is not 4-byte aligned: " + origin.string());
+        const auto* words = reinterpret_cast<const std::uint32_t*>(bytes.data());
+        if (words[0] != kSpirvMagic) throw std::runtime_error("Bad SPIR-V magic (wrong file or endianness): " + origin.string());
+        return {words, bytes.size() / sizeof(std::uint32_t)};
+    }
+} // namespace vk::plugins
+
+vk::plugins::MappedFile::MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open " + path.string());
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("Empty file " + path.string());
+    }
+    HANDLE mapping   = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map " + path.string());
+    }
+    m_file    = file;
+    m_mapping = mapping;
+    m_data    = view;
+    m_size    = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Failed to open " + path.string());
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Empty or unreadable file " + path.string());
+    }
+    void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) throw std::runtime_error("Failed to map " + path.string());
+    m_data = view;
+    m_size = static_cast<std::size_t>(st.st_size);
+#endif
+}
+vk::plugins::MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+vk::plugins::MappedFile& vk::plugins::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+        m_file    = std::exchange(other.m_file, nullptr);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+vk::plugins::MappedFile::~MappedFile() {
+    close();
+}
+void vk::plugins::MappedFile::close() {
+    if (m_data == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_file    = nullptr;
+    m_mapping = nullptr;
+#else
+    ::munmap(const_cast<void*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+vk::plugins::ShaderRef::ShaderRef(ShaderRef&& other) noexcept : m_eng(std::exchange(other.m_eng, nullptr)), m_key(other.m_key) {}
+vk::plugins::ShaderRef& vk::plugins::ShaderRef::operator=(ShaderRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_eng = std::exchange(other.m_eng, nullptr);
+        m_key = other.m_key;
+    }
+    return *this;
+}
+vk::plugins::ShaderRef::~ShaderRef() {
+    reset();
+}
+void vk::plugins::ShaderRef::reset() {
+    if (m_eng == nullptr) return;
+    ShaderLibrary::shared().release(*std::exchange(m_eng, nullptr), m_key);
+}
+
+vk::plugins::ShaderLibrary& vk::plugins::ShaderLibrary::shared() {
+    static ShaderLibrary library;
+    return library;
+}
+std::uint64_t vk::plugins::ShaderLibrary::acquire(const context::EngineContext& eng, const std::filesystem::path& path) {
+    const MappedFile file(path);
+    const auto words        = as_spirv(file.bytes(), path);
+    const std::uint64_t key = hash_bytes(file.bytes());
+
+    std::scoped_lock lock(m_mutex);
+    Device& device = m_devices[eng.device];
+    Entry& entry   = device.entries[key];
+    if (entry.module == VK_NULL_HANDLE) {
+        entry.path   = path;
+        entry.module = create_module(eng, words, device.identifiers, entry);
+    }
+    ++entry.refs;
+    return key;
+}
+void vk::plugins::ShaderLibrary::release(const context::EngineContext& eng, std::uint64_t key) {
+    std::scoped_lock lock(m_mutex);
+    const auto device = m_devices.find(eng.device);
+    if (device == m_devices.end()) return;
+    const auto it = device->second.entries.find(key);
+    if (it == device->second.entries.end() || it->second.refs == 0) return;
+    if (--it->second.refs > 0) return;
+
+    vkDestroyShaderModule(eng.device, it->second.module, nullptr);
+    it->second.module = VK_NULL_HANDLE;
+    if (it->second.identifier.empty()) device->second.entries.erase(it);
+}
+vk::plugins::ShaderRef vk::plugins::ShaderLibrary::reacquire(const context::EngineContext& eng, std::uint64_t key) {
+    std::filesystem::path path;
+    {
+        std::scoped_lock lock(m_mutex);
+        const auto device = m_devices.find(eng.device);
+        if (device == m_devices.end()) return {};
+        const auto it = device->second.entries.find(key);
+        if (it == device->second.entries.end()) return {};
+        path = it->second.path;
+    }
+    const MappedFile file(path);
+    if (hash_bytes(file.bytes()) != key) return {};
+    const auto words = as_spirv(file.bytes(), path);
+
+    std::scoped_lock lock(m_mutex);
+    Device& device = m_devices[eng.device];
+    Entry& entry   = device.entries[key];
+    if (entry.module == VK_NULL_HANDLE) entry.module = create_module(eng, words, device.identifiers, entry);
+    ++entry.refs;
+    return {eng, key};
+}
+void vk::plugins::ShaderLibrary::set_module_identifiers(const context::EngineContext& eng, bool enabled) {
+    std::scoped_lock lock(m_mutex);
+    m_devices[eng.device].identifiers = enabled;
+}
+bool vk::plugins::ShaderLibrary::describe_stage(const context::EngineContext& eng, std::uint64_t key, VkShaderStageFlagBits stage, VkPipelineShaderStageCreateInfo& info, VkPipelineShaderStageModuleIdentifierCreateInfoEXT& identifier, ShaderRef& hold) {
+    ShaderRef previous = std::move(hold);
+    std::scoped_lock lock(m_mutex);
+    Device& device = m_devices.at(eng.device);
+    Entry& entry   = device.entries.at(key);
+    info           = {
+        .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage  = stage,
+        .module = entry.module,
+        .pName  = "main",
+    };
+    if (entry.module != VK_NULL_HANDLE) {
+        // Taken under the same lock that read the handle, so no release can slip in between.
+        ++entry.refs;
+        hold = ShaderRef(eng, key);
+        return false;
+    }
+    if (entry.identifier.empty() || !device.identifiers) throw std::runtime_error("Shader module released and no identifier available: " + entry.path.string());
+
+    identifier = {
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_MODULE_IDENTIFIER_CREATE_INFO_EXT,
+        .identifierSize = static_cast<std::uint32_t>(entry.identifier.size()),
+        .pIdentifier    = entry.identifier.data(),
+    };
+    info.pNext = &identifier;
+    return true;
+}
+bool vk::plugins::ShaderLibrary::has_identifier(const context::EngineContext& eng, std::uint64_t key) const {
+    std::scoped_lock lock(m_mutex);
+    const auto device = m_devices.find(eng.device);
+    if (device == m_devices.end()) return false;
+    const auto it = device->second.entries.find(key);
+    return it != device->second.entries.end() && !it->second.identifier.empty();
+}
+std::size_t vk::plugins::ShaderLibrary::module_count(const context::EngineContext& eng) const {
+    std::scoped_lock lock(m_mutex);
+    const auto device = m_devices.find(eng.device);
+    if (device == m_devices.end()) return 0;
+    std::size_t count = 0;
+    for (const auto& [key, entry] : device->second.entries) count += entry.module != VK_NULL_HANDLE ? 1 : 0;
+    return count;
+}
+VkShaderModule vk::plugins::ShaderLibrary::create_module(const context::EngineContext& eng, std::span<const std::uint32_t> words, bool identifiers, Entry& entry) {
+    // The mapped words go straight to the driver; no intermediate copy.
+    const VkShaderModuleCreateInfo ci{
+        .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = words.size_bytes(),
+        .pCode    = words.data(),
+    };
+    VkShaderModule module = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateShaderModule(eng.device, &ci, nullptr, &module));
+
+    // Without a stored identifier describe_stage never takes the identifier path, so that is gated here too.
+    if (!identifiers || !entry.identifier.empty()) return module;
+    const auto get_identifier = reinterpret_cast<PFN_vkGetShaderModuleIdentifierEXT>(vkGetDeviceProcAddr(eng.device, "vkGetShaderModuleIdentifierEXT"));
+    if (get_identifier != nullptr) {
+        VkShaderModuleIdentifierEXT id{.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT};
+        get_identifier(eng.device, module, &id);
+        entry.identifier.assign(id.identifier, id.identifier + id.identifierSize);
+    }
+    return module;
+}
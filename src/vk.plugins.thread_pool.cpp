@@ -0,0 +1,97 @@
+module;
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+module vk.plugins.thread_pool;
+
+vk::plugins::ThreadPool::ThreadPool(std::uint32_t worker_count) {
+    // hardware_concurrency() may report 0 when it cannot tell.
+    if (worker_count == 0) worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1u;
+    m_workers.reserve(worker_count);
+    for (std::uint32_t i = 0; i < worker_count; ++i) m_workers.emplace_back([this, i](const std::stop_token& stop) { run(i, stop); });
+}
+vk::plugins::ThreadPool::~ThreadPool() {
+    for (auto& worker : m_workers) worker.request_stop();
+    m_wake.notify_all();
+    m_workers.clear();
+}
+void vk::plugins::ThreadPool::submit(std::function<void(std::uint32_t worker)> task) {
+    {
+        std::scoped_lock lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+void vk::plugins::ThreadPool::wait_idle() {
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_tasks.empty() && m_active == 0; });
+    if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+}
+void vk::plugins::ThreadPool::parallel_for(std::size_t count, std::size_t grain, const std::function<void(std::size_t begin, std::size_t end)>& body) {
+    if (count == 0) return;
+    grain                    = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = std::min<std::size_t>((count + grain - 1) / grain, m_workers.size() + 1);
+    const std::size_t step   = (count + chunks - 1) / chunks;
+    // Rounding the step up can leave fewer ranges than chunks (5 items over 4 chunks is 3 ranges of 2), and the latch
+    // must count exactly the ranges submitted.
+    const std::size_t ranges = (count + step - 1) / step;
+    if (ranges == 1) {
+        body(0, count);
+        return;
+    }
+
+    std::latch done(static_cast<std::ptrdiff_t>(ranges - 1));
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto run_range = [&](std::size_t begin) {
+        try {
+            body(begin, std::min(begin + step, count));
+        } catch (...) {
+            std::scoped_lock lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    };
+    for (std::size_t begin = step; begin < count; begin += step) {
+        submit([&, begin](std::uint32_t) {
+            run_range(begin);
+            done.count_down();
+        });
+    }
+    run_range(0);
+    done.wait();
+    if (error) std::rethrow_exception(error);
+}
+std::size_t vk::plugins::ThreadPool::pending() const {
+    std::scoped_lock lock(m_mutex);
+    return m_tasks.size();
+}
+void vk::plugins::ThreadPool::run(std::uint32_t worker, const std::stop_token& stop) {
+    while (true) {
+        std::function<void(std::uint32_t)> task;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_wake.wait(lock, stop, [this] { return !m_tasks.empty(); })) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_active;
+        }
+        std::exception_ptr error;
+        try {
+            task(worker);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::scoped_lock lock(m_mutex);
+            if (error && !m_error) m_error = std::move(error);
+            --m_active;
+        }
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,125 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <print>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+module vk.plugins.upload;
+
+namespace vk::plugins {
+    namespace {
+        // The largest offset alignment any limit may require, so every region starts suitably aligned for any use.
+        constexpr VkDeviceSize kRegionAlignment = 256;
+
+        double to_kib(double bytes) {
+            return bytes / 1024.0;
+        }
+    } // namespace
+} // namespace vk::plugins
+
+void vk::plugins::UploadRegions::reset(VkDeviceSize region_size) {
+    m_region_size   = region_size;
+    m_wanted_region = region_size;
+    m_region.reset(region_size);
+}
+bool vk::plugins::UploadRegions::begin_frame(std::uint32_t frame_slot) {
+    // The next ring holds everything the last frame asked for: what fit in its region plus every overflow.
+    if (m_frame_overflow > 0) m_wanted_region = std::max(m_wanted_region, align_up(m_region.used() + m_frame_overflow, kRegionAlignment));
+    m_frame_overflow = 0;
+    const bool grow  = m_wanted_region > m_region_size;
+    if (grow) reset(std::bit_ceil(m_wanted_region));
+    m_frame_slot = frame_slot;
+    m_region.reset(m_region_size);
+    return grow;
+}
+std::optional<VkDeviceSize> vk::plugins::UploadRegions::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (const auto offset = m_region.allocate(size, alignment)) return m_region_size * m_frame_slot + *offset;
+    m_frame_overflow += size + alignment; // worst-case padding, had it been placed in the region
+    return std::nullopt;
+}
+
+void vk::plugins::UploadArena::initialize(const context::EngineContext& eng, const DeviceFeatures& features, VkDeviceSize frame_bytes, VkBufferUsageFlags usage) {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(eng.physical, &props);
+
+    m_eng               = &eng;
+    m_usage             = usage | (features.buffer_device_address ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0);
+    m_uniform_alignment = props.limits.minUniformBufferOffsetAlignment;
+    m_storage_alignment = props.limits.minStorageBufferOffsetAlignment;
+    m_stats             = {};
+    m_regions.reset(align_up(std::max<VkDeviceSize>(frame_bytes, 1), kRegionAlignment));
+    create_ring(eng);
+}
+void vk::plugins::UploadArena::destroy(const context::EngineContext& eng) {
+    if (m_ring.buffer == VK_NULL_HANDLE) return;
+    for (std::uint32_t slot = 0; slot < context::FRAME_OVERLAP; ++slot) {
+        for (auto& buffer : m_retired.release(slot)) destroy_buffer(eng, buffer);
+    }
+    destroy_buffer(eng, m_ring);
+    m_regions      = {};
+    m_base_address = 0;
+    m_in_frame     = false;
+    m_eng          = nullptr;
+}
+void vk::plugins::UploadArena::begin_frame(const context::EngineContext& eng, std::uint32_t frame_slot) {
+    if (std::exchange(m_in_frame, true)) end_frame();
+    for (auto& buffer : m_retired.release(frame_slot)) destroy_buffer(eng, buffer);
+
+    // Last frame overflowed: move to a ring that would have held it. Frames still in flight keep reading the old
+    // one, which is freed with this slot's next frame, by when all of them have retired.
+    if (m_regions.begin_frame(frame_slot)) {
+        m_retired.retire(frame_slot, std::exchange(m_ring, GpuBuffer{}));
+        create_ring(eng);
+        ++m_stats.growths;
+    }
+}
+vk::plugins::UploadAllocation vk::plugins::UploadArena::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    m_frame_bytes += size;
+    if (const auto offset = m_regions.allocate(size, alignment)) {
+        return {
+            .data    = static_cast<std::byte*>(m_ring.mapped) + *offset,
+            .buffer  = m_ring.buffer,
+            .offset  = *offset,
+            .size    = size,
+            .address = m_base_address != 0 ? m_base_address + *offset : 0,
+        };
+    }
+
+    // Region exhausted: serve this one from a dedicated buffer rather than failing the frame.
+    ++m_stats.overflows;
+    m_stats.overflow_bytes += size;
+    GpuBuffer buffer = create_buffer(*m_eng, std::max<VkDeviceSize>(size, 1), m_usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    UploadAllocation out{.data = buffer.mapped, .buffer = buffer.buffer, .offset = 0, .size = size};
+    if (m_usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        const VkBufferDeviceAddressInfo info{.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = buffer.buffer};
+        out.address = vkGetBufferDeviceAddress(m_eng->device, &info);
+    }
+    m_retired.retire(m_regions.frame_slot(), buffer);
+    return out;
+}
+void vk::plugins::UploadArena::create_ring(const context::EngineContext& eng) {
+    const VkDeviceSize region_size = m_regions.region_size();
+    m_ring                         = create_buffer(eng, region_size * context::FRAME_OVERLAP, m_usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_base_address                 = 0;
+    if (m_usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        const VkBufferDeviceAddressInfo info{.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = m_ring.buffer};
+        m_base_address = vkGetBufferDeviceAddress(eng.device, &info);
+    }
+    m_stats.region_size = region_size;
+}
+void vk::plugins::UploadArena::end_frame() {
+    constexpr std::uint32_t report_interval = 600;
+    ++m_stats.frames;
+    m_stats.bytes += m_frame_bytes;
+    m_stats.last_frame_bytes = m_frame_bytes;
+    m_stats.peak_frame_bytes = std::max(m_stats.peak_frame_bytes, m_frame_bytes);
+    m_frame_bytes            = 0;
+    if (m_stats.frames < report_interval) return;
+
+    std::println("[upload] frames={} avg {:.1f} KiB/frame, peak {:.1f} KiB, region {:.1f} KiB, overflows={} ({:.1f} KiB), growths={}", m_stats.frames, to_kib(static_cast<double>(m_stats.bytes) / m_stats.frames), to_kib(static_cast<double>(m_stats.peak_frame_bytes)), to_kib(static_cast<double>(m_stats.region_size)), m_stats.overflows, to_kib(static_cast<double>(m_stats.overflow_bytes)), m_stats.growths);
+    m_stats = {.region_size = m_regions.region_size()};
+}
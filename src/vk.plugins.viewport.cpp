@@ -1,103 +1,137 @@
 module;
 #include <SDL3/SDL.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <backends/imgui_impl_sdl3.h>
 #include <backends/imgui_impl_vulkan.h>
-#include <fstream>
+#include <cfloat>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <imgui.h>
+#include <memory>
+#include <optional>
 #include <print>
+#include <span>
 #include <stdexcept>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <vulkan/vulkan.h>
+#include "vk.plugins.check.hpp"
 module vk.plugins.viewport;
 
-// clang-format off
-#ifndef VK_CHECK
-#define VK_CHECK(x) do { VkResult _vk_check_res = (x); if (_vk_check_res != VK_SUCCESS) { throw std::runtime_error(std::string("Vulkan error ") + std::to_string(_vk_check_res) + " at " #x); } } while (false)
-#endif
-// clang-format on
-
 namespace vk::plugins {
-    static void transition_image_layout(VkCommandBuffer& cmd, const vk::context::AttachmentView& target, VkImageLayout old_layout, VkImageLayout new_layout) {
-        auto [src_stage, dst_stage, src_access, dst_access] = [&]() -> std::array<std::uint64_t, 4> {
-            if (old_layout == VK_IMAGE_LAYOUT_GENERAL && new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-                return {
-                    VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-                    VK_ACCESS_2_MEMORY_WRITE_BIT,
-                    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-                };
-
-            return {
-                VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-                VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
-            };
-        }();
-
-        VkImageMemoryBarrier2 barrier{
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-            .srcStageMask     = src_stage,
-            .srcAccessMask    = src_access,
-            .dstStageMask     = dst_stage,
-            .dstAccessMask    = dst_access,
-            .oldLayout        = old_layout,
-            .newLayout        = new_layout,
-            .image            = target.image,
-            .subresourceRange = {target.aspect, 0, 1, 0, 1},
-        };
-        const VkDependencyInfo depInfo{
-            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-            .imageMemoryBarrierCount = 1,
-            .pImageMemoryBarriers    = &barrier,
-        };
-        vkCmdPipelineBarrier2(cmd, &depInfo);
-    }
-    static void transition_to_color_attachment(VkCommandBuffer cmd, VkImage image, VkImageLayout old_layout) {
-        VkImageMemoryBarrier2 barrier{
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-            .pNext            = nullptr,
-            .srcStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-            .srcAccessMask    = VK_ACCESS_2_MEMORY_WRITE_BIT,
-            .dstStageMask     = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .dstAccessMask    = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
-            .oldLayout        = old_layout,
-            .newLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .image            = image,
-            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u},
-        };
-        VkDependencyInfo dep{
-            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-            .imageMemoryBarrierCount = 1u,
-            .pImageMemoryBarriers    = &barrier,
-        };
-        vkCmdPipelineBarrier2(cmd, &dep);
-    }
-    static void transition_to_present(VkCommandBuffer cmd, VkImage image) {
-        VkImageMemoryBarrier2 barrier{
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-            .srcStageMask     = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .srcAccessMask    = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-            .dstStageMask     = VK_PIPELINE_STAGE_2_NONE,
-            .dstAccessMask    = 0u,
-            .oldLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .newLayout        = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            .image            = image,
-            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u},
+    // Layouts shared with viewport_stream.vert, which reads both blocks through buffer device addresses.
+    struct StreamVertex {
+        float position[4];
+        float color[4];
+    };
+    struct TrianglePush {
+        VkDeviceAddress camera;
+        VkDeviceAddress vertices;
+    };
+    static constexpr std::array<StreamVertex, 3> kTriangle{{
+        {{0.0f, -0.6f, 0.0f, 1.0f}, {1.0f, 0.1f, 0.1f, 1.0f}},
+        {{0.6f, 0.6f, 0.0f, 1.0f}, {0.1f, 1.0f, 0.1f, 1.0f}},
+        {{-0.6f, 0.6f, 0.0f, 1.0f}, {0.1f, 0.1f, 1.0f, 1.0f}},
+    }};
+    // viewport_variant.frag reads its tint right after the vertex stage's block.
+    static constexpr std::uint32_t kTintOffset         = sizeof(TrianglePush);
+    static constexpr VkDeviceSize kUploadBytesPerFrame = 64 * 1024;
+
+    // Everything ImGui_ImplVulkan_RenderDrawData consumes: geometry, per-command state and the display transform.
+    static std::uint64_t hash_draw_data(const ImDrawData& draw_data) {
+        const float transform[6]{draw_data.DisplayPos.x, draw_data.DisplayPos.y, draw_data.DisplaySize.x, draw_data.DisplaySize.y, draw_data.FramebufferScale.x, draw_data.FramebufferScale.y};
+        std::uint64_t hash = hash_bytes(std::as_bytes(std::span(transform)));
+        for (const ImDrawList* list : draw_data.CmdLists) {
+            hash = hash_bytes(std::as_bytes(std::span(list->VtxBuffer.Data, static_cast<std::size_t>(list->VtxBuffer.Size))), hash);
+            hash = hash_bytes(std::as_bytes(std::span(list->IdxBuffer.Data, static_cast<std::size_t>(list->IdxBuffer.Size))), hash);
+            for (const ImDrawCmd& draw : list->CmdBuffer) {
+                const ImTextureID texture = draw.GetTexID();
+                const std::uint32_t ranges[4]{draw.VtxOffset, draw.IdxOffset, draw.ElemCount, draw.UserCallback != nullptr ? 1u : 0u};
+                hash = hash_bytes(std::as_bytes(std::span(&draw.ClipRect, 1)), hash);
+                hash = hash_bytes(std::as_bytes(std::span(&texture, 1)), hash);
+                hash = hash_bytes(std::as_bytes(std::span(ranges)), hash);
+            }
+        }
+        return hash;
+    }
+
+    static void draw_profiler_panel(const Profiler& profiler) {
+        if (!ImGui::Begin("Profiler")) {
+            ImGui::End();
+            return;
+        }
+        const auto& history = profiler.history();
+        if (history.empty()) {
+            ImGui::TextUnformatted(profiler.gpu_available() ? "Waiting for the first frame's queries..." : "Waiting for the first frame...");
+            ImGui::End();
+            return;
+        }
+
+        // Rolling totals: the end of the last top-level scope on each track.
+        const auto frame_total = [](const std::vector<ProfileScope>& scopes) {
+            float total = 0.0f;
+            for (const auto& scope : scopes)
+                if (scope.depth == 0) total = std::max(total, static_cast<float>(scope.end_ms));
+            return total;
         };
-        VkDependencyInfo dep{
-            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-            .imageMemoryBarrierCount = 1u,
-            .pImageMemoryBarriers    = &barrier,
+        std::vector<float> cpu_totals;
+        std::vector<float> gpu_totals;
+        for (const auto& frame : history) {
+            cpu_totals.push_back(frame_total(frame.cpu));
+            if (frame.gpu_valid) gpu_totals.push_back(frame_total(frame.gpu));
+        }
+        ImGui::PlotLines("CPU ms", cpu_totals.data(), static_cast<int>(cpu_totals.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+        if (!gpu_totals.empty()) ImGui::PlotLines("GPU ms", gpu_totals.data(), static_cast<int>(gpu_totals.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+
+        // Timeline of the newest complete frame, one row per nesting level.
+        const ProfileFrame& latest = history.back();
+        double span                = 0.001;
+        for (const auto& scope : latest.cpu) span = std::max(span, scope.end_ms);
+        if (latest.gpu_valid)
+            for (const auto& scope : latest.gpu) span = std::max(span, scope.end_ms);
+        ImGui::Text("Frame %llu, %.3f ms shown", static_cast<unsigned long long>(latest.frame), span);
+
+        ImDrawList* draw_list = ImGui::GetWindowDrawList();
+        const float row       = ImGui::GetTextLineHeightWithSpacing();
+        const float label     = ImGui::CalcTextSize("GPU ").x;
+        const float width     = std::max(ImGui::GetContentRegionAvail().x - label, 1.0f);
+        const auto draw_track = [&](const char* name, const std::vector<ProfileScope>& scopes, ImU32 color) {
+            const ImVec2 origin = ImGui::GetCursorScreenPos();
+            std::uint32_t depth = 0;
+            for (const auto& scope : scopes) depth = std::max(depth, scope.depth + 1);
+            draw_list->AddText(origin, ImGui::GetColorU32(ImGuiCol_Text), name);
+            for (const auto& scope : scopes) {
+                const ImVec2 min{origin.x + label + static_cast<float>(scope.begin_ms / span) * width, origin.y + scope.depth * row};
+                const ImVec2 max{std::max(origin.x + label + static_cast<float>(scope.end_ms / span) * width, min.x + 1.0f), min.y + row - 1.0f};
+                draw_list->AddRectFilled(min, max, color);
+                draw_list->PushClipRect(min, max, true);
+                draw_list->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, scope.name.c_str());
+                draw_list->PopClipRect();
+                if (ImGui::IsMouseHoveringRect(min, max)) ImGui::SetTooltip("%s: %.3f ms", scope.name.c_str(), scope.end_ms - scope.begin_ms);
+            }
+            ImGui::Dummy(ImVec2(label + width, std::max(depth, 1u) * row));
         };
-        vkCmdPipelineBarrier2(cmd, &dep);
+        draw_track("CPU", latest.cpu, IM_COL32(70, 130, 180, 255));
+        if (latest.gpu_valid) draw_track("GPU", latest.gpu, IM_COL32(200, 110, 50, 255));
+
+        if (latest.pipeline) {
+            const auto& stats = *latest.pipeline;
+            ImGui::Text("Vertices %llu, primitives %llu, VS %llu, clipped %llu, FS %llu", static_cast<unsigned long long>(stats.input_vertices), static_cast<unsigned long long>(stats.input_primitives), static_cast<unsigned long long>(stats.vertex_invocations), static_cast<unsigned long long>(stats.clipping_primitives), static_cast<unsigned long long>(stats.fragment_invocations));
+        }
+        if (ImGui::Button("Export Chrome trace")) profiler.export_chrome_trace("viewport_trace.json");
+        ImGui::End();
     }
 } // namespace vk::plugins
 
 void vk::plugins::ViewportRenderer::query_required_device_caps(context::RendererCaps& caps) {
-    caps.allow_async_compute = false;
+    caps.allow_async_compute = m_async_compute;
 }
 void vk::plugins::ViewportRenderer::get_capabilities(context::RendererCaps& caps) {
     caps                            = context::RendererCaps{};
@@ -105,158 +139,472 @@ void vk::plugins::ViewportRenderer::get_capabilities(context::RendererCaps& caps
     caps.preferred_swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
     caps.color_attachments          = {context::AttachmentRequest{.name = "color", .format = VK_FORMAT_B8G8R8A8_UNORM, .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, .samples = VK_SAMPLE_COUNT_1_BIT, .aspect = VK_IMAGE_ASPECT_COLOR_BIT, .initial_layout = VK_IMAGE_LAYOUT_GENERAL}};
     caps.presentation_attachment    = "color";
+
+    // Extra attachments for views not drawn into the presented image, requested in index order.
+    std::uint32_t attachments = 1;
+    for (const auto& view : m_views) attachments = std::max(attachments, view.attachment + 1);
+    for (std::uint32_t i = 1; i < attachments; ++i) {
+        auto request = caps.color_attachments.front();
+        request.name = "view" + std::to_string(i);
+        caps.color_attachments.push_back(std::move(request));
+    }
 }
 void vk::plugins::ViewportRenderer::initialize(const context::EngineContext& eng, const context::RendererCaps& caps) {
-    this->fmt                      = caps.color_attachments.empty() ? VK_FORMAT_B8G8R8A8_UNORM : caps.color_attachments.front().format;
-    this->m_color_blend_attachment = {
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    };
-    this->m_dynamic_states[0] = VK_DYNAMIC_STATE_VIEWPORT;
-    this->m_dynamic_states[1] = VK_DYNAMIC_STATE_SCISSOR;
+    this->fmt = caps.color_attachments.empty() ? VK_FORMAT_B8G8R8A8_UNORM : caps.color_attachments.front().format;
+    this->m_profiler.initialize(eng, m_device_features);
+    this->m_uploads.initialize(eng, m_device_features, kUploadBytesPerFrame, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
+    // Without buffer device addresses the triangle falls back to the shader with its geometry baked in.
+    auto& shaders = ShaderLibrary::shared();
+    shaders.set_module_identifiers(eng, m_device_features.shader_module_identifier && m_device_features.pipeline_creation_cache_control);
+    this->m_vert_path        = m_uploads.device_addresses() ? "shader/viewport_stream.vert.spv" : "shader/viewport.vert.spv";
+    this->m_frag_path        = "shader/viewport_variant.frag.spv";
+    this->m_vert_shader      = shaders.acquire(eng, m_vert_path);
+    this->m_frag_shader      = shaders.acquire(eng, m_frag_path);
+    this->m_shader_refs_held = true;
+    const std::array<std::uint64_t, 2> shader_keys{m_vert_shader, m_frag_shader};
+    this->m_pipeline_cache.load(eng, this->m_pipeline_cache_path, hash_bytes(std::as_bytes(std::span(shader_keys))));
+
+    this->m_pipeline_builds.initialize(eng, this->m_pipeline_cache);
+
+    // The pipeline compiles on a worker; record_graphics only clears until it is ready.
     this->create_pipeline_layout(eng);
     this->create_graphics_pipeline(eng);
+    // Sized for the scene passes' long-lived sets: per frame slot, the batch's 2 and culling's 3 storage buffers plus
+    // culling's Hi-Z sampler, and the point cloud's one storage buffer. The chains grow if more sets show up.
+    const DescriptorPoolConfig pass_sets{.ratios = {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.5f}, {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0.5f}}, .initial_sets = 2 * context::FRAME_OVERLAP + 1, .max_sets_per_pool = 64};
+    this->m_descriptors.initialize(eng, pass_sets, pass_sets);
+    if (this->m_compute_queue != VK_NULL_HANDLE && this->m_compute_family != eng.graphics_queue_family) {
+        this->m_batches.set_queue_families({eng.graphics_queue_family, this->m_compute_family});
+        this->m_culling.set_compute_queue(this->m_compute_queue, this->m_compute_family);
+    }
+    this->m_batches.initialize(eng, this->fmt, this->m_pipeline_builds, this->m_device_features, this->m_descriptors);
+    this->m_culling.initialize(eng, this->m_pipeline_cache.handle(), this->m_descriptors);
+    this->m_point_cloud.initialize(eng, this->fmt, this->m_pipeline_builds, this->m_descriptors);
+    if (this->m_capture_config) this->m_capture.initialize(*this->m_capture_config);
+
+    if (this->m_hot_reload_config) {
+        const auto config = *this->m_hot_reload_config;
+        for (const auto& spv : {m_vert_path, m_frag_path}) {
+            m_shader_watcher.watch(spv);
+            if (config.source_dir.empty()) continue;
+            // viewport.vert.spv is built from viewport.vert; the compiled output is picked up by the .spv watch.
+            m_shader_watcher.watch(config.source_dir / spv.stem(), [config, spv](const std::filesystem::path& source) {
+                if (const int status = compile_glsl(config.compiler, source, spv); status != 0) std::println("[hot-reload] {} failed to compile (exit {})", source.string(), status);
+            });
+        }
+        m_shader_watcher.start(config.poll_interval);
+    }
 }
 void vk::plugins::ViewportRenderer::destroy(const context::EngineContext& eng) {
-    vkDestroyPipeline(eng.device, pipe, nullptr);
-    pipe = VK_NULL_HANDLE;
+    m_shader_watcher.stop();
+    m_shader_watcher.clear();
+    m_pipeline_builds.wait_idle();
+    m_view_workers.reset();
+    for (auto& recorders : m_view_recorders) {
+        for (const auto& recorder : recorders) vkDestroyCommandPool(eng.device, recorder.pool, nullptr);
+        recorders.clear();
+    }
+    m_capture.destroy(eng);
+    if (m_variants.rebuilding()) {
+        ShaderLibrary::shared().release(eng, m_reload_vert);
+        ShaderLibrary::shared().release(eng, m_reload_frag);
+    }
+    m_variants.destroy(eng);
+    m_pipeline_ready = false;
+    m_point_cloud.destroy(eng);
+    m_culling.destroy(eng);
+    m_batches.destroy(eng);
+    m_descriptors.destroy(eng);
+    m_pipeline_builds.destroy(eng);
+    if (m_shader_refs_held) {
+        ShaderLibrary::shared().release(eng, m_vert_shader);
+        ShaderLibrary::shared().release(eng, m_frag_shader);
+        m_shader_refs_held = false;
+    }
+    m_pipeline_cache.save(eng);
+    m_pipeline_cache.destroy(eng);
     vkDestroyPipelineLayout(eng.device, layout, nullptr);
     layout = VK_NULL_HANDLE;
+    m_uploads.destroy(eng);
+    m_profiler.destroy(eng);
 }
 void vk::plugins::ViewportRenderer::record_graphics(VkCommandBuffer& cmd, const context::EngineContext& eng, const context::FrameContext& frm) {
-    const auto& target = frm.color_attachments.front();
+    const auto record_start        = std::chrono::steady_clock::now();
+    const auto& target             = frm.color_attachments.front();
+    const std::uint32_t frame_slot = static_cast<std::uint32_t>(m_frame_number++ % context::FRAME_OVERLAP);
+    m_profiler.begin_frame(cmd, eng, frame_slot);
+    m_descriptors.begin_frame(frame_slot);
+    m_capture.prepare(eng, fmt, frm.extent, frame_slot);
+    const CpuZone cpu_zone(m_profiler, "record_graphics");
+    const auto rebuild = m_variants.begin_frame(frame_slot);
+    poll_pipeline_builds(eng);
+    poll_shader_reload(eng, rebuild);
+    // Requested before anything records, so the view workers only ever look pipelines up.
+    m_variants.request(m_variant);
+    for (const auto& view : m_views) m_variants.request(view.variant);
+    if (!m_scene.empty()) prepare_scene();
+    m_batches.prepare(eng, frame_slot);
+    m_uploads.begin_frame(eng, frame_slot);
+    m_triangle_vertices = m_uploads.push(std::span(kTriangle), 16).address;
+
+    const ResourceId color = m_render_graph.import_image(target.image, target.aspect, states::kEngineGeneral, states::kEngineGeneral);
+    // An async dispatch is not in `cmd`, so a scope here would only time an empty stretch of the graphics queue.
+    const auto cull_scope = m_culling.enabled() && !m_culling.submits_async() ? m_profiler.begin_gpu_scope(cmd, "culling") : Profiler::kInvalidScope;
+    m_culling.record(cmd, eng, m_batches, frame_slot, m_render_graph);
+    m_profiler.end_gpu_scope(cmd, cull_scope);
+    m_point_cloud.update(cmd, eng, m_render_graph, m_batches.view_projection());
 
-    transition_image_layout(cmd, target, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    begin_rendering(cmd, target, frm.extent);
-    draw_triangle(cmd, frm.extent);
-    end_rendering(cmd);
-    transition_image_layout(cmd, target, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+    // Nothing may be recorded between the suspend and the UI's resume, so the graph is not touched again until then and
+    // the scene's queries are written inside the rendering instance.
+    const bool merge = m_ui_attached && frm.presentation_mode != context::PresentationMode::DirectToSwapchain && pass_merging(frm.presentation_mode);
+    if (m_views.empty()) {
+        m_render_graph.use(color, states::kColorAttachment);
+        m_render_graph.flush(cmd);
+        begin_rendering(cmd, target, frm.extent, merge ? VK_RENDERING_SUSPENDING_BIT : 0);
+        const auto scene_scope = m_profiler.begin_gpu_scope(cmd, "scene");
+        m_profiler.begin_pipeline_statistics(cmd);
+        draw_triangle(cmd, {{0, 0}, frm.extent}, m_uploads.push(m_batches.view_projection(), 16).address, m_variant, m_tint);
+        m_batches.record(cmd, frm.extent, frame_slot);
+        m_point_cloud.record(cmd, {{0, 0}, frm.extent}, m_batches.view_projection());
+        m_profiler.end_pipeline_statistics(cmd);
+        m_profiler.end_gpu_scope(cmd, scene_scope);
+        end_rendering(cmd);
+    } else {
+        m_render_graph.use(color, states::kColorAttachment);
+        record_views(cmd, eng, frm, frame_slot, merge);
+    }
+    m_scene_suspended = merge;
+    m_frame_target    = target;
+    m_frame_extent    = frm.extent;
+    if (!m_ui_attached) finish_frame(cmd);
+
+    update_frame_timing(merge, m_views.empty() ? 1u : static_cast<std::uint32_t>(m_views.size()), std::chrono::steady_clock::now() - record_start);
+}
+void vk::plugins::ViewportRenderer::prepare_scene() {
+    // View recording comes later in the frame, so both share one pool.
+    if (!m_view_workers) m_view_workers = std::make_unique<ThreadPool>(m_view_worker_count);
+    m_scene.prepare(kIdentityAffine, m_batches.view_projection(), best_simd_level(), m_view_workers.get());
+    m_scene.sorted_visible(m_scene_order);
+
+    m_scene_upload.resize(m_scene_order.size());
+    for (std::size_t i = 0; i < m_scene_order.size(); ++i) {
+        const std::uint32_t index = m_scene_order[i];
+        const auto center         = m_scene.world_center(index);
+        const auto extent         = m_scene.world_extent(index);
+        const std::uint32_t color = m_scene.color(index);
+        m_scene_upload[i]         = {
+            .position = {center[0], center[1], center[2]},
+            .scale    = std::max({extent[0], extent[1], extent[2]}),
+            .color    = {static_cast<float>(color & 0xff) / 255.0f, static_cast<float>(color >> 8 & 0xff) / 255.0f, static_cast<float>(color >> 16 & 0xff) / 255.0f, static_cast<float>(color >> 24) / 255.0f},
+        };
+    }
+    m_batches.set_instances(m_scene_upload);
+}
+void vk::plugins::ViewportRenderer::set_views(std::vector<RenderView> views) {
+    m_views = std::move(views);
+    // Culling runs once per frame, for the primary camera only.
+    if (!m_views.empty()) m_batches.set_view_projection(m_views.front().view_proj);
+}
+void vk::plugins::ViewportRenderer::record_views(VkCommandBuffer cmd, const context::EngineContext& eng, const context::FrameContext& frm, std::uint32_t frame_slot, bool merge) {
+    if (!m_view_workers) m_view_workers = std::make_unique<ThreadPool>(m_view_worker_count);
+    const std::uint32_t workers = m_view_workers->worker_count();
+    auto& recorders             = m_view_recorders[frame_slot];
+    if (recorders.size() != workers) {
+        recorders.resize(workers);
+        for (auto& recorder : recorders) {
+            if (recorder.pool != VK_NULL_HANDLE) continue;
+            const VkCommandPoolCreateInfo pool_ci{
+                .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                .queueFamilyIndex = eng.graphics_queue_family,
+            };
+            VK_CHECK(vkCreateCommandPool(eng.device, &pool_ci, nullptr, &recorder.pool));
+        }
+    }
+    // The slot's previous frame has retired, so every secondary recorded for it can be recycled with one reset per pool.
+    for (auto& recorder : recorders) {
+        VK_CHECK(vkResetCommandPool(eng.device, recorder.pool, 0));
+        recorder.used = 0;
+    }
+
+    // Views on attachments this frame does not have (e.g. a headless run with only the presented image) are skipped.
+    const auto attachment_count = static_cast<std::uint32_t>(frm.color_attachments.size());
+    const auto view_count       = static_cast<std::uint32_t>(m_views.size());
+    m_view_cmds.assign(view_count, VK_NULL_HANDLE);
+    m_view_cameras.resize(view_count);
+    for (std::uint32_t i = 0; i < view_count; ++i) m_view_cameras[i] = m_uploads.push(m_views[i].view_proj, 16).address;
+    m_batches.poll_pipeline();
+
+    // Contiguous chunks, one per worker: each worker records into buffers from its own pool, so nothing is locked.
+    const auto views_start    = std::chrono::steady_clock::now();
+    const std::uint32_t chunk = (view_count + workers - 1) / workers;
+    std::vector<std::exception_ptr> errors(workers);
+    for (std::uint32_t first = 0, task = 0; first < view_count; first += chunk, ++task) {
+        m_view_workers->submit([&, first, task](std::uint32_t worker) {
+            try {
+                auto& recorder = recorders[worker];
+                for (std::uint32_t i = first; i < std::min(first + chunk, view_count); ++i) {
+                    const RenderView& view = m_views[i];
+                    if (view.attachment >= attachment_count) continue;
+                    if (recorder.used == recorder.buffers.size()) {
+                        const VkCommandBufferAllocateInfo cmd_ai{
+                            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                            .commandPool        = recorder.pool,
+                            .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                            .commandBufferCount = 1,
+                        };
+                        VK_CHECK(vkAllocateCommandBuffers(eng.device, &cmd_ai, &recorder.buffers.emplace_back()));
+                    }
+                    VkCommandBuffer secondary = recorder.buffers[recorder.used++];
+
+                    // Must repeat the executing instance's flags, less the contents bit.
+                    const VkCommandBufferInheritanceRenderingInfo inheritance_rendering{
+                        .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+                        .flags                   = view.attachment == 0 && merge ? VK_RENDERING_SUSPENDING_BIT : 0u,
+                        .colorAttachmentCount    = 1,
+                        .pColorAttachmentFormats = &fmt,
+                        .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT,
+                    };
+                    const VkCommandBufferInheritanceInfo inheritance{
+                        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                        .pNext = &inheritance_rendering,
+                    };
+                    const VkCommandBufferBeginInfo bi{
+                        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                        .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                        .pInheritanceInfo = &inheritance,
+                    };
+                    VK_CHECK(vkBeginCommandBuffer(secondary, &bi));
+                    const VkRect2D area = view.area.extent.width == 0 || view.area.extent.height == 0 ? VkRect2D{{0, 0}, frm.extent} : view.area;
+                    draw_triangle(secondary, area, m_view_cameras[i], view.variant, view.tint);
+                    m_batches.record_view(secondary, area, view.view_proj, frame_slot, i == 0);
+                    m_point_cloud.record(secondary, area, view.view_proj);
+                    VK_CHECK(vkEndCommandBuffer(secondary));
+                    m_view_cmds[i] = secondary;
+                }
+            } catch (...) {
+                errors[task] = std::current_exception();
+            }
+        });
+    }
+
+    // Meanwhile the graph moves every attachment the views draw into to the attachment state in one barrier batch.
+    std::vector<bool> drawn(attachment_count, false);
+    drawn[0] = true;
+    for (const auto& view : m_views) {
+        if (view.attachment >= attachment_count || drawn[view.attachment]) continue;
+        const auto& image      = frm.color_attachments[view.attachment];
+        const ResourceId id    = m_render_graph.import_image(image.image, image.aspect, states::kEngineGeneral, states::kEngineGeneral);
+        drawn[view.attachment] = true;
+        m_render_graph.use(id, states::kColorAttachment);
+    }
+    m_render_graph.flush(cmd);
+    m_view_workers->wait_idle();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    // Batch stats and the benchmark count every view's draw; the time is the wall time of the parallel recording.
+    const auto recorded_views = static_cast<std::uint32_t>(std::ranges::count_if(m_views, [&](const RenderView& view) { return view.attachment < attachment_count; }));
+    m_batches.finish_views(recorded_views, std::chrono::steady_clock::now() - views_start);
+
+    // Off-screen attachments first, so the presented one's instance is last and can stay suspended for the UI. Its
+    // contents are all secondaries, so the scene's GPU scope brackets the instances only when it is not suspended.
+    std::vector<VkCommandBuffer> executed;
+    const auto scene_scope = merge ? Profiler::kInvalidScope : m_profiler.begin_gpu_scope(cmd, "scene");
+    for (std::uint32_t a = attachment_count; a-- > 0;) {
+        if (!drawn[a]) continue;
+        executed.clear();
+        for (std::uint32_t i = 0; i < view_count; ++i) {
+            if (m_views[i].attachment == a && m_view_cmds[i] != VK_NULL_HANDLE) executed.push_back(m_view_cmds[i]);
+        }
+        const VkRenderingFlags flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT | (a == 0 && merge ? VK_RENDERING_SUSPENDING_BIT : 0);
+        begin_rendering(cmd, frm.color_attachments[a], frm.extent, flags);
+        if (!executed.empty()) vkCmdExecuteCommands(cmd, static_cast<std::uint32_t>(executed.size()), executed.data());
+        end_rendering(cmd);
+    }
+    m_profiler.end_gpu_scope(cmd, scene_scope);
+}
+void vk::plugins::ViewportRenderer::set_pass_merging(context::PresentationMode mode, bool enabled) {
+    if (pass_merging(mode) == enabled) return;
+    if (enabled) m_merged_modes.push_back(mode);
+    else std::erase(m_merged_modes, mode);
+}
+bool vk::plugins::ViewportRenderer::pass_merging(context::PresentationMode mode) const {
+    return std::ranges::find(m_merged_modes, mode) != m_merged_modes.end();
+}
+void vk::plugins::ViewportRenderer::wait_for_pipeline_builds() {
+    m_pipeline_builds.wait_idle();
+}
+void vk::plugins::ViewportRenderer::finish_frame(VkCommandBuffer cmd) {
+    // A suspended instance must be resumed within the same submission; close it here if the UI skipped its pass.
+    if (resume_scene_pass(cmd)) end_rendering(cmd);
+    // end_frame() leaves the attachment in GENERAL with every write made available, which is what the copy expects.
+    m_render_graph.end_frame(cmd);
+    m_capture.record(cmd, m_frame_target.image);
+}
+bool vk::plugins::ViewportRenderer::resume_scene_pass(VkCommandBuffer cmd, VkRenderingFlags flags) {
+    if (!std::exchange(m_scene_suspended, false)) return false;
+    // A resuming instance must repeat the suspended one's VkRenderingInfo; the clear is not applied again.
+    begin_rendering(cmd, m_frame_target, m_frame_extent, VK_RENDERING_RESUMING_BIT | flags);
+    return true;
+}
+void vk::plugins::ViewportRenderer::update_frame_timing(bool merged, std::uint32_t views, std::chrono::nanoseconds record_time) {
+    constexpr std::uint32_t report_interval = 600;
+    const auto now                          = std::chrono::steady_clock::now();
+    const auto last                         = std::exchange(m_last_frame_start, now);
+    if (merged != m_frame_timing.merged_passes || views != m_frame_timing.views) {
+        m_frame_timing = {.merged_passes = merged, .views = views};
+        return;
+    }
+    if (last == std::chrono::steady_clock::time_point{}) return;
+
+    ++m_frame_timing.frames;
+    m_frame_timing.frame_time += now - last;
+    m_frame_timing.record_time += record_time;
+    if (m_frame_timing.frames < report_interval) return;
+
+    const auto to_ms = [&](std::chrono::nanoseconds total) { return std::chrono::duration<double, std::milli>(total).count() / m_frame_timing.frames; };
+    std::println("[frame] passes={} views={} frames={} avg frame {:.3f} ms, avg scene record {:.3f} ms", merged ? "merged" : "split", views, m_frame_timing.frames, to_ms(m_frame_timing.frame_time), to_ms(m_frame_timing.record_time));
+    m_frame_timing = {.merged_passes = merged, .views = views};
 }
 void vk::plugins::ViewportRenderer::create_pipeline_layout(const context::EngineContext& eng) {
-    constexpr VkPipelineLayoutCreateInfo lci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    // Two buffer addresses into this frame's upload region (the camera block and the streamed vertices), then the
+    // fragment stage's tint.
+    constexpr std::array<VkPushConstantRange, 2> push{{
+        {.stageFlags = VK_SHADER_STAGE_VERTEX_BIT, .offset = 0, .size = sizeof(TrianglePush)},
+        {.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .offset = kTintOffset, .size = sizeof(float) * 4},
+    }};
+    const VkPipelineLayoutCreateInfo lci{
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = static_cast<std::uint32_t>(push.size()),
+        .pPushConstantRanges    = push.data(),
+    };
     VK_CHECK(vkCreatePipelineLayout(eng.device, &lci, nullptr, &layout));
 }
 void vk::plugins::ViewportRenderer::create_graphics_pipeline(const context::EngineContext& eng) {
-
-    VkShaderModule vs;
-    {
-        std::ifstream f("shader/viewport.vert.spv", std::ios::binary | std::ios::ate);
-        const size_t s = static_cast<size_t>(f.tellg());
-        f.seekg(0);
-        std::vector<char> d(s);
-        f.read(d.data(), s);
-
-        VkShaderModuleCreateInfo ci{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-        ci.codeSize = d.size();
-        ci.pCode    = reinterpret_cast<const uint32_t*>(d.data());
-        VK_CHECK(vkCreateShaderModule(eng.device, &ci, nullptr, &vs));
-    }
-
-    VkShaderModule fs;
-    {
-        std::ifstream f("shader/viewport.frag.spv", std::ios::binary | std::ios::ate);
-        const size_t s = static_cast<size_t>(f.tellg());
-        f.seekg(0);
-        std::vector<char> d(s);
-        f.read(d.data(), s);
-
-        VkShaderModuleCreateInfo ci{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-        ci.codeSize = d.size();
-        ci.pCode    = reinterpret_cast<const uint32_t*>(d.data());
-        VK_CHECK(vkCreateShaderModule(eng.device, &ci, nullptr, &fs));
-    }
-
-    const VkPipelineShaderStageCreateInfo stages[2] = {
-        {
-            .stage  = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = vs,
-            .pName  = "main",
-        },
-        {
-            .stage  = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = fs,
-            .pName  = "main",
-        },
+    this->m_graphics_pipeline = {
+        .vert_shader  = m_vert_shader,
+        .frag_shader  = m_frag_shader,
+        .layout       = layout,
+        .color_format = fmt,
+        .topology     = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .polygon_mode = VK_POLYGON_MODE_FILL,
+        .cull_mode    = VK_CULL_MODE_NONE,
+        .front_face   = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .samples      = VK_SAMPLE_COUNT_1_BIT,
+        .name         = "viewport",
     };
+    // Variants override the fields in their key; the default one starts compiling right away.
+    this->m_variants.initialize(eng, m_pipeline_builds, m_device_features, m_graphics_pipeline);
+    this->m_variants.request(m_variant);
+}
+void vk::plugins::ViewportRenderer::poll_pipeline_builds(const context::EngineContext& eng) {
+    // begin_frame only adopts finished builds, so polling now still folds their telemetry in before it is reported.
+    m_pipeline_builds.poll(eng);
+    if (m_pipeline_ready) return;
+    if (!m_variants.ready(m_variant)) {
+        // Nothing would ever draw. With hot reload on, a fixed shader can still replace it; see poll_shader_reload.
+        if (!m_hot_reload_config && m_variants.failed(m_variant)) throw std::runtime_error(m_graphics_pipeline.name + " pipeline failed to build");
+        return;
+    }
+    this->m_pipeline_ready = true;
 
-    this->m_graphics_pipeline.rendering_info = {
-        .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
-        .colorAttachmentCount    = 1,
-        .pColorAttachmentFormats = &this->fmt,
-    };
-    this->m_graphics_pipeline.vertex_input_state = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-    };
-    this->m_graphics_pipeline.input_assembly_state = {
-        .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-    };
-    this->m_graphics_pipeline.viewport_state = {
-        .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .scissorCount  = 1,
-    };
-    this->m_graphics_pipeline.rasterization_state = {
-        .sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode    = VK_CULL_MODE_NONE,
-        .frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        .lineWidth   = 1.0f,
-    };
-    this->m_graphics_pipeline.multisample_state = {
-        .sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-    };
-    this->m_graphics_pipeline.color_blend_state = {
-        .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .attachmentCount = 1,
-        .pAttachments    = &m_color_blend_attachment,
-    };
-    this->m_graphics_pipeline.dynamic_state = {
-        .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = 2,
-        .pDynamicStates    = m_dynamic_states,
-    };
+    this->m_pipeline_cache.report();
+    // With module identifiers the driver can rebuild from its own cache, so the modules need not stay resident.
+    auto& shaders = ShaderLibrary::shared();
+    if (m_shader_refs_held && shaders.has_identifier(eng, m_vert_shader) && shaders.has_identifier(eng, m_frag_shader)) {
+        shaders.release(eng, m_vert_shader);
+        shaders.release(eng, m_frag_shader);
+        this->m_shader_refs_held = false;
+    }
+}
+void vk::plugins::ViewportRenderer::poll_shader_reload(const context::EngineContext& eng, PipelineVariantCache::RebuildResult rebuild) {
+    if (!m_hot_reload_config) return;
 
-    VkGraphicsPipelineCreateInfo pci{
-        .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext               = &this->m_graphics_pipeline.rendering_info,
-        .stageCount          = 2,
-        .pStages             = stages,
-        .pVertexInputState   = &this->m_graphics_pipeline.vertex_input_state,
-        .pInputAssemblyState = &this->m_graphics_pipeline.input_assembly_state,
-        .pViewportState      = &this->m_graphics_pipeline.viewport_state,
-        .pRasterizationState = &this->m_graphics_pipeline.rasterization_state,
-        .pMultisampleState   = &this->m_graphics_pipeline.multisample_state,
-        .pColorBlendState    = &this->m_graphics_pipeline.color_blend_state,
-        .pDynamicState       = &this->m_graphics_pipeline.dynamic_state,
-        .layout              = layout,
-    };
-    VK_CHECK(vkCreateGraphicsPipelines(eng.device, VK_NULL_HANDLE, 1, &pci, nullptr, &pipe));
+    for (const auto& path : m_shader_watcher.take_changes()) m_reload_requested |= path == m_vert_path || path == m_frag_path;
+    if (rebuild != PipelineVariantCache::RebuildResult::None) finish_shader_reload(eng, rebuild == PipelineVariantCache::RebuildResult::Swapped);
+    // One reload at a time, and not while the initial build is compiling: edits made meanwhile are picked up when it
+    // finishes. If it failed, the reload is what replaces it.
+    if (m_reload_requested && !m_variants.rebuilding() && (m_pipeline_ready || m_variants.failed(m_variant))) start_shader_reload(eng);
+}
+void vk::plugins::ViewportRenderer::start_shader_reload(const context::EngineContext& eng) {
+    m_reload_requested = false;
+    auto& shaders      = ShaderLibrary::shared();
+    std::uint64_t vert = 0;
+    try {
+        vert                     = shaders.acquire(eng, m_vert_path);
+        const std::uint64_t frag = shaders.acquire(eng, m_frag_path);
+        if (vert == m_vert_shader && frag == m_frag_shader) {
+            // Touched but unchanged.
+            shaders.release(eng, vert);
+            shaders.release(eng, frag);
+            return;
+        }
+        m_reload_vert = vert;
+        m_reload_frag = frag;
+    } catch (const std::exception& e) {
+        if (vert != 0) shaders.release(eng, vert);
+        ++m_hot_reload_stats.failures;
+        std::println("[hot-reload] {}; keeping the current pipeline", e.what());
+        return;
+    }
 
-    vkDestroyShaderModule(eng.device, vs, nullptr);
-    vkDestroyShaderModule(eng.device, fs, nullptr);
+    GraphicsPipelineDesc desc = m_graphics_pipeline;
+    desc.vert_shader          = m_reload_vert;
+    desc.frag_shader          = m_reload_frag;
+    m_reload_started          = std::chrono::steady_clock::now();
+    m_variants.rebuild(std::move(desc));
+}
+void vk::plugins::ViewportRenderer::finish_shader_reload(const context::EngineContext& eng, bool swapped) {
+    auto& shaders = ShaderLibrary::shared();
+    if (!swapped) {
+        shaders.release(eng, m_reload_vert);
+        shaders.release(eng, m_reload_frag);
+        ++m_hot_reload_stats.failures;
+        std::println("[hot-reload] {} rebuild failed; keeping the current pipelines", m_graphics_pipeline.name);
+        return;
+    }
+
+    // The cache retired the old pipelines to this frame's slot.
+    if (m_shader_refs_held) {
+        shaders.release(eng, m_vert_shader);
+        shaders.release(eng, m_frag_shader);
+    }
+    // The modules stay resident while hot reload is on, so the next rebuild never has to fall back on identifiers.
+    m_vert_shader                   = m_reload_vert;
+    m_frag_shader                   = m_reload_frag;
+    m_shader_refs_held              = true;
+    m_graphics_pipeline.vert_shader = m_vert_shader;
+    m_graphics_pipeline.frag_shader = m_frag_shader;
+    ++m_hot_reload_stats.reloads;
+    m_hot_reload_stats.last_build_time = std::chrono::steady_clock::now() - m_reload_started;
+    std::println("[hot-reload] {} {} pipelines swapped in, rebuilt in {:.1f} ms", m_graphics_pipeline.name, m_variants.stats().pipelines, std::chrono::duration<double, std::milli>(m_hot_reload_stats.last_build_time).count());
 }
-void vk::plugins::ViewportRenderer::draw_triangle(VkCommandBuffer cmd, VkExtent2D extent) const {
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipe);
+void vk::plugins::ViewportRenderer::draw_triangle(VkCommandBuffer cmd, VkRect2D area, VkDeviceAddress camera, const PipelineVariantKey& variant, const std::array<float, 4>& tint) const {
+    // The batch and point-cloud passes bind their own pipelines after this, so every call starts from a fresh binding.
+    VariantBinding binding{};
+    if (!m_variants.bind(cmd, variant, binding)) return;
 
     VkViewport viewport{
-        .width    = static_cast<float>(extent.width),
-        .height   = static_cast<float>(extent.height),
+        .x        = static_cast<float>(area.offset.x),
+        .y        = static_cast<float>(area.offset.y),
+        .width    = static_cast<float>(area.extent.width),
+        .height   = static_cast<float>(area.extent.height),
         .minDepth = 0.0f,
         .maxDepth = 1.0f,
     };
     vkCmdSetViewport(cmd, 0, 1, &viewport);
-
-    VkRect2D scissor{
-        .offset = {0, 0},
-        .extent = extent,
-    };
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdSetScissor(cmd, 0, 1, &area);
+    if (m_triangle_vertices != 0) {
+        const TrianglePush push{.camera = camera, .vertices = m_triangle_vertices};
+        vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+    }
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_FRAGMENT_BIT, kTintOffset, sizeof(tint), tint.data());
 
     vkCmdDraw(cmd, 3, 1, 0, 0);
 }
-void vk::plugins::ViewportRenderer::begin_rendering(VkCommandBuffer& cmd, const context::AttachmentView& target, VkExtent2D extent) {
+void vk::plugins::ViewportRenderer::begin_rendering(VkCommandBuffer& cmd, const context::AttachmentView& target, VkExtent2D extent, VkRenderingFlags flags) {
     constexpr VkClearValue clear_value{.color = {{0.f, 0.f, 0.f, 1.0f}}};
     VkRenderingAttachmentInfo color_attachment{
         .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
@@ -268,6 +616,7 @@ void vk::plugins::ViewportRenderer::begin_rendering(VkCommandBuffer& cmd, const
     };
     VkRenderingInfo render_info{
         .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags                = flags,
         .renderArea           = {{0, 0}, extent},
         .layerCount           = 1,
         .colorAttachmentCount = 1,
@@ -279,29 +628,27 @@ void vk::plugins::ViewportRenderer::end_rendering(VkCommandBuffer& cmd) {
     vkCmdEndRendering(cmd);
 }
 
+void vk::plugins::ViewportUI::attach(ViewportRenderer& renderer) {
+    this->m_renderer = &renderer;
+    renderer.set_ui_attached(true);
+}
+void vk::plugins::ViewportUI::attach(ViewpoertPlugin& plugin) {
+    this->m_plugin = &plugin;
+}
 void vk::plugins::ViewportUI::create_imgui(context::EngineContext& eng, const context::FrameContext& frm) {
-    std::array<VkDescriptorPoolSize, 11> pool_sizes{{
-        {VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
-        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000},
-        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000},
-        {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000},
-        {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000},
-        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000},
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000},
-        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000},
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000},
-        {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000},
-    }};
-    VkDescriptorPoolCreateInfo pool_info{
-        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .pNext         = nullptr,
-        .flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
-        .maxSets       = 1000u * static_cast<uint32_t>(pool_sizes.size()),
-        .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
-        .pPoolSizes    = pool_sizes.data(),
-    };
-    VK_CHECK(vkCreateDescriptorPool(eng.device, &pool_info, nullptr, &eng.descriptor_allocator.pool));
+    // The ImGui backend only allocates combined image samplers (its font atlas and textures added through
+    // ImGui_ImplVulkan_AddTexture) and frees them one by one, so it gets a small dedicated pool. Other UI descriptors
+    // come from m_descriptors.
+#ifdef IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE
+    constexpr std::uint32_t imgui_sets = IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE;
+#else
+    constexpr std::uint32_t imgui_sets = 8;
+#endif
+    const DescriptorPoolConfig textures{.ratios = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f}}, .initial_sets = 16, .max_sets_per_pool = 256};
+    const DescriptorPoolConfig per_frame{.ratios = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f}, {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f}}, .initial_sets = 16, .max_sets_per_pool = 256};
+    m_descriptors.initialize(eng, textures, per_frame);
+    const VkDescriptorPoolSize imgui_pool_size{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imgui_sets};
+    m_imgui_pool = m_descriptors.create_fixed_pool(std::span(&imgui_pool_size, 1), imgui_sets, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -321,7 +668,7 @@ void vk::plugins::ViewportUI::create_imgui(context::EngineContext& eng, const co
     init_info.Device              = eng.device;
     init_info.QueueFamily         = eng.graphics_queue_family;
     init_info.Queue               = eng.graphics_queue;
-    init_info.DescriptorPool      = eng.descriptor_allocator.pool;
+    init_info.DescriptorPool      = m_imgui_pool;
     init_info.MinImageCount       = context::FRAME_OVERLAP;
     init_info.ImageCount          = context::FRAME_OVERLAP;
     init_info.MSAASamples         = VK_SAMPLE_COUNT_1_BIT;
@@ -339,112 +686,331 @@ void vk::plugins::ViewportUI::create_imgui(context::EngineContext& eng, const co
     };
     init_info.PipelineRenderingCreateInfo = rendering_info;
     if (!ImGui_ImplVulkan_Init(&init_info)) throw std::runtime_error("Failed to initialize ImGui Vulkan backend.");
+
+    // Secondary command buffers the incremental mode records the UI into; see record_ui_commands for the rotation.
+    const VkCommandPoolCreateInfo pool_ci{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = eng.graphics_queue_family,
+    };
+    VK_CHECK(vkCreateCommandPool(eng.device, &pool_ci, nullptr, &m_ui_pool));
+    const VkCommandBufferAllocateInfo cmd_ai{
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = m_ui_pool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = context::FRAME_OVERLAP,
+    };
+    VK_CHECK(vkAllocateCommandBuffers(eng.device, &cmd_ai, m_ui_cmds.data()));
+    m_ui_cmd_valid = false;
 }
 void vk::plugins::ViewportUI::destroy_imgui(const context::EngineContext& eng) {
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplSDL3_Shutdown();
     ImGui::DestroyContext();
+    // The backend has freed its sets; this destroys the ImGui pool with the rest.
+    m_descriptors.destroy(eng);
+    m_imgui_pool = VK_NULL_HANDLE;
+    vkDestroyCommandPool(eng.device, m_ui_pool, nullptr);
+    m_ui_pool      = VK_NULL_HANDLE;
+    m_ui_cmds      = {};
+    m_ui_cmd_valid = false;
 }
 void vk::plugins::ViewportUI::process_event(const SDL_Event& event) {
-    if (event.type == SDL_EVENT_KEY_DOWN) {
-        const auto mods = static_cast<SDL_Keymod>(event.key.mod & (SDL_KMOD_CTRL | SDL_KMOD_SHIFT | SDL_KMOD_ALT));
-        SDL_Keycode key = event.key.key;
-        std::print("Key down: key={} mod={}\n", key, static_cast<int>(mods));
-    }
+    // ImGui's own state is only touched here on the render thread; everything else goes to the simulation's queue.
+    // A few builds after each event let hover and window transitions settle before the UI goes idle again.
+    constexpr std::uint32_t settle_builds = 4;
     ImGui_ImplSDL3_ProcessEvent(&event);
+    m_pending_builds = settle_builds;
+    if (!m_plugin) return;
+
+    InputEvent input{.received = std::chrono::steady_clock::now()};
+    switch (event.type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        if (event.key.repeat) return;
+        input.type = event.type == SDL_EVENT_KEY_DOWN ? InputEventType::KeyDown : InputEventType::KeyUp;
+        input.code = static_cast<std::int32_t>(event.key.key);
+        input.mods = static_cast<std::uint16_t>(event.key.mod & (SDL_KMOD_CTRL | SDL_KMOD_SHIFT | SDL_KMOD_ALT));
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        input.type = InputEventType::MouseMotion;
+        input.x    = event.motion.x;
+        input.y    = event.motion.y;
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        input.type = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN ? InputEventType::MouseButtonDown : InputEventType::MouseButtonUp;
+        input.code = event.button.button;
+        input.x    = event.button.x;
+        input.y    = event.button.y;
+        break;
+    case SDL_EVENT_MOUSE_WHEEL:
+        input.type = InputEventType::MouseWheel;
+        input.x    = event.wheel.x;
+        input.y    = event.wheel.y;
+        break;
+    default: return;
+    }
+    m_plugin->push_input(input);
+}
+void vk::plugins::ViewportUI::draw_simulation_panel() {
+    const ViewportState& state = m_plugin->snapshot();
+    if (state.last_input > m_last_seen_input) {
+        const auto latency   = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.last_input);
+        m_last_seen_input    = state.last_input;
+        m_input_latency.last = latency;
+        m_input_latency.max  = std::max(m_input_latency.max, latency);
+
+        m_input_latency.total += latency;
+        ++m_input_latency.samples;
+    }
+
+    if (!ImGui::Begin("Simulation")) {
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("tick %llu  (%.2f s)", static_cast<unsigned long long>(state.tick), state.sim_time);
+    ImGui::Text("events %llu  dropped %llu", static_cast<unsigned long long>(state.events), static_cast<unsigned long long>(state.dropped_events));
+    ImGui::Text("last key %d  mods 0x%x  mouse %.0f, %.0f", state.last_key, state.mods, state.mouse_x, state.mouse_y);
+    if (m_input_latency.samples > 0) {
+        const double avg_ms = std::chrono::duration<double, std::milli>(m_input_latency.total).count() / static_cast<double>(m_input_latency.samples);
+        ImGui::Text("input -> record  last %.2f ms  avg %.2f ms  max %.2f ms", std::chrono::duration<double, std::milli>(m_input_latency.last).count(), avg_ms, std::chrono::duration<double, std::milli>(m_input_latency.max).count());
+    }
+    ImGui::End();
 }
 void vk::plugins::ViewportUI::record_imgui(VkCommandBuffer& cmd, const context::FrameContext& frm) {
-    ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplSDL3_NewFrame();
-    ImGui::NewFrame();
+    const auto ui_start = std::chrono::steady_clock::now();
+    m_descriptors.begin_frame(static_cast<std::uint32_t>(m_frame_number++ % context::FRAME_OVERLAP));
+
+    Profiler* profiler = m_renderer ? &m_renderer->profiler() : nullptr;
+    std::optional<CpuZone> cpu_zone;
+    if (profiler) cpu_zone.emplace(*profiler, "record_imgui");
 
-    static bool show_demo_window = true;
-    ImGui::ShowDemoWindow(&show_demo_window);
+    // Without a build the previous ImGui::GetDrawData() stays valid; it lives until the next NewFrame.
+    const bool build = !m_incremental || needs_ui_build(ui_start);
+    if (build) {
+        ImGui_ImplVulkan_NewFrame();
+        ImGui_ImplSDL3_NewFrame();
+        ImGui::NewFrame();
 
-    ImGui::Render();
+        static bool show_demo_window = true;
+        ImGui::ShowDemoWindow(&show_demo_window);
+        if (profiler) draw_profiler_panel(*profiler);
+        if (m_plugin) draw_simulation_panel();
+
+        ImGui::Render();
+        m_last_build = ui_start;
+        if (m_pending_builds > 0) --m_pending_builds;
+    }
+    ImDrawData* draw_data = ImGui::GetDrawData();
 
-    // Determine the target image and view based on presentation mode
+    // The renderer's graph still tracks the scene attachment in COLOR_ATTACHMENT_OPTIMAL, so drawing on top of it needs
+    // no layout change; end_frame() then hands every attachment back to the engine in one batch.
+    RenderGraph& graph      = m_renderer ? m_renderer->render_graph() : m_render_graph;
     VkImage target_image    = VK_NULL_HANDLE;
     VkImageView target_view = VK_NULL_HANDLE;
+    ResourceId target       = 0;
 
-    if (frm.presentation_mode == context::PresentationMode::DirectToSwapchain) {
-        // Render directly to swapchain
+    if (frm.presentation_mode != context::PresentationMode::DirectToSwapchain && !frm.color_attachments.empty()) {
+        // Render to offscreen attachment (EngineBlit or RendererComposite modes)
+        const auto& attachment = frm.color_attachments.front();
+        target_image           = attachment.image;
+        target_view            = attachment.view;
+        target                 = graph.import_image(target_image, attachment.aspect, states::kEngineGeneral, states::kEngineGeneral);
+    } else {
+        // Render directly to swapchain, also the fallback if there are no offscreen attachments
         target_image = frm.swapchain_image;
         target_view  = frm.swapchain_image_view;
-        transition_to_color_attachment(cmd, target_image, VK_IMAGE_LAYOUT_UNDEFINED);
-    } else {
-        // Render to offscreen attachment (EngineBlit or RendererComposite modes)
-        if (!frm.color_attachments.empty()) {
-            target_image = frm.color_attachments[0].image;
-            target_view  = frm.color_attachments[0].view;
-            // Transition from general layout (used by renderer) to color attachment
-            transition_to_color_attachment(cmd, target_image, VK_IMAGE_LAYOUT_GENERAL);
+        target       = graph.import_image(target_image, VK_IMAGE_ASPECT_COLOR_BIT, states::kAcquired, states::kPresent);
+    }
+
+    bool recorded        = false;
+    std::uint64_t upload = 0;
+    if (target_image != VK_NULL_HANDLE && target_view != VK_NULL_HANDLE && draw_data != nullptr) {
+        const std::uint64_t draw_bytes = static_cast<std::uint64_t>(draw_data->TotalVtxCount) * sizeof(ImDrawVert) + static_cast<std::uint64_t>(draw_data->TotalIdxCount) * sizeof(ImDrawIdx);
+        // The secondary's inheritance must match the instance it executes in, which resumes the scene pass when merged.
+        const VkRenderingFlags rendering_flags = m_renderer && m_renderer->scene_suspended() ? VK_RENDERING_RESUMING_BIT : 0;
+        if (m_incremental) {
+            // Re-record only when the draw data or the instance it executes in changed; the draw data's hash can only change
+            // after a build.
+            bool record = !m_ui_cmd_valid || m_ui_cmd_format != frm.swapchain_format || m_ui_cmd_rendering_flags != rendering_flags;
+            if (build) {
+                const std::uint64_t hash = hash_draw_data(*draw_data);
+                record                   = record || hash != m_draw_hash;
+                m_draw_hash              = hash;
+            }
+            if (record) record_ui_commands(draw_data, frm.swapchain_format, rendering_flags);
+            recorded = record;
         } else {
-            // Fallback to swapchain if no offscreen attachments
-            target_image = frm.swapchain_image;
-            target_view  = frm.swapchain_image_view;
-            transition_to_color_attachment(cmd, target_image, VK_IMAGE_LAYOUT_UNDEFINED);
+            recorded = true;
         }
-    }
+        upload                          = recorded ? draw_bytes : 0;
+        const VkRenderingFlags contents = m_incremental ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
 
-    if (target_image != VK_NULL_HANDLE && target_view != VK_NULL_HANDLE) {
-        VkRenderingAttachmentInfo color_attachment{
-            .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-            .imageView   = target_view,
-            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .loadOp      = VK_ATTACHMENT_LOAD_OP_LOAD, // Load existing content to preserve triangle
-            .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,
-        };
-        VkRenderingInfo rendering_info{
-            .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
-            .renderArea           = {{0, 0}, frm.extent},
-            .layerCount           = 1u,
-            .colorAttachmentCount = 1u,
-            .pColorAttachments    = &color_attachment,
-        };
-        vkCmdBeginRendering(cmd, &rendering_info);
-        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
+        // With pass merging the scene pass was suspended on this same attachment: resuming it needs no barrier and the
+        // attachment is neither stored nor reloaded in between.
+        if (!m_renderer || !m_renderer->resume_scene_pass(cmd, contents)) {
+            graph.use(target, states::kColorAttachment);
+            graph.flush(cmd);
+
+            VkRenderingAttachmentInfo color_attachment{
+                .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .imageView   = target_view,
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .loadOp      = VK_ATTACHMENT_LOAD_OP_LOAD, // Load existing content to preserve triangle
+                .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,
+            };
+            VkRenderingInfo rendering_info{
+                .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                .flags                = contents,
+                .renderArea           = {{0, 0}, frm.extent},
+                .layerCount           = 1u,
+                .colorAttachmentCount = 1u,
+                .pColorAttachments    = &color_attachment,
+            };
+            vkCmdBeginRendering(cmd, &rendering_info);
+        }
+        if (m_incremental) {
+            // A secondary-contents instance only allows vkCmdExecuteCommands, and a replayed secondary cannot carry this
+            // frame's query indices, so the UI has no GPU scope in this mode.
+            vkCmdExecuteCommands(cmd, 1, &m_ui_cmds[m_ui_cmd_index]);
+        } else {
+            const auto ui_scope = profiler ? profiler->begin_gpu_scope(cmd, "ui") : Profiler::kInvalidScope;
+            ImGui_ImplVulkan_RenderDrawData(draw_data, cmd);
+            if (profiler) profiler->end_gpu_scope(cmd, ui_scope);
+        }
         vkCmdEndRendering(cmd);
 
-        // Handle ImGui viewport processing after command buffer recording but before presentation
+        // Handle ImGui viewport processing after command buffer recording but before presentation. Platform windows
+        // keep showing their last image while the UI is idle.
         ImGuiIO& io = ImGui::GetIO();
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+        if (build && (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)) {
             ImGui::UpdatePlatformWindows();
             ImGui::RenderPlatformWindowsDefault();
         }
-
-        // Transition back to the appropriate layout
-        if (frm.presentation_mode == context::PresentationMode::DirectToSwapchain) {
-            transition_to_present(cmd, target_image);
-        } else {
-            // Transition back to general layout for offscreen attachments
-            VkImageMemoryBarrier2 barrier{
-                .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                .srcStageMask     = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-                .srcAccessMask    = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-                .dstStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                .dstAccessMask    = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
-                .oldLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                .newLayout        = VK_IMAGE_LAYOUT_GENERAL,
-                .image            = target_image,
-                .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u},
-            };
-            VkDependencyInfo dep{
-                .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-                .imageMemoryBarrierCount = 1u,
-                .pImageMemoryBarriers    = &barrier,
-            };
-            vkCmdPipelineBarrier2(cmd, &dep);
-        }
     }
+    if (m_renderer) m_renderer->finish_frame(cmd);
+    else graph.end_frame(cmd);
+
+    update_ui_stats(build, recorded, upload, std::chrono::steady_clock::now() - ui_start);
+}
+void vk::plugins::ViewportUI::set_incremental(bool enabled) {
+    if (m_incremental == enabled) return;
+    m_incremental    = enabled;
+    m_ui_cmd_valid   = false;
+    m_pending_builds = 1;
+    m_ui_stats       = {.incremental = enabled};
+}
+bool vk::plugins::ViewportUI::needs_ui_build(std::chrono::steady_clock::time_point now) const {
+    if (m_pending_builds > 0) return true;
+    // As of the last build: a held widget, a blinking text cursor or a drag is still animating.
+    const ImGuiIO& io = ImGui::GetIO();
+    if (ImGui::IsAnyItemActive() || io.WantTextInput || ImGui::IsMouseDragging(ImGuiMouseButton_Left)) return true;
+    return now - m_last_build >= m_idle_refresh;
+}
+void vk::plugins::ViewportUI::record_ui_commands(ImDrawData* draw_data, VkFormat format, VkRenderingFlags rendering_flags) {
+    // Rotate through FRAME_OVERLAP buffers: the one re-recorded here was last executed at least FRAME_OVERLAP frames
+    // ago, so it has retired. The backend's vertex buffers rotate per RenderDrawData call in the same way.
+    m_ui_cmd_index            = (m_ui_cmd_index + 1) % context::FRAME_OVERLAP;
+    VkCommandBuffer secondary = m_ui_cmds[m_ui_cmd_index];
+    VK_CHECK(vkResetCommandBuffer(secondary, 0));
+
+    const VkCommandBufferInheritanceRenderingInfo inheritance_rendering{
+        .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .flags                   = rendering_flags,
+        .colorAttachmentCount    = 1,
+        .pColorAttachmentFormats = &format,
+        .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT,
+    };
+    const VkCommandBufferInheritanceInfo inheritance{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &inheritance_rendering,
+    };
+    // Replayed every frame until the UI changes, so it may be pending in several frames in flight at once.
+    const VkCommandBufferBeginInfo bi{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+        .pInheritanceInfo = &inheritance,
+    };
+    VK_CHECK(vkBeginCommandBuffer(secondary, &bi));
+    ImGui_ImplVulkan_RenderDrawData(draw_data, secondary);
+    VK_CHECK(vkEndCommandBuffer(secondary));
+    m_ui_cmd_valid           = true;
+    m_ui_cmd_format          = format;
+    m_ui_cmd_rendering_flags = rendering_flags;
+}
+void vk::plugins::ViewportUI::update_ui_stats(bool built, bool recorded, std::uint64_t bytes, std::chrono::nanoseconds cpu_time) {
+    constexpr std::uint32_t report_interval = 600;
+    ++m_ui_stats.frames;
+    m_ui_stats.built += built ? 1 : 0;
+    m_ui_stats.recorded += recorded ? 1 : 0;
+    m_ui_stats.cpu_time += cpu_time;
+    m_ui_stats.bytes_uploaded += bytes;
+    if (m_ui_stats.frames < report_interval) return;
+
+    const double frames = m_ui_stats.frames;
+    std::println("[ui] mode={} frames={} built={} recorded={} avg cpu {:.3f} ms, avg upload {:.1f} KiB/frame", m_ui_stats.incremental ? "incremental" : "full", m_ui_stats.frames, m_ui_stats.built, m_ui_stats.recorded, std::chrono::duration<double, std::milli>(m_ui_stats.cpu_time).count() / frames, static_cast<double>(m_ui_stats.bytes_uploaded) / 1024.0 / frames);
+    m_ui_stats = {.incremental = m_incremental};
 }
 
 void vk::plugins::ViewpoertPlugin::initialize() {
+    m_last_update = std::chrono::steady_clock::now();
+    if (m_tick_rate > 0.0) m_thread = std::jthread([this](const std::stop_token& stop) { run(stop); });
     std::println("Viewport Plugin initialized.");
 }
 void vk::plugins::ViewpoertPlugin::update() {
-    // std::println("Viewpoint Plugin updated.");
+    if (m_thread.joinable()) return;
+    const auto now = std::chrono::steady_clock::now();
+    tick(std::chrono::duration<double>(now - std::exchange(m_last_update, now)).count());
 }
 void vk::plugins::ViewpoertPlugin::shutdown() {
+    if (m_thread.joinable()) {
+        m_thread.request_stop();
+        m_thread.join();
+    }
     std::println("Viewport Plugin shutdown.");
 }
+bool vk::plugins::ViewpoertPlugin::push_input(const InputEvent& event) {
+    if (m_input.try_push(event)) return true;
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+void vk::plugins::ViewpoertPlugin::run(const std::stop_token& stop) {
+    // Fixed timestep on an absolute schedule. Ticks missed in a short stall are replayed back to back; once the schedule
+    // is more than max_catch_up periods behind, the backlog is dropped and the schedule restarts from now.
+    using clock                = std::chrono::steady_clock;
+    constexpr int max_catch_up = 4;
+    const double dt            = 1.0 / m_tick_rate;
+    const auto period          = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
+    auto next                  = clock::now() + period;
+    while (!stop.stop_requested()) {
+        std::this_thread::sleep_until(next);
+        tick(dt);
+        next += period;
+        if (clock::now() - next > period * max_catch_up) next = clock::now() + period;
+    }
+}
+void vk::plugins::ViewpoertPlugin::tick(double dt) {
+    InputEvent event{};
+    while (m_input.try_pop(event)) {
+        ++m_state.events;
+        m_state.last_input = event.received;
+        switch (event.type) {
+        case InputEventType::KeyDown:
+            m_state.last_key = event.code;
+            m_state.mods     = event.mods;
+            break;
+        case InputEventType::MouseMotion:
+        case InputEventType::MouseButtonDown:
+        case InputEventType::MouseButtonUp:
+            m_state.mouse_x = event.x;
+            m_state.mouse_y = event.y;
+            break;
+        default: break;
+        }
+    }
+    ++m_state.tick;
+    m_state.sim_time += dt;
+    m_state.dropped_events = m_dropped.load(std::memory_order_relaxed);
+    m_snapshots.publish(m_state);
+}
@@ -0,0 +1,21 @@
+#version 460
+// Streamed point-cloud chunks; each draw's firstVertex selects its chunk's slot in the resident pool.
+struct Point {
+    vec3 position;
+    uint color;
+};
+layout(std430, set = 0, binding = 0) readonly buffer Points {
+    Point points[];
+};
+layout(push_constant) uniform Push {
+    mat4 view_proj;
+    float point_size;
+} pc;
+layout(location = 0) out vec3 vColor;
+
+void main() {
+    Point p = points[gl_VertexIndex];
+    gl_Position = pc.view_proj * vec4(p.position, 1.0);
+    gl_PointSize = pc.point_size;
+    vColor = unpackUnorm4x8(p.color).rgb;
+}
@@ -0,0 +1,33 @@
+#version 460
+// Instanced quads; per-instance data comes from the frame's region of the batch storage buffer.
+struct Instance {
+    vec4 position_scale;
+    vec4 color;
+};
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+// Compacted by viewport_cull.comp when culling is enabled.
+layout(std430, set = 0, binding = 1) readonly buffer Visible {
+    uint visible[];
+};
+layout(push_constant) uniform Push {
+    mat4 view_proj;
+    uint use_visible_list;
+} pc;
+layout(location = 0) out vec3 vColor;
+
+const vec2 kCorners[4] = vec2[](
+vec2(-1.0, -1.0),
+vec2(1.0, -1.0),
+vec2(1.0, 1.0),
+vec2(-1.0, 1.0)
+);
+
+void main() {
+    uint index = pc.use_visible_list != 0u ? visible[gl_InstanceIndex] : uint(gl_InstanceIndex);
+    Instance inst = instances[index];
+    vec3 p = inst.position_scale.xyz + vec3(kCorners[gl_VertexIndex] * inst.position_scale.w, 0.0);
+    gl_Position = pc.view_proj * vec4(p, 1.0);
+    vColor = inst.color.rgb;
+}
@@ -0,0 +1,25 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+// Same triangle as viewport.vert, but its vertices and camera are streamed each frame through the upload arena.
+layout(location = 0) out vec3 vColor;
+
+struct StreamVertex {
+    vec4 position;
+    vec4 color;
+};
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer Camera {
+    mat4 view_proj;
+};
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer Vertices {
+    StreamVertex vertices[];
+};
+layout(push_constant) uniform Push {
+    Camera camera;
+    Vertices geometry;
+} pc;
+
+void main() {
+    StreamVertex v = pc.geometry.vertices[gl_VertexIndex];
+    gl_Position = pc.camera.view_proj * v.position;
+    vColor = v.color.rgb;
+}
@@ -0,0 +1,18 @@
+#version 460
+// viewport.frag with its variants: the shading mode is a specialization constant, so each mode compiles to a
+// branch-free pipeline, while the tint is pushed per draw and never needs a pipeline of its own.
+layout(location = 0) in vec3 vColor;
+layout(location = 0) out vec4 outColor;
+
+layout(constant_id = 0) const uint kShading = 0; // 0 vertex colour, 1 luminance, 2 flat
+
+layout(push_constant) uniform Push {
+    layout(offset = 16) vec4 tint;
+} pc;
+
+void main() {
+    vec3 color = vColor;
+    if (kShading == 1) color = vec3(dot(vColor, vec3(0.2126, 0.7152, 0.0722)));
+    else if (kShading == 2) color = vec3(1.0);
+    outColor = vec4(color, 1.0) * pc.tint;
+}
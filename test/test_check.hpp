@@ -0,0 +1,25 @@
+#pragma once
+#include <print>
+
+namespace vk::test {
+    // Failure bookkeeping shared by the test executables. A test declares one instance named `check`, calls it like a
+    // function for every condition and returns finish() from main.
+    class Checks {
+    public:
+        explicit Checks(const char* name) : m_name(name) {}
+
+        void operator()(bool condition, const char* what) {
+            if (condition) return;
+            std::println("[{}] FAILED: {}", m_name, what);
+            ++m_failures;
+        }
+        [[nodiscard]] int finish() const {
+            if (m_failures == 0) std::println("[{}] all checks passed", m_name);
+            return m_failures == 0 ? 0 : 1;
+        }
+
+    private:
+        const char* m_name;
+        int m_failures{0};
+    };
+} // namespace vk::test
@@ -0,0 +1,82 @@
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.batch;
+import vk.plugins.culling;
+
+namespace {
+    vk::test::Checks check{"test-culling"};
+
+    // Right-handed, 90 degree vertical fov, aspect 1, Vulkan depth range; camera at the origin looking down -z.
+    constexpr float kNear = 0.1f;
+    constexpr float kFar  = 100.0f;
+    constexpr std::array<float, 16> kViewProj{
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, kFar / (kNear - kFar), -1,
+        0, 0, kNear * kFar / (kNear - kFar), 0,
+    };
+
+    float clip_depth(float view_z) {
+        return (kViewProj[10] * view_z + kViewProj[14]) / -view_z;
+    }
+} // namespace
+
+int main() {
+    using namespace vk::plugins;
+
+    const Frustum frustum = extract_frustum(kViewProj);
+    const float ahead[3]{0, 0, -5};
+    const float behind[3]{0, 0, 5};
+    const float far_side[3]{20, 0, -5};
+    const float straddling[3]{5.4f, 0, -5};
+    const float beyond_far[3]{0, 0, -200};
+    check(sphere_in_frustum(frustum, ahead, 0.5f), "sphere ahead of the camera is inside");
+    check(!sphere_in_frustum(frustum, behind, 0.5f), "sphere behind the camera is culled by the near plane");
+    check(!sphere_in_frustum(frustum, far_side, 0.5f), "sphere left of the right plane is culled");
+    check(sphere_in_frustum(frustum, straddling, 0.5f), "sphere straddling the right plane is kept");
+    check(!sphere_in_frustum(frustum, beyond_far, 0.5f), "sphere past the far plane is culled");
+
+    const std::vector<InstanceData> instances{
+        {{0, 0, -5}, 0.5f, {1, 1, 1, 1}},
+        {{0, 0, 5}, 0.5f, {1, 1, 1, 1}},
+        {{20, 0, -5}, 0.5f, {1, 1, 1, 1}},
+        {{-1, 1, -10}, 0.5f, {1, 1, 1, 1}},
+        {{0, 0, -200}, 0.5f, {1, 1, 1, 1}},
+    };
+    std::vector<std::uint32_t> visible;
+    check(cull_instances_cpu(instances, kViewProj, nullptr, visible) == 2, "frustum culling keeps two instances");
+    check(visible == std::vector<std::uint32_t>{0, 3}, "surviving indices are reported in order");
+
+    // 64x48 depth buffer: an occluder at z = -2 covers the left half, the right half is empty (far plane).
+    constexpr std::uint32_t width  = 64;
+    constexpr std::uint32_t height = 48;
+    std::vector<float> depth(width * height, 1.0f);
+    for (std::uint32_t y = 0; y < height; ++y)
+        for (std::uint32_t x = 0; x < width / 2; ++x) depth[y * width + x] = clip_depth(-2.0f);
+
+    const HiZPyramid hiz = build_hiz_pyramid(depth, width, height);
+    check(hiz.levels.size() == 7, "pyramid reduces 64x48 down to 1x1");
+    check(hiz.levels[1].width == 32 && hiz.levels[1].height == 24, "level 1 halves both dimensions");
+    check(hiz.levels.back().width == 1 && hiz.levels.back().height == 1, "last level is a single texel");
+    check(hiz.levels.back().depth[0] == 1.0f, "top level keeps the maximum depth");
+
+    const float hidden[3]{-2, 0, -10};
+    const float exposed[3]{2, 0, -10};
+    const float in_front[3]{-0.5f, 0, -1};
+    check(hiz_occluded(hiz, kViewProj, hidden, 0.5f), "sphere behind the occluder is occluded");
+    check(!hiz_occluded(hiz, kViewProj, exposed, 0.5f), "sphere over empty depth is visible");
+    check(!hiz_occluded(hiz, kViewProj, in_front, 0.2f), "sphere in front of the occluder is visible");
+
+    const std::vector<InstanceData> occlusion_scene{
+        {{-2, 0, -10}, 0.5f, {1, 1, 1, 1}},
+        {{2, 0, -10}, 0.5f, {1, 1, 1, 1}},
+        {{-0.5f, 0, -1}, 0.2f, {1, 1, 1, 1}},
+    };
+    visible.clear();
+    check(cull_instances_cpu(occlusion_scene, kViewProj, &hiz, visible) == 2, "Hi-Z culling removes the hidden instance");
+    check(visible == std::vector<std::uint32_t>{1, 2}, "Hi-Z survivors are the exposed and near instances");
+
+    return check.finish();
+}
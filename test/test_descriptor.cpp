@@ -0,0 +1,66 @@
+#include <array>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "test_check.hpp"
+import vk.plugins.descriptor;
+
+namespace {
+    vk::test::Checks check{"test-descriptor"};
+
+    void test_layout_usage() {
+        const std::array<VkDescriptorSetLayoutBinding, 3> bindings{{
+            {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1},
+            {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 2},
+            {.binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 4},
+        }};
+        const auto usage = vk::plugins::layout_usage(bindings);
+        check(usage.sets == 1, "a layout is one set");
+        check(usage.descriptors[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER] == 3, "storage buffers summed over bindings");
+        check(usage.descriptors[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] == 4, "array bindings count every element");
+        check(usage.total_descriptors() == 7, "total descriptors");
+    }
+
+    void test_usage_accumulation() {
+        vk::plugins::DescriptorUsage a{.sets = 2};
+        a.descriptors[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] = 5;
+        vk::plugins::DescriptorUsage b{.sets = 3};
+        b.descriptors[VK_DESCRIPTOR_TYPE_SAMPLER] = 1;
+
+        vk::plugins::DescriptorUsage sum = a;
+        sum.add(b);
+        check(sum.sets == 5 && sum.descriptors[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] == 5 && sum.descriptors[VK_DESCRIPTOR_TYPE_SAMPLER] == 1, "add sums sets and every type");
+
+        vk::plugins::DescriptorUsage peak = a;
+        peak.raise_to(b);
+        check(peak.sets == 3, "high-water keeps the larger set count");
+        check(peak.descriptors[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] == 5 && peak.descriptors[VK_DESCRIPTOR_TYPE_SAMPLER] == 1, "high-water is element-wise");
+    }
+
+    void test_pool_sizing() {
+        const std::array<vk::plugins::DescriptorRatio, 2> ratios{{
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0.25f},
+        }};
+        const auto sizes = vk::plugins::descriptor_pool_sizes(ratios, 10);
+        check(sizes.size() == 2, "one pool size per ratio");
+        check(sizes[0].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && sizes[0].descriptorCount == 10, "ratio 1 gives one per set");
+        check(sizes[1].descriptorCount == 3, "fractional ratios round up");
+        check(vk::plugins::descriptor_pool_sizes(ratios, 1)[1].descriptorCount == 1, "never sizes a type to zero");
+    }
+
+    void test_pool_growth() {
+        check(vk::plugins::next_pool_sets(16, 1024) == 24, "pools grow by half");
+        check(vk::plugins::next_pool_sets(1, 1024) == 2, "growth makes progress from one set");
+        check(vk::plugins::next_pool_sets(900, 1024) == 1024, "growth is capped");
+        check(vk::plugins::next_pool_sets(1024, 1024) == 1024, "capped chains stay at the cap");
+    }
+} // namespace
+
+int main() {
+    test_layout_usage();
+    test_usage_accumulation();
+    test_pool_sizing();
+    test_pool_growth();
+
+    return check.finish();
+}
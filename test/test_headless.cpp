@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <span>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.batch;
+import vk.plugins.capture;
+import vk.plugins.headless;
+import vk.plugins.profiler;
+import vk.plugins.viewport;
+
+namespace {
+    vk::test::Checks check{"test-headless"};
+
+    std::uint32_t be32(const std::vector<std::byte>& data, std::size_t offset) {
+        std::uint32_t v = 0;
+        for (std::size_t i = 0; i < 4; ++i) v = (v << 8) | static_cast<std::uint8_t>(data[offset + i]);
+        return v;
+    }
+
+    void png_round_trip() {
+        // 2x2 BGRA: blue, green / red, white.
+        const std::vector<std::uint8_t> bgra{255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 255, 128};
+        const auto png = vk::plugins::encode_png(std::as_bytes(std::span(bgra)), 2, 2, true);
+
+        const std::uint8_t signature[8]{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        check(png.size() > 57 && std::equal(signature, signature + 8, reinterpret_cast<const std::uint8_t*>(png.data())), "PNG signature");
+        check(be32(png, 8) == 13 && be32(png, 16) == 2 && be32(png, 20) == 2, "IHDR size and dimensions");
+        check(static_cast<std::uint8_t>(png[24]) == 8 && static_cast<std::uint8_t>(png[25]) == 6, "IHDR is 8-bit RGBA");
+
+        // IDAT data starts after the 33-byte header + IHDR and its 8-byte chunk prefix: zlib header, one final stored
+        // block of 18 bytes (two filter-0 scanlines), then adler32.
+        constexpr std::size_t idat = 41;
+        check(be32(png, 33) == 2 + 5 + 18 + 4, "IDAT length");
+        check(static_cast<std::uint8_t>(png[idat + 2]) == 1 && static_cast<std::uint8_t>(png[idat + 3]) == 18, "single final stored block");
+        const std::byte* rows = png.data() + idat + 7;
+        const std::uint8_t expected[18]{0, 0, 0, 255, 255, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 128};
+        check(std::equal(expected, expected + 18, reinterpret_cast<const std::uint8_t*>(rows)), "scanlines swizzled to RGBA");
+
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        for (const std::uint8_t v : expected) {
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+        }
+        check(be32(png, idat + 7 + 18) == ((b << 16) | a), "adler32 of the scanlines");
+    }
+} // namespace
+
+int main() {
+    png_round_trip();
+
+    const std::filesystem::path output{"headless_capture"};
+    std::filesystem::remove_all(output);
+
+    vk::plugins::ViewportRenderer renderer;
+    renderer.set_capture({.output = output, .format = vk::plugins::CaptureFormat::Raw});
+    renderer.set_pipeline_statistics(true);
+    const vk::plugins::HeadlessConfig config{.extent = {256, 256}, .frames = 6, .prefer_software = true};
+    try {
+        const auto stats = vk::plugins::HeadlessRunner{}.run(renderer, config);
+        check(stats.frames == config.frames, "every frame submitted");
+    } catch (const vk::plugins::NoSuitableDevice& e) {
+        std::println("[test-headless] skipping offscreen run: {}", e.what());
+        return check.finish();
+    }
+
+    if (renderer.device_features().pipeline_statistics_query) {
+        const auto& history = renderer.profiler().history();
+        const bool counted  = std::ranges::any_of(history, [](const vk::plugins::ProfileFrame& frame) { return frame.pipeline && frame.pipeline->input_vertices > 0 && frame.pipeline->fragment_invocations > 0; });
+        check(counted, "scene pass pipeline statistics reach the profiler history");
+    } else {
+        std::println("[test-headless] device lacks pipelineStatisticsQuery; statistics not checked");
+    }
+
+    const auto capture = renderer.capture_stats();
+    check(capture.written + capture.dropped == config.frames, "every frame written or dropped");
+    check(capture.written > 0, "at least one frame written");
+
+    std::vector<std::filesystem::path> frames;
+    for (const auto& entry : std::filesystem::directory_iterator(output)) {
+        if (entry.path().extension() == ".raw") frames.push_back(entry.path());
+    }
+    std::ranges::sort(frames);
+    check(frames.size() == capture.written, "one raw file per written frame");
+    if (!frames.empty()) {
+        std::ifstream file(frames.back(), std::ios::binary);
+        std::vector<char> pixels(256 * 256 * 4);
+        file.read(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+        check(file.gcount() == static_cast<std::streamsize>(pixels.size()), "raw frame holds width * height * 4 bytes");
+        // The viewport triangle covers the centre of the attachment.
+        const std::size_t centre = (128 * 256 + 128) * 4;
+        check(pixels[centre] != 0 || pixels[centre + 1] != 0 || pixels[centre + 2] != 0, "centre pixel is drawn");
+    }
+
+    // Two views side by side on the presented attachment: both count as draws, and the benchmark advances.
+    {
+        vk::plugins::ViewportRenderer split;
+        split.set_views({
+            {.name = "left", .area = {{0, 0}, {128, 256}}},
+            {.name = "right", .area = {{128, 0}, {128, 256}}},
+        });
+        split.batches().start_benchmark({64, 64}, 1);
+        const vk::plugins::HeadlessConfig split_config{.extent = {256, 256}, .frames = 60, .prefer_software = true};
+        try {
+            vk::plugins::HeadlessRunner{}.run(split, split_config);
+        } catch (const vk::plugins::NoSuitableDevice& e) {
+            std::println("[test-headless] skipping multi-view run: {}", e.what());
+            return check.finish();
+        }
+        check(split.batches().stats().draw_calls == 2, "one batch draw per view");
+        check(!split.batches().benchmark_running(), "multi-view frames advance the benchmark");
+    }
+
+    return check.finish();
+}
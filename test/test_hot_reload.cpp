@@ -0,0 +1,92 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.hot_reload;
+
+namespace {
+    vk::test::Checks check{"test-hot-reload"};
+
+    const std::filesystem::file_time_type kBaseTime = std::filesystem::file_time_type::clock::now();
+
+    // Rewrites the file and sets its time explicitly, so the test does not depend on timestamp resolution.
+    void write(const std::filesystem::path& path, const std::string& text, int generation) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << text;
+        }
+        std::filesystem::last_write_time(path, kBaseTime + std::chrono::seconds(generation));
+    }
+
+    void test_settling(const std::filesystem::path& path) {
+        write(path, "v1", 1);
+        vk::plugins::FileWatcher watcher;
+        std::vector<std::filesystem::path> callbacks;
+        watcher.watch(path, [&](const std::filesystem::path& p) { callbacks.push_back(p); });
+
+        watcher.scan();
+        check(watcher.take_changes().empty(), "an untouched file reports nothing");
+
+        write(path, "version 2", 2);
+        watcher.scan();
+        check(watcher.take_changes().empty(), "a change is held back until it settles");
+        watcher.scan();
+        const auto changes = watcher.take_changes();
+        check(changes.size() == 1 && changes[0] == path, "a settled change is published once");
+        check(callbacks.size() == 1 && callbacks[0] == path, "the callback runs for a settled change");
+        watcher.scan();
+        check(watcher.take_changes().empty(), "a published change is not reported again");
+
+        write(path, "version 3", 3);
+        watcher.scan();
+        write(path, "version four", 4); // still being written
+        watcher.scan();
+        check(watcher.take_changes().empty(), "a file that keeps changing is not published");
+        watcher.scan();
+        check(watcher.take_changes().size() == 1 && callbacks.size() == 2, "it is published once it stops changing");
+    }
+
+    void test_replace(const std::filesystem::path& path) {
+        write(path, "v1", 1);
+        vk::plugins::FileWatcher watcher;
+        watcher.watch(path);
+        std::filesystem::remove(path);
+        watcher.scan();
+        watcher.scan();
+        check(watcher.take_changes().empty(), "a deleted file reports nothing");
+        write(path, "v2", 2);
+        watcher.scan();
+        watcher.scan();
+        check(watcher.take_changes().size() == 1, "a recreated file is reported");
+    }
+
+    void test_thread(const std::filesystem::path& path) {
+        write(path, "v1", 1);
+        vk::plugins::FileWatcher watcher;
+        watcher.watch(path);
+        watcher.start(std::chrono::milliseconds(1));
+        write(path, "v2", 2);
+
+        std::vector<std::filesystem::path> changes;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (changes.empty() && std::chrono::steady_clock::now() < deadline) {
+            changes = watcher.take_changes();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        watcher.stop();
+        check(changes.size() == 1 && changes[0] == path, "the watcher thread publishes changes");
+    }
+} // namespace
+
+int main() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "test_hot_reload.spv";
+    test_settling(path);
+    test_replace(path);
+    test_thread(path);
+    std::filesystem::remove(path);
+
+    return check.finish();
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.input;
+
+namespace {
+    vk::test::Checks check{"test-input-queue"};
+
+    void test_bounds() {
+        vk::plugins::SpmcRing<std::uint32_t, 8> ring;
+        std::uint32_t value = 0;
+        check(!ring.try_pop(value), "empty ring pops nothing");
+        for (std::uint32_t i = 0; i < 8; ++i) check(ring.try_push(i), "push below capacity");
+        check(!ring.try_push(8), "full ring rejects the push");
+        check(ring.size() == 8, "size counts queued items");
+        for (std::uint32_t i = 0; i < 8; ++i) check(ring.try_pop(value) && value == i, "pops in FIFO order");
+        check(!ring.try_pop(value), "drained ring pops nothing");
+        check(ring.try_push(42) && ring.try_pop(value) && value == 42, "ring wraps around");
+    }
+
+    // Every item is delivered exactly once across consumers, and each consumer sees its items in push order.
+    void test_multi_consumer_throughput() {
+        constexpr std::uint64_t items = 2'000'000;
+        const std::uint32_t consumers = std::clamp(std::thread::hardware_concurrency(), 2u, 4u) - 1;
+        vk::plugins::SpmcRing<std::uint64_t, 1024> ring;
+
+        std::atomic<std::uint64_t> consumed{0};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<bool> ordered{true};
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::jthread> threads;
+        for (std::uint32_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                std::uint64_t value     = 0;
+                std::uint64_t local_sum = 0;
+                std::uint64_t last      = 0;
+                bool first              = true;
+                while (consumed.load(std::memory_order_relaxed) < items) {
+                    if (!ring.try_pop(value)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (!first && value <= last) ordered.store(false, std::memory_order_relaxed);
+                    first = false;
+                    last  = value;
+                    local_sum += value;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                sum.fetch_add(local_sum, std::memory_order_relaxed);
+            });
+        }
+        for (std::uint64_t i = 0; i < items; ++i) {
+            while (!ring.try_push(i)) std::this_thread::yield();
+        }
+        threads.clear();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        check(consumed.load() == items, "every item consumed");
+        check(sum.load() == items * (items - 1) / 2, "no item lost or duplicated");
+        check(ordered.load(), "each consumer sees increasing values");
+        std::println("[test-input-queue] throughput: {} items, 1 producer / {} consumers, {:.1f} M items/s", items, consumers, static_cast<double>(items) / seconds / 1e6);
+    }
+
+    // Push-to-pop latency of one InputEvent at a time with a consumer polling the ring.
+    void test_latency() {
+        constexpr std::uint32_t samples = 20'000;
+        vk::plugins::SpmcRing<vk::plugins::InputEvent, 1024> ring;
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(samples);
+        std::atomic<std::uint32_t> received{0};
+
+        std::jthread consumer([&] {
+            vk::plugins::InputEvent event{};
+            while (received.load(std::memory_order_relaxed) < samples) {
+                if (!ring.try_pop(event)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - event.received).count());
+                received.fetch_add(1, std::memory_order_release);
+            }
+        });
+        for (std::uint32_t i = 0; i < samples; ++i) {
+            ring.try_push({.type = vk::plugins::InputEventType::KeyDown, .code = static_cast<std::int32_t>(i), .received = std::chrono::steady_clock::now()});
+            while (received.load(std::memory_order_acquire) <= i) std::this_thread::yield();
+        }
+        consumer.join();
+
+        check(latencies.size() == samples, "one latency sample per event");
+        if (latencies.empty()) return;
+        std::ranges::sort(latencies);
+        const auto percentile = [&](double p) { return static_cast<double>(latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))]) / 1000.0; };
+        std::println("[test-input-queue] push->pop latency: p50 {:.2f} us, p99 {:.2f} us, max {:.2f} us", percentile(0.50), percentile(0.99), percentile(1.0));
+    }
+
+    // The reader never observes a half-written snapshot, and snapshots never go backwards.
+    void test_snapshot_buffer() {
+        struct State {
+            std::uint64_t tick{0};
+            std::uint64_t twice{0};
+        };
+        constexpr std::uint64_t publishes = 500'000;
+        vk::plugins::SnapshotBuffer<State> snapshots;
+        std::atomic<bool> done{false};
+        bool consistent = true;
+        bool monotonic  = true;
+
+        std::jthread reader([&] {
+            std::uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const State& state = snapshots.latest();
+                if (state.twice != state.tick * 2) consistent = false;
+                if (state.tick < last) monotonic = false;
+                last = state.tick;
+            }
+        });
+        for (std::uint64_t tick = 1; tick <= publishes; ++tick) snapshots.publish({tick, tick * 2});
+        done.store(true, std::memory_order_release);
+        reader.join();
+
+        check(consistent, "snapshots are never torn");
+        check(monotonic, "snapshots never go backwards");
+        check(snapshots.latest().tick == publishes, "reader ends on the last published snapshot");
+    }
+} // namespace
+
+int main() {
+    test_bounds();
+    test_multi_consumer_throughput();
+    test_latency();
+    test_snapshot_buffer();
+
+    return check.finish();
+}
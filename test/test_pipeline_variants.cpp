@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <unordered_set>
+#include <vulkan/vulkan.h>
+#include "test_check.hpp"
+import vk.plugins.device;
+import vk.plugins.pipeline_variants;
+
+namespace {
+    vk::test::Checks check{"test-pipeline-variants"};
+
+    using vk::plugins::BlendMode;
+    using vk::plugins::PipelineVariantKey;
+    using vk::plugins::VariantDynamicState;
+
+    // Every field away from its default, so a field the collapse forgets shows up as a mismatch.
+    constexpr PipelineVariantKey kWireframe{
+        .topology     = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP,
+        .polygon_mode = VK_POLYGON_MODE_LINE,
+        .cull_mode    = VK_CULL_MODE_BACK_BIT,
+        .front_face   = VK_FRONT_FACE_CLOCKWISE,
+        .blend        = BlendMode::Alpha,
+        .shading      = 2,
+    };
+
+    void test_key() {
+        check(PipelineVariantKey{} == PipelineVariantKey{}, "default keys compare equal");
+        check(!(kWireframe == PipelineVariantKey{}), "keys differing in any field differ");
+
+        std::unordered_set<PipelineVariantKey, vk::plugins::PipelineVariantKeyHash> keys;
+        for (std::uint16_t shading = 0; shading < 3; ++shading) {
+            for (const BlendMode blend : {BlendMode::Opaque, BlendMode::Alpha, BlendMode::Additive}) keys.insert({.blend = blend, .shading = shading});
+        }
+        keys.insert({.blend = BlendMode::Alpha, .shading = 1});
+        check(keys.size() == 9, "the hash map keeps one entry per distinct key");
+    }
+
+    void test_collapse() {
+        // Core 1.3 only: cull mode and front face fold away, topology only within its class.
+        const VariantDynamicState core{};
+        const PipelineVariantKey compiled = vk::plugins::pipeline_key(kWireframe, core);
+        check(compiled.cull_mode == VK_CULL_MODE_NONE && compiled.front_face == VK_FRONT_FACE_COUNTER_CLOCKWISE, "core dynamic state is canonicalized");
+        check(compiled.topology == VK_PRIMITIVE_TOPOLOGY_LINE_LIST, "a strip shares the pipeline of its topology class");
+        check(compiled.polygon_mode == VK_POLYGON_MODE_LINE && compiled.blend == BlendMode::Alpha, "static fields stay in the key");
+        check(compiled.shading == 2, "the specialization constant always stays in the key");
+        check(vk::plugins::pipeline_key({.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN}, core) == PipelineVariantKey{}, "triangle topologies share one pipeline");
+        check(vk::plugins::pipeline_key({.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST}, core).topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST, "points keep their own pipeline");
+
+        // With extended dynamic state 3 only the shading mode is left.
+        const VariantDynamicState full{.topology_unrestricted = true, .polygon_mode = true, .blend = true};
+        check(vk::plugins::pipeline_key(kWireframe, full) == PipelineVariantKey{.shading = 2}, "every dynamic field is canonicalized");
+
+        const VariantDynamicState none{.cull_mode = false, .front_face = false, .topology = false};
+        check(vk::plugins::pipeline_key(kWireframe, none) == kWireframe, "without dynamic state the key is the pipeline key");
+    }
+
+    void test_supported() {
+        using vk::plugins::variant_supported;
+        const vk::plugins::DeviceFeatures core{};
+        const vk::plugins::DeviceFeatures non_solid{.fill_mode_non_solid = true};
+        check(variant_supported({}, core), "the default variant needs no optional feature");
+        check(!variant_supported(kWireframe, core) && variant_supported(kWireframe, non_solid), "line and point fill need fillModeNonSolid");
+        check(!variant_supported({.topology = VK_PRIMITIVE_TOPOLOGY_PATCH_LIST}, non_solid), "patch lists are rejected without tessellation stages");
+
+        // An extension value assigned at runtime is truncated by the 8-bit field; whatever is left is not a core value.
+        PipelineVariantKey truncated{};
+        const VkPolygonMode fill_rectangle = VK_POLYGON_MODE_FILL_RECTANGLE_NV;
+        truncated.polygon_mode             = static_cast<std::uint8_t>(fill_rectangle);
+        check(!variant_supported(truncated, non_solid), "values outside the core enums are rejected");
+        check(!variant_supported({.reserved = 1}, core), "the reserved byte must stay zero");
+    }
+
+    void test_blend() {
+        const auto opaque = vk::plugins::blend_attachment(BlendMode::Opaque);
+        check(opaque.blendEnable == VK_FALSE && opaque.colorWriteMask == 0xf, "opaque writes every channel without blending");
+        const auto alpha = vk::plugins::blend_attachment(BlendMode::Alpha);
+        check(alpha.blendEnable == VK_TRUE && alpha.srcColorBlendFactor == VK_BLEND_FACTOR_SRC_ALPHA && alpha.dstColorBlendFactor == VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, "alpha blending is source-over");
+        const auto additive = vk::plugins::blend_attachment(BlendMode::Additive);
+        check(additive.blendEnable == VK_TRUE && additive.srcColorBlendFactor == VK_BLEND_FACTOR_ONE && additive.dstColorBlendFactor == VK_BLEND_FACTOR_ONE, "additive blending sums");
+    }
+} // namespace
+
+int main() {
+    test_key();
+    test_collapse();
+    test_supported();
+    test_blend();
+
+    return check.finish();
+}
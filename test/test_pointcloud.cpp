@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.pointcloud;
+
+namespace {
+    vk::test::Checks check{"test-pointcloud"};
+
+    constexpr std::array<float, 16> kIdentity{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    // 40^3 grid inside the identity clip volume (x, y in [-0.9, 0.9], z in [0.1, 0.9]); the colour is the point's index.
+    std::vector<vk::plugins::PointVertex> make_grid() {
+        constexpr std::uint32_t side = 40;
+        std::vector<vk::plugins::PointVertex> points;
+        for (std::uint32_t i = 0; i < side * side * side; ++i) {
+            const float x = static_cast<float>(i % side) / (side - 1);
+            const float y = static_cast<float>(i / side % side) / (side - 1);
+            const float z = static_cast<float>(i / (side * side)) / (side - 1);
+            points.push_back({{-0.9f + 1.8f * x, -0.9f + 1.8f * y, 0.1f + 0.8f * z}, i});
+        }
+        return points;
+    }
+
+    void test_round_trip(const std::filesystem::path& path, const std::vector<vk::plugins::PointVertex>& points) {
+        const vk::plugins::PointCloudFile file(path);
+        const auto& header = file.header();
+        check(header.point_count == points.size(), "header counts every point");
+        check(header.chunk_count == file.chunks().size(), "chunk table matches the header");
+        check(header.chunk_capacity <= 1000, "no chunk exceeds the build capacity");
+        check(header.levels > 1, "a dense cloud spans several levels");
+        check(file.chunks()[0].level == 0 && file.chunks()[0].point_count == 1000, "level 0 is one full chunk sampling the whole cloud");
+
+        std::vector<std::uint32_t> seen(points.size(), 0);
+        std::vector<vk::plugins::PointVertex> decoded(header.chunk_capacity);
+        std::uint64_t total       = 0;
+        bool within_tolerance     = true;
+        bool levels_nondecreasing = true;
+        std::uint32_t last_level  = 0;
+        for (std::uint32_t c = 0; c < file.chunks().size(); ++c) {
+            const auto& chunk = file.chunks()[c];
+            levels_nondecreasing &= chunk.level >= last_level;
+            last_level                = chunk.level;
+            const std::uint32_t count = file.decode(c, decoded);
+            total += count;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const auto& p = decoded[i];
+                if (p.color >= points.size()) {
+                    within_tolerance = false;
+                    continue;
+                }
+                ++seen[p.color];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const float step = (chunk.bounds_max[axis] - chunk.bounds_min[axis]) / 65535.0f;
+                    if (std::abs(p.position[axis] - points[p.color].position[axis]) > step + 1e-6f) within_tolerance = false;
+                }
+            }
+        }
+        check(total == points.size(), "chunks hold every point");
+        check(std::ranges::all_of(seen, [](std::uint32_t n) { return n == 1; }), "every point lands in exactly one chunk");
+        check(within_tolerance, "decoded positions are within one quantisation step");
+        check(levels_nondecreasing, "chunks are ordered coarse to fine");
+    }
+
+    void test_malformed(const std::filesystem::path& path) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << "definitely not a point cloud, but long enough to hold a header..........";
+        }
+        bool threw = false;
+        try {
+            const vk::plugins::PointCloudFile file(path);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "a bad magic is rejected");
+    }
+
+    void test_selection(const std::filesystem::path& path) {
+        const vk::plugins::PointCloudFile file(path);
+        std::vector<std::uint32_t> selected;
+
+        std::uint64_t points = vk::plugins::select_chunks(file.chunks(), kIdentity, {.detail = 10.0f}, selected);
+        check(selected.size() == 1 && selected[0] == 0 && points == 1000, "coarse detail keeps only level 0");
+
+        selected.clear();
+        points = vk::plugins::select_chunks(file.chunks(), kIdentity, {.detail = 0.0f}, selected);
+        check(selected.size() == file.chunks().size() && points == file.header().point_count, "zero detail keeps every visible chunk");
+
+        selected.clear();
+        points = vk::plugins::select_chunks(file.chunks(), kIdentity, {.detail = 0.0f, .point_budget = 1500}, selected);
+        check(points <= 1500 && !selected.empty() && selected[0] == 0, "the budget keeps coarse levels first");
+
+        // Moved far to the right of the clip volume.
+        std::array<float, 16> away = kIdentity;
+        away[12]                   = 10.0f;
+        selected.clear();
+        check(vk::plugins::select_chunks(file.chunks(), away, {.detail = 0.0f}, selected) == 0 && selected.empty(), "chunks outside the frustum are skipped");
+
+        const vk::plugins::ChunkRecord unit{.bounds_min = {-1, -1, -1}, .bounds_max = {1, 1, 1}};
+        std::array<float, 16> scaled = kIdentity;
+        scaled[0]                    = 2.0f;
+        check(std::abs(vk::plugins::projected_radius(unit, kIdentity) - std::sqrt(3.0f)) < 1e-5f, "identity projects the radius unchanged");
+        check(std::abs(vk::plugins::projected_radius(unit, scaled) - 2.0f * std::sqrt(3.0f)) < 1e-5f, "projection scale enlarges the radius");
+    }
+
+    void test_residency() {
+        using Cache = vk::plugins::ChunkResidencyCache;
+        Cache cache(2);
+        cache.begin_frame();
+        const auto a = cache.reserve(10);
+        const auto b = cache.reserve(11);
+        check(a.slot != Cache::kNone && b.slot != Cache::kNone && a.slot != b.slot, "free slots are handed out first");
+        check(a.evicted == Cache::kNone && b.evicted == Cache::kNone, "free slots evict nothing");
+        check(cache.reserve(12).slot == Cache::kNone, "slots claimed this frame are pinned");
+        check(cache.touch(10) == Cache::kNone && cache.loading(10), "a loading chunk is not drawable yet");
+        check(cache.mark_resident(10, a.slot) && cache.mark_resident(11, b.slot), "loads complete");
+        check(cache.resident_count() == 2, "both chunks resident");
+
+        cache.begin_frame();
+        check(cache.touch(10) == a.slot, "a resident chunk reports its slot");
+        const auto c = cache.reserve(12);
+        check(c.slot == b.slot && c.evicted == 11, "the least recently used unpinned chunk is evicted");
+        check(cache.resident_count() == 1 && cache.evictions() == 1, "eviction is counted");
+        check(!cache.mark_resident(11, b.slot), "a chunk evicted mid-load cannot complete");
+        check(cache.touch(11) == Cache::kNone && !cache.loading(11), "an evicted chunk is no longer tracked");
+
+        cache.begin_frame();
+        cache.touch(12);
+        const auto d = cache.reserve(13);
+        check(d.slot == a.slot && d.evicted == 10, "recency decides the victim, not insertion order");
+    }
+} // namespace
+
+int main() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "test_pointcloud.vkpc";
+    const auto points                = make_grid();
+    vk::plugins::write_point_cloud(path, points, {.chunk_capacity = 1000, .max_level = 8});
+
+    test_round_trip(path, points);
+    test_selection(path);
+    test_residency();
+    test_malformed(path);
+    std::filesystem::remove(path);
+
+    return check.finish();
+}
@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "test_check.hpp"
+import vk.plugins.render_graph;
+
+namespace {
+    vk::test::Checks check{"test-render-graph"};
+
+    // Recording only: handles are never dereferenced, barriers are captured instead of submitted.
+    template <typename Handle>
+    Handle fake_handle(std::uintptr_t value) {
+        if constexpr (std::is_pointer_v<Handle>) return reinterpret_cast<Handle>(value);
+        else return static_cast<Handle>(value);
+    }
+
+    struct Call {
+        std::vector<VkImageMemoryBarrier2> images;
+        std::vector<VkBufferMemoryBarrier2> buffers;
+    };
+    struct Recorder {
+        std::vector<Call> calls;
+        vk::plugins::RenderGraph graph{[this](VkCommandBuffer, const VkDependencyInfo& dep) {
+            calls.push_back({
+                {dep.pImageMemoryBarriers, dep.pImageMemoryBarriers + dep.imageMemoryBarrierCount},
+                {dep.pBufferMemoryBarriers, dep.pBufferMemoryBarriers + dep.bufferMemoryBarrierCount},
+            });
+        }};
+    };
+
+    const VkCommandBuffer cmd = fake_handle<VkCommandBuffer>(0x10);
+    const VkImage color_image = fake_handle<VkImage>(0x20);
+    const VkImage swapchain   = fake_handle<VkImage>(0x30);
+    const VkBuffer indirect   = fake_handle<VkBuffer>(0x40);
+    const VkBuffer visible    = fake_handle<VkBuffer>(0x50);
+} // namespace
+
+int main() {
+    using namespace vk::plugins;
+
+    // EngineBlit with the UI attached: scene pass, UI pass, hand back. Previously 4 barrier calls.
+    {
+        Recorder rec;
+        for (int frame = 0; frame < 2; ++frame) {
+            const ResourceId scene = rec.graph.import_image(color_image, VK_IMAGE_ASPECT_COLOR_BIT, states::kEngineGeneral, states::kEngineGeneral);
+            rec.graph.use(scene, states::kColorAttachment);
+            rec.graph.flush(cmd);
+            const ResourceId ui = rec.graph.import_image(color_image, VK_IMAGE_ASPECT_COLOR_BIT, states::kEngineGeneral, states::kEngineGeneral);
+            check(ui == scene, "re-importing a tracked image returns the same id");
+            check(rec.graph.state(ui).layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, "re-import keeps the tracked layout");
+            rec.graph.use(ui, states::kColorAttachment);
+            rec.graph.flush(cmd);
+            rec.graph.end_frame(cmd);
+        }
+        check(rec.graph.last_frame_stats().barrier_calls == 3, "scene + UI frame emits three barrier calls");
+        check(rec.graph.last_frame_stats().image_barriers == 3, "scene + UI frame emits three image barriers");
+        check(!rec.graph.frame_open(), "end_frame forgets imported resources");
+        check(rec.calls.size() == 6, "both frames recorded");
+        check(rec.calls[0].images[0].oldLayout == VK_IMAGE_LAYOUT_GENERAL && rec.calls[0].images[0].newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, "scene pass enters COLOR_ATTACHMENT_OPTIMAL");
+        check(rec.calls[1].images[0].oldLayout == rec.calls[1].images[0].newLayout, "UI pass keeps the layout");
+        check(rec.calls[1].images[0].srcStageMask == VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, "UI pass waits on attachment output only");
+        check(rec.calls[2].images[0].newLayout == VK_IMAGE_LAYOUT_GENERAL, "end_frame hands the attachment back in GENERAL");
+    }
+
+    // Culling: the post-dispatch buffer barriers ride along with the scene pass's image transition.
+    {
+        Recorder rec;
+        const ResourceId color = rec.graph.import_image(color_image, VK_IMAGE_ASPECT_COLOR_BIT, states::kEngineGeneral, states::kEngineGeneral);
+        const ResourceId draw  = rec.graph.import_buffer(indirect, 32, 20, states::kUntouched);
+        const ResourceId list  = rec.graph.import_buffer(visible, 0, 4096, states::kUntouched);
+        rec.graph.use(draw, states::kTransferWrite);
+        rec.graph.flush(cmd);
+        check(rec.calls.empty(), "first touch needs no barrier");
+        rec.graph.use(draw, states::kComputeReadWrite);
+        rec.graph.use(list, states::kComputeReadWrite);
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 1 && rec.calls[0].buffers.size() == 1, "clear -> dispatch is one buffer barrier");
+        rec.graph.use(draw, states::kIndirectRead);
+        rec.graph.use(list, states::kVertexStorageRead);
+        rec.graph.use(color, states::kColorAttachment);
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 2, "dispatch -> draw is a single call");
+        check(rec.calls[1].buffers.size() == 2 && rec.calls[1].images.size() == 1, "buffer and image barriers are batched together");
+        check(rec.calls[1].buffers[0].dstStageMask == VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, "indirect buffer waits at DRAW_INDIRECT");
+        rec.graph.end_frame(cmd);
+        check(rec.graph.last_frame_stats().barrier_calls == 3, "culled frame without UI emits three barrier calls");
+        check(rec.calls.back().buffers.empty(), "buffers without a final state are not transitioned at end_frame");
+    }
+
+    // DirectToSwapchain: acquire -> attachment -> present.
+    {
+        Recorder rec;
+        const ResourceId image = rec.graph.import_image(swapchain, VK_IMAGE_ASPECT_COLOR_BIT, states::kAcquired, states::kPresent);
+        rec.graph.use(image, states::kColorAttachment);
+        rec.graph.flush(cmd);
+        rec.graph.end_frame(cmd);
+        check(rec.graph.last_frame_stats().barrier_calls == 2, "swapchain frame emits two barrier calls");
+        check(rec.calls[0].images[0].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED, "acquired image starts UNDEFINED");
+        check(rec.calls[1].images[0].newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR && rec.calls[1].images[0].dstStageMask == VK_PIPELINE_STAGE_2_NONE, "present transition has no destination stage");
+    }
+
+    // Read after read is elided; the following write waits on every reader without a memory dependency.
+    {
+        Recorder rec;
+        const ResourceId buffer = rec.graph.import_buffer(visible, 0, 64, states::kIndirectRead);
+        rec.graph.use(buffer, states::kVertexStorageRead);
+        rec.graph.flush(cmd);
+        check(rec.calls.empty() && rec.graph.frame_stats().elided == 1, "read after read needs no barrier");
+        rec.graph.use(buffer, states::kComputeReadWrite);
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 1, "write after read emits a barrier");
+        check(rec.calls[0].buffers[0].srcStageMask == (VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT), "write waits on both readers");
+        check(rec.calls[0].buffers[0].srcAccessMask == VK_ACCESS_2_NONE, "write after read is execution-only");
+
+        rec.graph.use(buffer, states::kVertexStorageRead);
+        bool threw = false;
+        try {
+            rec.graph.use(buffer, states::kComputeReadWrite);
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        check(threw, "conflicting uses before flush are rejected");
+    }
+
+    // A read at a stage the last write was not made visible to still waits on that write, not on the earlier reader.
+    {
+        Recorder rec;
+        const ResourceId buffer = rec.graph.import_buffer(indirect, 0, 64, states::kUntouched);
+        rec.graph.use(buffer, states::kComputeReadWrite);
+        rec.graph.use(buffer, states::kIndirectRead);
+        check(rec.calls.empty(), "nothing is recorded before flush");
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 1, "dispatch -> indirect read is one barrier");
+        rec.graph.use(buffer, states::kVertexStorageRead);
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 2, "a read the write is not yet visible to emits a barrier");
+        check(rec.calls[1].buffers[0].srcStageMask == VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, "the late read waits on the writer");
+        check(rec.calls[1].buffers[0].srcAccessMask == VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, "the late read makes the write available");
+        rec.graph.use(buffer, states::kIndirectRead);
+        rec.graph.use(buffer, states::kVertexStorageRead);
+        rec.graph.flush(cmd);
+        check(rec.calls.size() == 2, "reads the write is already visible to are elided");
+        rec.graph.use(buffer, states::kComputeReadWrite);
+        rec.graph.flush(cmd);
+        check(rec.calls[2].buffers[0].srcStageMask == (VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT), "the next write waits on every reader since the last write");
+    }
+
+    return check.finish();
+}
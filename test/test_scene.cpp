@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <print>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.culling;
+import vk.plugins.scene;
+import vk.plugins.thread_pool;
+
+// Checks every SIMD kernel against the scalar one. Run with --benchmark [max_instances] for a throughput table in
+// Google Benchmark's layout, scalar against the best SIMD level, from 10k up to 10M instances.
+namespace {
+    vk::test::Checks check{"test-scene"};
+
+    using vk::plugins::SimdLevel;
+
+    // Perspective looking down +z from the origin: 90 degree fov, near 0.1, far 100, Vulkan clip space.
+    constexpr std::array<float, 16> kViewProj{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 100.0f / 99.9f, 1, 0, 0, -10.0f / 99.9f, 0};
+    constexpr vk::plugins::Affine kParent{0, 0, 1, 2, 0, 1, 0, -1, -1, 0, 0, 30}; // quarter turn about y, then a shift
+
+    void fill(vk::plugins::SceneInstances& scene, std::size_t count, std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> spread(-60.0f, 60.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> size(0.1f, 2.0f);
+        scene.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            vk::plugins::SceneInstance instance{.color = i};
+            for (std::size_t r = 0; r < 3; ++r) {
+                for (std::size_t c = 0; c < 3; ++c) instance.local[r * 4 + c] = unit(rng);
+                instance.local[r * 4 + 3] = spread(rng);
+                instance.center[r]        = unit(rng);
+                instance.extent[r]        = size(rng);
+            }
+            scene.set(i, instance);
+        }
+    }
+
+    void run_all(vk::plugins::SceneInstances& scene, SimdLevel level, std::size_t begin, std::size_t end) {
+        scene.transform(level, kParent, begin, end);
+        scene.compute_bounds(level, begin, end);
+        scene.cull(level, vk::plugins::extract_frustum(kViewProj), begin, end);
+        scene.depth_keys(level, kViewProj, begin, end);
+    }
+
+    bool same_results(const vk::plugins::SceneInstances& a, const vk::plugins::SceneInstances& b) {
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (a.world(i) != b.world(i) || a.world_center(i) != b.world_center(i) || a.world_extent(i) != b.world_extent(i)) return false;
+            if (a.visible(i) != b.visible(i) || a.depth_key(i) != b.depth_key(i)) return false;
+        }
+        return true;
+    }
+
+    void test_sort_key() {
+        const std::array<float, 7> depths{-1e9f, -2.5f, -0.0f, 0.0f, 1e-30f, 0.5f, 3e8f};
+        bool ordered = true;
+        for (std::size_t i = 1; i < depths.size(); ++i) ordered &= vk::plugins::depth_sort_key(depths[i - 1]) <= vk::plugins::depth_sort_key(depths[i]);
+        check(ordered, "sort keys follow float order across the sign");
+        check(vk::plugins::depth_sort_key(-1.0f) < vk::plugins::depth_sort_key(1.0f), "negative depths sort first");
+    }
+
+    void test_kernels() {
+        // Odd count so every SIMD kernel also runs its scalar tail.
+        vk::plugins::SceneInstances scalar;
+        vk::plugins::SceneInstances simd;
+        fill(scalar, 1003, 7);
+        fill(simd, 1003, 7);
+        run_all(scalar, SimdLevel::Scalar, 0, scalar.size());
+        run_all(simd, vk::plugins::best_simd_level(), 0, simd.size());
+        check(same_results(scalar, simd), "SIMD kernels match the scalar ones exactly");
+
+        std::size_t visible = 0;
+        for (std::size_t i = 0; i < scalar.size(); ++i) visible += scalar.visible(i) ? 1 : 0;
+        check(visible > 0 && visible < scalar.size(), "the test scene is partly inside the frustum");
+
+        // Split ranges, including ones not starting on a vector boundary, give the same answer as one pass.
+        vk::plugins::SceneInstances split;
+        fill(split, 1003, 7);
+        for (std::size_t begin = 0; begin < split.size(); begin += 37) run_all(split, vk::plugins::best_simd_level(), begin, std::min<std::size_t>(begin + 37, split.size()));
+        check(same_results(scalar, split), "kernels are independent of range boundaries");
+    }
+
+    void test_geometry() {
+        vk::plugins::SceneInstances scene;
+        scene.add({.local = {2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 5}, .center = {1, 0, 0}, .extent = {1, 1, 1}});
+        scene.add({.local = {0, -1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 200}}); // beyond the far plane
+        scene.add({.local = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 2}});
+        for (const SimdLevel level : {SimdLevel::Scalar, vk::plugins::best_simd_level()}) {
+            scene.prepare(vk::plugins::kIdentityAffine, kViewProj, level);
+            check(scene.world_center(0) == std::array<float, 3>{2, 0, 5}, "the centre is transformed with the translation");
+            check(scene.world_extent(0) == std::array<float, 3>{2, 1, 1}, "the extent is scaled by the absolute matrix");
+            check(scene.world_extent(1) == std::array<float, 3>{0.5f, 0.5f, 0.5f}, "rotation keeps an axis-aligned cube's extent");
+            check(scene.visible(0) && !scene.visible(1) && scene.visible(2), "boxes past the far plane are culled");
+
+            std::vector<std::uint32_t> order;
+            check(scene.sorted_visible(order) == 2 && order == std::vector<std::uint32_t>{2, 0}, "visible instances come nearest first");
+        }
+    }
+
+    void test_parallel() {
+        vk::plugins::ThreadPool pool(3);
+        std::vector<std::atomic<int>> hits(100'003);
+        pool.parallel_for(hits.size(), 1000, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) hits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+        check(std::ranges::all_of(hits, [](const std::atomic<int>& n) { return n.load() == 1; }), "parallel_for covers every index once");
+
+        // Counts where the rounded-up step leaves fewer ranges than chunks: 5 and 9 items over 4 chunks run as 3 ranges.
+        for (const std::size_t small : {std::size_t{5}, std::size_t{9}}) {
+            std::vector<std::atomic<int>> few(small);
+            pool.parallel_for(few.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) few[i].fetch_add(1, std::memory_order_relaxed);
+            });
+            check(std::ranges::all_of(few, [](const std::atomic<int>& n) { return n.load() == 1; }), "parallel_for over a few items returns and covers each once");
+        }
+
+        bool threw = false;
+        try {
+            pool.parallel_for(10, 1, [](std::size_t, std::size_t end) {
+                if (end == 10) throw std::runtime_error("last range failed");
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "parallel_for rethrows a range's exception");
+
+        vk::plugins::SceneInstances serial;
+        vk::plugins::SceneInstances threaded;
+        const std::size_t count = 3 * vk::plugins::SceneInstances::kPrepareGrain + 5;
+        fill(serial, count, 11);
+        fill(threaded, count, 11);
+        serial.prepare(kParent, kViewProj, SimdLevel::Scalar);
+        threaded.prepare(kParent, kViewProj, vk::plugins::best_simd_level(), &pool);
+        check(same_results(serial, threaded), "threaded SIMD preparation matches the serial scalar one");
+        check(threaded.stats().instances == count, "stats count every instance");
+    }
+
+    // Repeats `fn` until it has run for at least 0.2 s and reports the mean, like a Google Benchmark fixture.
+    void bench(std::string_view name, SimdLevel level, std::size_t count, const std::function<void()>& fn) {
+        using clock        = std::chrono::steady_clock;
+        std::uint64_t runs = 0;
+        const auto start   = clock::now();
+        auto elapsed       = clock::duration{};
+        while (elapsed < std::chrono::milliseconds(200)) {
+            fn();
+            ++runs;
+            elapsed = clock::now() - start;
+        }
+        const double ns         = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(runs);
+        const double items      = static_cast<double>(count) / (ns * 1e-9);
+        const std::string label = std::format("BM_{}/{}/{}", name, vk::plugins::simd_level_name(level), count);
+        std::println("{:<32} {:>14.0f} ns {:>10} {:>10.1f}M items/s", label, ns, runs, items * 1e-6);
+    }
+
+    void run_benchmarks(std::size_t max_instances) {
+        vk::plugins::ThreadPool pool;
+        const vk::plugins::Frustum frustum = vk::plugins::extract_frustum(kViewProj);
+        std::println("{:<32} {:>17} {:>10} {:>21}", "Benchmark", "Time", "Iterations", "Throughput");
+        for (std::size_t count = 10'000; count <= max_instances; count *= 10) {
+            vk::plugins::SceneInstances scene;
+            fill(scene, count, 3);
+            for (const SimdLevel level : {SimdLevel::Scalar, vk::plugins::best_simd_level()}) {
+                bench("transform", level, count, [&] { scene.transform(level, kParent, 0, count); });
+                bench("bounds", level, count, [&] { scene.compute_bounds(level, 0, count); });
+                bench("cull", level, count, [&] { scene.cull(level, frustum, 0, count); });
+                bench("depth_keys", level, count, [&] { scene.depth_keys(level, kViewProj, 0, count); });
+                bench("prepare", level, count, [&] { scene.prepare(kParent, kViewProj, level); });
+                bench("prepare_mt", level, count, [&] { scene.prepare(kParent, kViewProj, level, &pool); });
+                if (level == vk::plugins::best_simd_level()) break;
+            }
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        run_benchmarks(argc > 2 ? std::stoull(argv[2]) : 10'000'000);
+        return 0;
+    }
+
+    std::println("[test-scene] kernels: {}", vk::plugins::simd_level_name(vk::plugins::best_simd_level()));
+    test_sort_key();
+    test_kernels();
+    test_geometry();
+    test_parallel();
+
+    return check.finish();
+}
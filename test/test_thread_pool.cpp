@@ -0,0 +1,64 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "test_check.hpp"
+import vk.plugins.thread_pool;
+
+namespace {
+    vk::test::Checks check{"test-thread-pool"};
+
+    void test_submit() {
+        vk::plugins::ThreadPool pool(3);
+        check(pool.worker_count() == 3, "an explicit worker count is honoured");
+
+        std::vector<std::atomic<int>> per_worker(pool.worker_count());
+        std::atomic<bool> in_range{true};
+        for (int i = 0; i < 64; ++i) {
+            pool.submit([&](std::uint32_t worker) {
+                if (worker >= per_worker.size()) in_range = false;
+                else per_worker[worker].fetch_add(1);
+            });
+        }
+        pool.wait_idle();
+        int total = 0;
+        for (const auto& n : per_worker) total += n.load();
+        check(in_range.load(), "tasks receive the index of a worker of this pool");
+        check(total == 64 && pool.pending() == 0, "wait_idle returns once every task ran");
+
+        const vk::plugins::ThreadPool defaulted;
+        check(defaulted.worker_count() >= 1, "the default worker count leaves at least one worker");
+    }
+
+    void test_task_exception() {
+        vk::plugins::ThreadPool pool(2);
+        bool threw = false;
+        pool.submit([](std::uint32_t) { throw std::runtime_error("task failed"); });
+        try {
+            pool.wait_idle();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "wait_idle rethrows a submitted task's exception");
+
+        std::atomic<int> after{0};
+        pool.submit([&](std::uint32_t) { after.fetch_add(1); });
+        pool.wait_idle();
+        check(after.load() == 1, "workers keep running after a task threw");
+
+        threw = false;
+        try {
+            pool.wait_idle();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(!threw, "an exception is rethrown only once");
+    }
+} // namespace
+
+int main() {
+    test_submit();
+    test_task_exception();
+
+    return check.finish();
+}
@@ -0,0 +1,87 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "test_check.hpp"
+import vk.plugins.upload;
+
+namespace {
+    vk::test::Checks check{"test-upload"};
+
+    void test_bump_allocation() {
+        vk::plugins::LinearAllocator region(256);
+        check(region.allocate(12, 4) == 0, "first allocation starts the region");
+        check(region.allocate(64, 16) == 16, "offsets are aligned up");
+        check(region.used() == 80, "head advances past the last allocation");
+        check(region.allocate(8, 0) == 80, "zero alignment means none");
+        check(region.allocate(1, 1) == 88, "byte alignment packs tightly");
+    }
+
+    void test_exhaustion() {
+        vk::plugins::LinearAllocator region(128);
+        check(region.allocate(128, 16) == 0, "an allocation may fill the region exactly");
+        check(!region.allocate(1, 1), "a full region refuses further allocations");
+
+        region.reset(128);
+        check(region.allocate(100, 1) == 0, "reset rewinds the head");
+        check(!region.allocate(16, 64), "alignment padding counts against the capacity");
+        check(region.used() == 100, "a failed allocation leaves the head alone");
+        check(region.allocate(28, 1) == 100, "the remainder is still usable");
+    }
+
+    void test_resize() {
+        vk::plugins::LinearAllocator region;
+        check(!region.allocate(1, 1), "an empty region holds nothing");
+        region.reset(512);
+        check(region.capacity() == 512 && region.allocate(512, 256) == 0, "reset adopts the new capacity");
+    }
+
+    void test_slot_regions() {
+        vk::plugins::UploadRegions regions;
+        regions.reset(1024);
+        check(!regions.begin_frame(0), "a frame that fits does not grow the ring");
+        check(regions.allocate(100, 16) == 0 && regions.allocate(100, 16) == 112, "slot 0 allocates from the start of the ring");
+        check(!regions.begin_frame(1), "no overflow, no growth");
+        check(regions.allocate(10, 1) == 1024, "slot 1 allocates from its own region");
+        check(!regions.begin_frame(0), "slot 0 comes round again");
+        check(regions.used() == 0 && regions.allocate(8, 8) == 0, "its region is rewound");
+    }
+
+    void test_overflow_growth() {
+        vk::plugins::UploadRegions regions;
+        regions.reset(256);
+        check(!regions.begin_frame(0), "the first frame starts on the initial ring");
+        check(regions.allocate(200, 1) == 0, "the region serves what fits");
+        check(!regions.allocate(100, 16), "an allocation past the region overflows");
+        check(!regions.allocate(300, 16), "larger than a whole region overflows too");
+        check(regions.allocate(40, 1) == 200, "a later allocation that fits still uses the region");
+
+        // 240 in the region plus 116 + 316 worst-case overflow, aligned to 256, is 768; the ring grows to 1024.
+        check(regions.begin_frame(1), "a frame after an overflow grows the ring");
+        check(regions.region_size() == 1024, "growth covers the whole frame's demand, rounded up to a power of two");
+        check(regions.allocate(1000, 1) == 1024, "the grown region holds the overflowing frame in the new slot's region");
+        check(!regions.begin_frame(0), "a frame that fits the grown ring does not grow it again");
+        check(regions.region_size() == 1024, "the ring never shrinks");
+    }
+
+    void test_slot_retirement() {
+        vk::plugins::SlotRetirement<int> retired;
+        retired.retire(0, 1);
+        retired.retire(0, 2);
+        retired.retire(1, 3);
+        check(retired.pending(0) == 2 && retired.pending(1) == 1, "objects park in the slot they were retired in");
+        check(retired.release(0) == std::vector<int>{1, 2}, "a slot coming round releases everything parked there");
+        check(retired.pending(0) == 0 && retired.release(0).empty(), "a released slot is empty");
+        check(retired.pending(1) == 1, "other slots keep their objects until their turn");
+        check(retired.release(1) == std::vector<int>{3}, "each slot releases its own objects");
+    }
+} // namespace
+
+int main() {
+    test_bump_allocation();
+    test_exhaustion();
+    test_resize();
+    test_slot_regions();
+    test_overflow_growth();
+    test_slot_retirement();
+
+    return check.finish();
+}
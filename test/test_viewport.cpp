@@ -6,6 +6,8 @@ int main() {
     vk::plugins::ViewportRenderer renderer;
     vk::plugins::ViewportUI ui_system;
     vk::plugins::ViewpoertPlugin plugin;
+    ui_system.attach(renderer);
+    ui_system.attach(plugin);
 
     engine.init(renderer, ui_system, plugin);
     engine.run(renderer, ui_system, plugin);
@@ -0,0 +1,22 @@
+import vk.context;
+import vk.engine;
+import vk.plugins.viewport;
+
+// test_viewport with the optional modes on: the scene and UI share one dynamic-rendering instance, and the UI replays
+// its recorded command buffers while nothing changes.
+int main() {
+    vk::engine::VulkanEngine engine;
+    vk::plugins::ViewportRenderer renderer;
+    vk::plugins::ViewportUI ui_system;
+    vk::plugins::ViewpoertPlugin plugin;
+    ui_system.attach(renderer);
+    ui_system.attach(plugin);
+    ui_system.set_incremental(true);
+    renderer.set_pass_merging(vk::context::PresentationMode::EngineBlit, true);
+
+    engine.init(renderer, ui_system, plugin);
+    engine.run(renderer, ui_system, plugin);
+    engine.cleanup();
+
+    return 0;
+}